@@ -0,0 +1,290 @@
+/*
+ * End-to-end benchmarks of two sessions talking to each other
+ * over an in-memory pipe and a pseudo terminal.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "textalk.h"
+#include "textalk_serial.h"
+#include "bench_util.h"
+
+#define MEMPIPE_SIZE 65536
+
+static const size_t text_sizes[] = { 16, 256, 1000 };
+
+/*
+ * One direction of an in-memory pipe.
+ */
+typedef struct mempipe_t
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    char            buf[MEMPIPE_SIZE];
+    size_t          head;
+    size_t          size;
+} mempipe_t;
+
+/*
+ * An end point of a link.
+ */
+typedef struct link_end_t
+{
+    mempipe_t        *tx;
+    mempipe_t        *rx;
+    textalk_serial_t  serial;
+} link_end_t;
+
+typedef struct peer_arg_t
+{
+    textalk_events_t events;
+    size_t           count;
+} peer_arg_t;
+
+//------------------------------------------------------------------------------
+static
+void mempipe_init(mempipe_t *self)
+{
+    pthread_mutex_init(&self->lock, NULL);
+    pthread_cond_init(&self->cond, NULL);
+    self->head = 0;
+    self->size = 0;
+}
+//------------------------------------------------------------------------------
+static
+void mempipe_deinit(mempipe_t *self)
+{
+    pthread_cond_destroy(&self->cond);
+    pthread_mutex_destroy(&self->lock);
+}
+//------------------------------------------------------------------------------
+static
+int mempipe_sender(void *userarg, const void *data, size_t size)
+{
+    mempipe_t *pipe = ((link_end_t*) userarg)->tx;
+
+    pthread_mutex_lock(&pipe->lock);
+
+    size_t room = MEMPIPE_SIZE - pipe->size;
+    if( size > room ) size = room;
+    for(size_t i = 0; i < size; ++i)
+        pipe->buf[ ( pipe->head + pipe->size + i ) % MEMPIPE_SIZE ] = ((const char*) data)[i];
+    pipe->size += size;
+
+    pthread_cond_broadcast(&pipe->cond);
+    pthread_mutex_unlock(&pipe->lock);
+
+    return size;
+}
+//------------------------------------------------------------------------------
+static
+int mempipe_recver(void *userarg, void *buf, size_t size)
+{
+    mempipe_t *pipe = ((link_end_t*) userarg)->rx;
+
+    pthread_mutex_lock(&pipe->lock);
+
+    if( size > pipe->size ) size = pipe->size;
+    for(size_t i = 0; i < size; ++i)
+        ((char*) buf)[i] = pipe->buf[ ( pipe->head + i ) % MEMPIPE_SIZE ];
+    pipe->head  = ( pipe->head + size ) % MEMPIPE_SIZE;
+    pipe->size -= size;
+
+    pthread_cond_broadcast(&pipe->cond);
+    pthread_mutex_unlock(&pipe->lock);
+
+    return size;
+}
+//------------------------------------------------------------------------------
+static
+int mempipe_waiter(void *userarg, int flags, unsigned timeout)
+{
+    link_end_t *end  = userarg;
+    mempipe_t  *pipe = ( flags & TEXTALK_WAIT_RECV )?( end->rx ):( end->tx );
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec  += timeout / 1000;
+    deadline.tv_nsec += ( timeout % 1000 ) * 1000000;
+    if( deadline.tv_nsec >= 1000000000 )
+    {
+        deadline.tv_sec  += 1;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&pipe->lock);
+
+    int res = 0;
+    while( !res )
+    {
+        bool ready = ( flags & TEXTALK_WAIT_RECV )?( pipe->size ):( pipe->size < MEMPIPE_SIZE );
+        if( ready )
+            res = 1;
+        else if( pthread_cond_timedwait(&pipe->cond, &pipe->lock, &deadline) == ETIMEDOUT )
+            break;
+    }
+
+    pthread_mutex_unlock(&pipe->lock);
+    return res;
+}
+//------------------------------------------------------------------------------
+static
+void* peer_main(void *userarg)
+{
+    // Receive texts until the count reached.
+    peer_arg_t *arg = userarg;
+
+    textalk_t talk;
+    textalk_init(&talk, NULL, &arg->events);
+
+    char   buf[TEXTALK_PKT_MAX_SIZE];
+    size_t got = 0;
+    while( got < arg->count )
+    {
+        size_t len;
+        int    errcode = textalk_wait_data(&talk, buf, sizeof(buf), &len);
+        if( errcode == TEXTALK_ERR_SUCCESS || errcode == TEXTALK_ERR_HAVE_MORE )
+            ++got;
+        else if( errcode != TEXTALK_ERR_TIMEOUT )
+            break;
+    }
+
+    textalk_deinit(&talk);
+    return NULL;
+}
+//------------------------------------------------------------------------------
+static
+int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t*) a, y = *(const uint64_t*) b;
+    return ( x > y ) - ( x < y );
+}
+//------------------------------------------------------------------------------
+static
+double percentile_us(const uint64_t *sorted, size_t count, unsigned percent)
+{
+    size_t index = ( count * percent + 99 ) / 100;
+    index = index ? index - 1 : 0;
+    return sorted[index] / 1e3;
+}
+//------------------------------------------------------------------------------
+static
+void run_case(bench_json_t           *json,
+              const char             *transport,
+              const textalk_events_t *local,
+              const textalk_events_t *remote,
+              size_t                  textlen,
+              size_t                  count)
+{
+    peer_arg_t arg = { *remote, count };
+    pthread_t  thread;
+    if( pthread_create(&thread, NULL, peer_main, &arg) ) return;
+
+    textalk_t talk;
+    textalk_init(&talk, NULL, local);
+
+    char *text = malloc(textlen);
+    for(size_t i = 0; i < textlen; ++i)
+        text[i] = 0x20 + i % 0x5F;
+
+    uint64_t *latency = malloc(count * sizeof(latency[0]));
+    size_t    sent    = 0;
+    size_t    failed  = 0;
+
+    uint64_t start = bench_now_ns();
+    for(size_t i = 0; i < count; ++i)
+    {
+        // Time of a text be sent and its ACK received.
+        uint64_t begin = bench_now_ns();
+        if( textalk_send_data(&talk, text, textlen, false) )
+            ++failed;
+        else
+            latency[sent++] = bench_now_ns() - begin;
+    }
+    uint64_t spent = bench_now_ns() - start;
+
+    pthread_join(thread, NULL);
+    textalk_deinit(&talk);
+
+    qsort(latency, sent, sizeof(latency[0]), compare_u64);
+
+    bench_json_begin_result(json, "send_data");
+    bench_json_str(json, "transport", transport);
+    bench_json_int(json, "text_size", textlen);
+    bench_json_int(json, "frames", sent);
+    bench_json_int(json, "failed", failed);
+    bench_json_num(json, "frames_per_s", sent * 1e9 / spent);
+    bench_json_num(json, "bytes_per_s", sent * textlen * 1e9 / spent);
+    if( sent )
+    {
+        bench_json_num(json, "ack_p50_us", percentile_us(latency, sent, 50));
+        bench_json_num(json, "ack_p90_us", percentile_us(latency, sent, 90));
+        bench_json_num(json, "ack_p99_us", percentile_us(latency, sent, 99));
+        bench_json_num(json, "ack_max_us", latency[sent-1] / 1e3);
+    }
+    bench_json_end_result(json);
+
+    free(latency);
+    free(text);
+}
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    size_t count = ( argc > 1 )?( strtoul(argv[1], NULL, 10) ):( 20000 );
+    if( !count ) count = 1;
+
+    bench_json_t json;
+    bench_json_begin(&json, stdout, "e2e");
+
+    // In-memory pipe.
+    {
+        mempipe_t  pipes[2];
+        link_end_t ends[2] = { { &pipes[0], &pipes[1] }, { &pipes[1], &pipes[0] } };
+        mempipe_init(&pipes[0]);
+        mempipe_init(&pipes[1]);
+
+        textalk_events_t events[2];
+        for(int i = 0; i < 2; ++i)
+        {
+            memset(&events[i], 0, sizeof(events[i]));
+            events[i].userarg = &ends[i];
+            events[i].sender  = mempipe_sender;
+            events[i].recver  = mempipe_recver;
+            events[i].waiter  = mempipe_waiter;
+        }
+
+        for(size_t s = 0; s < sizeof(text_sizes)/sizeof(text_sizes[0]); ++s)
+            run_case(&json, "mempipe", &events[0], &events[1], text_sizes[s], count);
+
+        mempipe_deinit(&pipes[0]);
+        mempipe_deinit(&pipes[1]);
+    }
+
+    // Pseudo terminal.
+    {
+        link_end_t ends[2];
+        textalk_serial_init(&ends[0].serial);
+        textalk_serial_init(&ends[1].serial);
+
+        if( !textalk_serial_open_loopback(&ends[0].serial, &ends[1].serial) )
+        {
+            textalk_events_t events[2];
+            for(int i = 0; i < 2; ++i)
+            {
+                memset(&events[i], 0, sizeof(events[i]));
+                textalk_serial_fill_events(&ends[i].serial, &events[i]);
+            }
+
+            for(size_t s = 0; s < sizeof(text_sizes)/sizeof(text_sizes[0]); ++s)
+                run_case(&json, "pty", &events[0], &events[1], text_sizes[s], count);
+        }
+
+        textalk_serial_deinit(&ends[0].serial);
+        textalk_serial_deinit(&ends[1].serial);
+    }
+
+    bench_json_end(&json);
+    return 0;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,156 @@
+/*
+ * Microbenchmarks of the packet encoder, decoder, and parity routines.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "parity.h"
+#include "textalk_packet.h"
+#include "bench_util.h"
+
+static const size_t frame_sizes[] = { 16, 64, 256, 1024 };
+static const int    parities[]    = { TEXTALK_PARITY_NONE, TEXTALK_PARITY_ODD, TEXTALK_PARITY_EVEN };
+
+static volatile size_t bench_sink;  // Keep results from being optimised away.
+
+typedef struct micro_case_t
+{
+    textalk_conf_t conf;
+    char   text[TEXTALK_PKT_MAX_SIZE];
+    size_t textlen;
+    char   pkt[TEXTALK_PKT_MAX_SIZE];
+    size_t pktsz;
+    char   buf[TEXTALK_PKT_MAX_SIZE];
+} micro_case_t;
+
+typedef size_t(*micro_func_t)(micro_case_t *c);
+
+//------------------------------------------------------------------------------
+static
+size_t run_packet_build(micro_case_t *c)
+{
+    return textalk_packet_build(c->buf, sizeof(c->buf), c->text, &c->conf, false);
+}
+//------------------------------------------------------------------------------
+static
+size_t run_packet_check_all(micro_case_t *c)
+{
+    return textalk_packet_check_all(c->pkt, c->pktsz, &c->conf);
+}
+//------------------------------------------------------------------------------
+static
+size_t run_packet_get_text(micro_case_t *c)
+{
+    return textalk_packet_get_text(c->buf, sizeof(c->buf), c->pkt, c->pktsz, &c->conf);
+}
+//------------------------------------------------------------------------------
+static
+size_t run_parity_add(micro_case_t *c)
+{
+    parity_arr_add(c->buf, c->textlen, c->conf.comm.parity);
+    return c->buf[0];
+}
+//------------------------------------------------------------------------------
+static
+size_t run_parity_check(micro_case_t *c)
+{
+    return parity_arr_check(c->buf, c->textlen, c->conf.comm.parity);
+}
+//------------------------------------------------------------------------------
+static
+size_t run_parity_copy_add(micro_case_t *c)
+{
+    return parity_arr_copy_add(c->buf, c->text, c->textlen, c->conf.comm.parity);
+}
+//------------------------------------------------------------------------------
+static
+size_t run_parity_copy_remove(micro_case_t *c)
+{
+    bool ok;
+    return parity_arr_copy_remove(c->buf, c->pkt + 1, c->textlen, c->conf.comm.parity, &ok) + ok;
+}
+//------------------------------------------------------------------------------
+static
+void setup_case(micro_case_t *c, size_t framesz, int parity, bool have_lrc)
+{
+    c->conf = *textalk_conf_get_defaults();
+    c->conf.comm.parity   = parity;
+    c->conf.comm.have_lrc = have_lrc;
+
+    // Printable text that fills the frame.
+    c->textlen = framesz - ( have_lrc ? 3 : 2 );
+    for(size_t i = 0; i < c->textlen; ++i)
+        c->text[i] = 0x20 + i % 0x5F;
+    c->text[c->textlen] = 0;
+
+    c->pktsz = textalk_packet_build(c->pkt, sizeof(c->pkt), c->text, &c->conf, false);
+
+    // Data with parity for the check routines.
+    memcpy(c->buf, c->pkt + 1, c->textlen);
+}
+//------------------------------------------------------------------------------
+static
+void run_case(bench_json_t *json, const char *name, micro_func_t func, micro_case_t *c, size_t framesz)
+{
+    // Run in batches until the minimum time reached.
+    uint64_t iters = 0;
+    uint64_t batch = 64;
+    uint64_t start = bench_now_ns();
+    uint64_t spent = 0;
+    while( spent < BENCH_MIN_TIME_NS )
+    {
+        for(uint64_t i = 0; i < batch; ++i)
+            bench_sink += func(c);
+
+        iters += batch;
+        batch *= 2;
+        spent  = bench_now_ns() - start;
+    }
+
+    double ns_per_op = (double) spent / iters;
+
+    bench_json_begin_result(json, name);
+    bench_json_int(json, "frame_size", framesz);
+    bench_json_str(json, "parity", bench_parity_name(c->conf.comm.parity));
+    bench_json_bool(json, "lrc", c->conf.comm.have_lrc);
+    bench_json_int(json, "iterations", iters);
+    bench_json_num(json, "ns_per_op", ns_per_op);
+    bench_json_num(json, "mb_per_s", framesz * 1e3 / ns_per_op);
+    bench_json_end_result(json);
+}
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    micro_case_t *c = malloc(sizeof(*c));
+    if( !c ) return 1;
+
+    bench_json_t json;
+    bench_json_begin(&json, stdout, "micro");
+
+    for(size_t s = 0; s < sizeof(frame_sizes)/sizeof(frame_sizes[0]); ++s)
+    for(size_t p = 0; p < sizeof(parities)/sizeof(parities[0]); ++p)
+    for(int lrc = 1; lrc >= 0; --lrc)
+    {
+        size_t framesz = frame_sizes[s];
+        int    parity  = parities[p];
+
+        setup_case(c, framesz, parity, lrc);
+        run_case(&json, "packet_build", run_packet_build, c, framesz);
+        run_case(&json, "packet_check_all", run_packet_check_all, c, framesz);
+        run_case(&json, "packet_get_text", run_packet_get_text, c, framesz);
+
+        // Parity routines do not depend on LRC.
+        if( !lrc || parity == TEXTALK_PARITY_NONE ) continue;
+
+        run_case(&json, "parity_arr_add", run_parity_add, c, framesz);
+        setup_case(c, framesz, parity, lrc);
+        run_case(&json, "parity_arr_check", run_parity_check, c, framesz);
+        run_case(&json, "parity_arr_copy_add", run_parity_copy_add, c, framesz);
+        run_case(&json, "parity_arr_copy_remove", run_parity_copy_remove, c, framesz);
+    }
+
+    bench_json_end(&json);
+    free(c);
+
+    return 0;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,94 @@
+/*
+ * Common utility of benchmarks.
+ */
+#ifndef _BENCH_UTIL_H_
+#define _BENCH_UTIL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_MIN_TIME_NS 50000000ull   // The minimum time to run each case.
+
+static inline
+uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static inline
+const char* bench_parity_name(int parity)
+{
+    switch( parity )
+    {
+    case 1:  return "odd";
+    case 2:  return "even";
+    default: return "none";
+    }
+}
+
+/*
+ * JSON writer of an array of result objects.
+ */
+typedef struct bench_json_t
+{
+    FILE *file;
+    bool  first;
+} bench_json_t;
+
+static inline
+void bench_json_begin(bench_json_t *self, FILE *file, const char *suite)
+{
+    self->file  = file;
+    self->first = true;
+    fprintf(file, "{\n  \"suite\": \"%s\",\n  \"results\": [", suite);
+}
+
+static inline
+void bench_json_end(bench_json_t *self)
+{
+    fprintf(self->file, "\n  ]\n}\n");
+    fflush(self->file);
+}
+
+static inline
+void bench_json_begin_result(bench_json_t *self, const char *name)
+{
+    fprintf(self->file, "%s\n    { \"name\": \"%s\"", self->first ? "" : ",", name);
+    self->first = false;
+}
+
+static inline
+void bench_json_end_result(bench_json_t *self)
+{
+    fprintf(self->file, " }");
+}
+
+static inline
+void bench_json_str(bench_json_t *self, const char *key, const char *value)
+{
+    fprintf(self->file, ", \"%s\": \"%s\"", key, value);
+}
+
+static inline
+void bench_json_int(bench_json_t *self, const char *key, long long value)
+{
+    fprintf(self->file, ", \"%s\": %lld", key, value);
+}
+
+static inline
+void bench_json_bool(bench_json_t *self, const char *key, bool value)
+{
+    fprintf(self->file, ", \"%s\": %s", key, value ? "true" : "false");
+}
+
+static inline
+void bench_json_num(bench_json_t *self, const char *key, double value)
+{
+    fprintf(self->file, ", \"%s\": %.3f", key, value);
+}
+
+#endif
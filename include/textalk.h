@@ -12,17 +12,41 @@
 
 #ifdef __cplusplus
 #include <string>
+#if __cplusplus >= 201703L
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#if __cplusplus > 201703L && __has_include(<span>)
+#include <span>
+#endif
+#endif
 #endif
 
 #include "textalk_conf.h"
+#include "textalk_alloc.h"
+#include "textalk_rtt.h"
+#include "textalk_stats.h"
+#include "textalk_trace.h"
 #include "textalk_event.h"
 #include "textalk_errcode.h"
+#include "textalk_engine.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#define TEXTALK_PKT_MAX_SIZE 1024  // The maximum size of the packet buffer.
+/**
+ * @brief   Event on a block of message received.
+ * @details The callback function that will be called by textalk_recv_message_stream
+ *          when each block of a message be received.
+ *
+ * @param userarg  The user defined argument.
+ * @param data     The block data, and it is null-terminated.
+ * @param size     Size of the block data.
+ * @param havemore There have more blocks to receive or not.
+ * @return ZERO to continue; or an error code to abort the receiving.
+ */
+typedef int(*textalk_on_recv_chunk_t)(void *userarg, const char *data, size_t size, bool havemore);
 
 /**
  * @class textalk_t
@@ -30,19 +54,45 @@ extern "C" {
  */
 typedef struct textalk_t
 {
-    textalk_conf_t   conf;
-    textalk_events_t events;
+    textalk_conf_t      conf;
+    textalk_events_t    events;
+    textalk_allocator_t alloc;
+
+    char   *rxbuf;      // Receive ring buffer.
+    size_t  rxbufsz;    // Size of the receive buffer.
+    size_t  rxhead;     // Read position of the receive buffer.
+    size_t  rxsize;     // Data size in the receive buffer.
+
+    textalk_engine_t engine;    // The protocol engine run by the blocking functions.
+
+    textalk_stats_t  stats;     // Metrics of the session.
+    textalk_trace_t *trace;     // Protocol trace ring, or NULL if not used.
 } textalk_t;
 
 void textalk_init(textalk_t              *self,
                   const textalk_conf_t   *conf,
                   const textalk_events_t *events);
+int  textalk_init_ex(textalk_t                 *self,
+                     const textalk_conf_t      *conf,
+                     const textalk_events_t    *events,
+                     const textalk_allocator_t *alloc);
 void textalk_deinit(textalk_t *self);
 
 int textalk_send_ctrl(textalk_t *self, char code);
 int textalk_wait_ctrl(textalk_t *self, char target, char *result);
 int textalk_send_text(textalk_t *self, const char *text, bool havemore);
 int textalk_wait_text(textalk_t *self, char *buf, size_t bufsize);
+int textalk_send_data(textalk_t *self, const void *data, size_t len, bool havemore);
+int textalk_wait_data(textalk_t *self, void *buf, size_t bufsize, size_t *outlen);
+int textalk_send_message(textalk_t *self, const void *data, size_t len);
+int textalk_recv_message(textalk_t *self, char **buf, size_t *bufsize, size_t *len);
+int textalk_recv_message_stream(textalk_t               *self,
+                                textalk_on_recv_chunk_t  on_chunk,
+                                void                    *userarg);
+
+const textalk_stats_t* textalk_get_stats(const textalk_t *self);
+void                   textalk_reset_stats(textalk_t *self);
+void                   textalk_set_trace(textalk_t *self, textalk_trace_t *trace);
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -57,7 +107,7 @@ class TTextalk : protected textalk_t
 {
 public:
 
-    TTextalk(const textalk_conf_t &conf)
+    TTextalk(const textalk_conf_t &conf, const textalk_allocator_t *alloc = NULL)
     {
         textalk_events_t events =
         {
@@ -70,9 +120,10 @@ public:
             (void(*)(void*,const char*)) OnReceiveTextCallback
         };
 
-        textalk_init(this,
-                     &conf,
-                     &events);
+        initerr = textalk_init_ex(this,
+                                  &conf,
+                                  &events,
+                                  alloc);
     }
 
     ~TTextalk()
@@ -138,6 +189,18 @@ protected:
 
 public:
 
+    int GetInitError() const
+    {
+        /// Get the result of the construction, see textalk_t::textalk_init_ex.
+        return initerr;
+    }
+
+    bool IsValid() const
+    {
+        /// Check if the object is constructed successfully and can be used.
+        return initerr == TEXTALK_ERR_SUCCESS;
+    }
+
     int SendCtrl(char code)
     {
         /// @see textalk_t::textalk_send_ctrl
@@ -158,18 +221,389 @@ public:
 
     int WaitText(std::string &text)
     {
-        /// @see textalk_t::textalk_wait_text
+        /// @see textalk_t::textalk_wait_data
+
+        // The receive buffer be sized once for the largest packet,
+        // and only characters received be copied out to the text.
+        if( rxtext.size() < conf.comm.frame_max )
+            rxtext.resize(conf.comm.frame_max);
+
+        size_t len = 0;
+        int res = textalk_wait_data(this, &rxtext[0], rxtext.size(), &len);
+
+        if( res == TEXTALK_ERR_SUCCESS || res == TEXTALK_ERR_HAVE_MORE )
+            text.assign(rxtext.data(), len);
+        else
+            text.clear();
+        return res;
+    }
+
+    int SendData(const void *data, size_t len, bool havemore)
+    {
+        /// @see textalk_t::textalk_send_data
+        return textalk_send_data(this, data, len, havemore);
+    }
+
+    int WaitData(void *buf, size_t bufsize, size_t &len)
+    {
+        /// @see textalk_t::textalk_wait_data
+        return textalk_wait_data(this, buf, bufsize, &len);
+    }
+
+    int SendMessage(const std::string &message)
+    {
+        /// @see textalk_t::textalk_send_message
+        return textalk_send_message(this, message.data(), message.size());
+    }
+
+    int RecvMessage(std::string &message)
+    {
+        /// @see textalk_t::textalk_recv_message_stream
+        message.clear();
+        return textalk_recv_message_stream(this,
+                                           (textalk_on_recv_chunk_t) AppendChunkCallback,
+                                           &message);
+    }
+
+    const textalk_stats_t& GetStats() const
+    {
+        /// @see textalk_t::textalk_get_stats
+        return *textalk_get_stats(this);
+    }
+
+    void ResetStats()
+    {
+        /// @see textalk_t::textalk_reset_stats
+        textalk_reset_stats(this);
+    }
+
+    void SetTrace(textalk_trace_t *trace)
+    {
+        /// @see textalk_t::textalk_set_trace
+        textalk_set_trace(this, trace);
+    }
+
+private:
+
+    static int AppendChunkCallback(std::string *message, const char *data, size_t size, bool havemore)
+    {
+        message->append(data, size);
+        return TEXTALK_ERR_SUCCESS;
+    }
+
+private:
+    int         initerr;    // Result of the construction.
+    std::string rxtext;     // Receive buffer of WaitText.
+
+};
+
+#if __cplusplus >= 201703L
+
+/**
+ * @brief   Zero-copy C++ interface of @ref textalk_t
+ * @details A session that works on caller owned buffers and views,
+ *          and dispatches callbacks to the derived class statically (CRTP),
+ *          so there have no hidden allocations nor virtual calls.
+ *
+ *          The derived class must have these members:
+ *          @code
+ *          int Sender(const void *data, size_t size);
+ *          int Receiver(void *buf, size_t size);
+ *          @endcode
+ *          and can optionally have these members,
+ *          that will be used only if they are defined:
+ *          @code
+ *          int  Waiter(int flags, unsigned timeout);
+ *          void OnSendControl(char code);
+ *          void OnReceiveControl(char code);
+ *          void OnSendText(std::string_view text);
+ *          void OnReceiveText(std::string_view text);
+ *          @endcode
+ *
+ * @remarks The session is movable, so it can be stored in containers,
+ *          but a moved-from session must not be used any more.
+ */
+template < typename Derived >
+class TTextalkSession
+{
+private:
+    textalk_t session;
+    int       initerr;  // Result of the construction.
+
+public:
+
+    TTextalkSession(const textalk_conf_t &conf, const textalk_allocator_t *alloc = NULL)
+    {
+        textalk_events_t events = {};
+        events.userarg = this;
+        events.sender  = SenderCallback;
+        events.recver  = ReceiverCallback;
+
+        if constexpr( HasWaiter<Derived>::value )
+            events.waiter = WaiterCallback;
+        if constexpr( HasOnSendControl<Derived>::value )
+            events.on_send_ctrl = OnSendControlCallback;
+        if constexpr( HasOnReceiveControl<Derived>::value )
+            events.on_recv_ctrl = OnReceiveControlCallback;
+        if constexpr( HasOnSendText<Derived>::value )
+            events.on_send_text = OnSendTextCallback;
+        if constexpr( HasOnReceiveText<Derived>::value )
+            events.on_recv_text = OnReceiveTextCallback;
+
+        initerr = textalk_init_ex(&session, &conf, &events, alloc);
+    }
+
+    TTextalkSession(TTextalkSession &&src) noexcept
+    {
+        MoveFrom(src);
+    }
+
+    TTextalkSession& operator=(TTextalkSession &&src) noexcept
+    {
+        if( this != &src )
+        {
+            textalk_deinit(&session);
+            MoveFrom(src);
+        }
+
+        return *this;
+    }
+
+    ~TTextalkSession()
+    {
+        textalk_deinit(&session);
+    }
+
+    TTextalkSession(const TTextalkSession &src) = delete;
+    TTextalkSession& operator=(const TTextalkSession &src) = delete;
+
+private:
+
+    void MoveFrom(TTextalkSession &src)
+    {
+        // The session owns its buffers only by pointers,
+        // so it can be moved by bytes and then be bound to the new owner.
+        std::memcpy(&session, &src.session, sizeof(session));
+        session.events.userarg = this;
+        session.engine.stats   = &session.stats;
+        initerr                = src.initerr;
+
+        src.session.rxbuf      = NULL;
+        src.session.rxbufsz    = 0;
+        src.session.rxsize     = 0;
+        src.session.engine.mem = NULL;
+        src.initerr            = TEXTALK_ERR_GENERAL;
+    }
+
+    template < typename T, typename = void >
+    struct HasWaiter : std::false_type {};
+    template < typename T >
+    struct HasWaiter< T, std::void_t<decltype(&T::Waiter)> > : std::true_type {};
+
+    template < typename T, typename = void >
+    struct HasOnSendControl : std::false_type {};
+    template < typename T >
+    struct HasOnSendControl< T, std::void_t<decltype(&T::OnSendControl)> > : std::true_type {};
+
+    template < typename T, typename = void >
+    struct HasOnReceiveControl : std::false_type {};
+    template < typename T >
+    struct HasOnReceiveControl< T, std::void_t<decltype(&T::OnReceiveControl)> > : std::true_type {};
+
+    template < typename T, typename = void >
+    struct HasOnSendText : std::false_type {};
+    template < typename T >
+    struct HasOnSendText< T, std::void_t<decltype(&T::OnSendText)> > : std::true_type {};
+
+    template < typename T, typename = void >
+    struct HasOnReceiveText : std::false_type {};
+    template < typename T >
+    struct HasOnReceiveText< T, std::void_t<decltype(&T::OnReceiveText)> > : std::true_type {};
+
+    static Derived* Self(void *userarg)
+    {
+        return static_cast<Derived*>(static_cast<TTextalkSession*>(userarg));
+    }
+
+    static int SenderCallback(void *userarg, const void *data, size_t size)
+    {
+        return Self(userarg)->Sender(data, size);
+    }
+
+    static int ReceiverCallback(void *userarg, void *buf, size_t size)
+    {
+        return Self(userarg)->Receiver(buf, size);
+    }
+
+    static int WaiterCallback(void *userarg, int flags, unsigned timeout)
+    {
+        return Self(userarg)->Waiter(flags, timeout);
+    }
+
+    static void OnSendControlCallback(void *userarg, char code)
+    {
+        Self(userarg)->OnSendControl(code);
+    }
+
+    static void OnReceiveControlCallback(void *userarg, char code)
+    {
+        Self(userarg)->OnReceiveControl(code);
+    }
+
+    static void OnSendTextCallback(void *userarg, const char *text)
+    {
+        Self(userarg)->OnSendText(std::string_view(text));
+    }
+
+    static void OnReceiveTextCallback(void *userarg, const char *text)
+    {
+        Self(userarg)->OnReceiveText(std::string_view(text));
+    }
+
+    template < typename Func >
+    static int ChunkCallback(void *userarg, const char *data, size_t size, bool havemore)
+    {
+        return (*static_cast<Func*>(userarg))(std::string_view(data, size), havemore);
+    }
+
+public:
 
-        static const size_t bufsize =1024;
-        char buf[bufsize] = {0};
-        int res = textalk_wait_text(this, buf, sizeof(buf)-1);
+    int GetInitError() const
+    {
+        /// Get the result of the construction, see textalk_t::textalk_init_ex.
+        return initerr;
+    }
+
+    bool IsValid() const
+    {
+        /// Check if the session is constructed successfully and can be used.
+        return initerr == TEXTALK_ERR_SUCCESS;
+    }
 
-        text = buf;
+    textalk_t* Native()
+    {
+        /// Get the C session, to be used with other C functions.
+        return &session;
+    }
+
+    int SendCtrl(char code)
+    {
+        /// @see textalk_t::textalk_send_ctrl
+        return textalk_send_ctrl(&session, code);
+    }
+
+    int WaitCtrl(char target, char &result)
+    {
+        /// @see textalk_t::textalk_wait_ctrl
+        return textalk_wait_ctrl(&session, target, &result);
+    }
+
+    int SendText(std::string_view text, bool havemore)
+    {
+        /// @see textalk_t::textalk_send_data
+        return textalk_send_data(&session, text.data(), text.size(), havemore);
+    }
+
+    int WaitText(char *buf, size_t bufsize, std::string_view &text)
+    {
+        /**
+         * @see textalk_t::textalk_wait_data
+         *
+         * @param buf     The buffer to receive the text.
+         * @param bufsize Size of the buffer, and the text will be rejected
+         *                if it is larger than the buffer.
+         * @param text    Returns a view of the text in the buffer.
+         */
+        size_t len = 0;
+        int res = textalk_wait_data(&session, buf, bufsize, &len);
+
+        bool got = ( res == TEXTALK_ERR_SUCCESS || res == TEXTALK_ERR_HAVE_MORE );
+        text = std::string_view(buf, got ? len : 0);
         return res;
     }
 
+    template < size_t Size >
+    int WaitText(char (&buf)[Size], std::string_view &text)
+    {
+        /// @see TTextalkSession::WaitText
+        return WaitText(buf, Size, text);
+    }
+
+    int SendData(const void *data, size_t len, bool havemore)
+    {
+        /// @see textalk_t::textalk_send_data
+        return textalk_send_data(&session, data, len, havemore);
+    }
+
+    int WaitData(void *buf, size_t bufsize, size_t &len)
+    {
+        /// @see textalk_t::textalk_wait_data
+        return textalk_wait_data(&session, buf, bufsize, &len);
+    }
+
+#ifdef __cpp_lib_span
+    int SendData(std::span<const std::byte> data, bool havemore)
+    {
+        /// @see textalk_t::textalk_send_data
+        return textalk_send_data(&session, data.data(), data.size(), havemore);
+    }
+
+    int WaitData(std::span<std::byte> buf, std::span<std::byte> &data)
+    {
+        /// @see textalk_t::textalk_wait_data
+        size_t len = 0;
+        int res = textalk_wait_data(&session, buf.data(), buf.size(), &len);
+
+        bool got = ( res == TEXTALK_ERR_SUCCESS || res == TEXTALK_ERR_HAVE_MORE );
+        data = buf.first( got ? len : 0 );
+        return res;
+    }
+#endif
+
+    int SendMessage(std::string_view message)
+    {
+        /// @see textalk_t::textalk_send_message
+        return textalk_send_message(&session, message.data(), message.size());
+    }
+
+    template < typename Func >
+    int RecvMessage(Func &&on_chunk)
+    {
+        /**
+         * @see textalk_t::textalk_recv_message_stream
+         *
+         * @param on_chunk A callable of `int(std::string_view chunk, bool havemore)`
+         *                 that be called with each block of the message
+         *                 right from the receive buffer.
+         */
+        using FuncType = std::remove_reference_t<Func>;
+        return textalk_recv_message_stream(&session,
+                                           ChunkCallback<FuncType>,
+                                           (void*) &on_chunk);
+    }
+
+    const textalk_stats_t& GetStats() const
+    {
+        /// @see textalk_t::textalk_get_stats
+        return *textalk_get_stats(&session);
+    }
+
+    void ResetStats()
+    {
+        /// @see textalk_t::textalk_reset_stats
+        textalk_reset_stats(&session);
+    }
+
+    void SetTrace(textalk_trace_t *trace)
+    {
+        /// @see textalk_t::textalk_set_trace
+        textalk_set_trace(&session, trace);
+    }
+
 };
 
+#endif   // __cplusplus >= 201703L
+
 #endif   // __cplusplus
 
 #endif
@@ -0,0 +1,70 @@
+/**
+ * @file
+ * @brief     Text communication library - memory allocation.
+ * @author    王文佑
+ * @date      2026/10/17
+ * @copyright ZLib Licence
+ */
+#ifndef _TEXTALK_ALLOC_H_
+#define _TEXTALK_ALLOC_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Memory allocate function.
+ *
+ * @param userarg The user defined argument of the allocator.
+ * @param size    Size of memory to allocate.
+ * @return The memory allocated; or NULL if failed.
+ */
+typedef void*(*textalk_alloc_t)(void *userarg, size_t size);
+
+/**
+ * @brief   Memory release function.
+ *
+ * @param userarg The user defined argument of the allocator.
+ * @param ptr     The memory allocated by the allocate function.
+ */
+typedef void(*textalk_free_t)(void *userarg, void *ptr);
+
+/**
+ * @brief   Memory allocator.
+ * @details Buffers of a session are allocated once when the session be initialised,
+ *          and released when the session be de-initialised.
+ */
+typedef struct textalk_allocator_t
+{
+    void            *userarg;   ///< User defined argument to be passed to the functions.
+    textalk_alloc_t  alloc;     ///< Memory allocate function.
+    textalk_free_t   free;      ///< Memory release function, and can be NULL.
+} textalk_allocator_t;
+
+const textalk_allocator_t* textalk_allocator_get_defaults(void);
+
+/**
+ * @class textalk_arena_t
+ * @brief A simple arena allocator on a user supplied memory block.
+ * @details Memory are allocated from the block in sequence,
+ *          and will not be released until the arena be reset.
+ */
+typedef struct textalk_arena_t
+{
+    char   *buf;
+    size_t  size;
+    size_t  used;
+} textalk_arena_t;
+
+void   textalk_arena_init(textalk_arena_t *self, void *buf, size_t size);
+void   textalk_arena_reset(textalk_arena_t *self);
+size_t textalk_arena_get_remain(const textalk_arena_t *self);
+void   textalk_arena_fill_allocator(textalk_arena_t *self, textalk_allocator_t *allocator);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,101 @@
+/**
+ * @file
+ * @brief     Text communication library - offline capture decoder.
+ * @author    王文佑
+ * @date      2026/10/17
+ * @copyright ZLib Licence
+ */
+#ifndef _TEXTALK_CAPTURE_H_
+#define _TEXTALK_CAPTURE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "textalk_conf.h"
+#include "textalk_errcode.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Frame status.
+ */
+enum textalk_capture_status_t
+{
+    TEXTALK_CAPTURE_OK = 0,         ///< The frame is valid.
+    TEXTALK_CAPTURE_BAD_PARITY,     ///< Parity check failed.
+    TEXTALK_CAPTURE_BAD_LRC,        ///< LRC check failed.
+    TEXTALK_CAPTURE_TOO_LONG,       ///< No ETX nor ETB within the maximum frame size.
+    TEXTALK_CAPTURE_TRUNCATED,      ///< The capture ends before the frame finished.
+};
+
+/**
+ * A frame found in a capture, 16 bytes each in the index.
+ */
+typedef struct textalk_capture_frame_t
+{
+    uint64_t offset;    ///< Offset of STX in the capture.
+    uint32_t size;      ///< Size of the frame, from STX to ETX/ETB (or LRC).
+    uint8_t  status;    ///< Status, see ::textalk_capture_status_t.
+    uint8_t  echo;      ///< The first ACK, NAK, or EOT after the frame and before the next STX,
+                        ///< or ZERO if there is none.
+    uint8_t  havemore;  ///< The frame ends with ETB or not.
+    uint8_t  reserved;
+} textalk_capture_frame_t;
+
+#define TEXTALK_CAPTURE_MAGIC   0x50435854  // "TXCP" in little endian.
+#define TEXTALK_CAPTURE_VERSION 1
+
+/**
+ * Header of an index file,
+ * followed by ::textalk_capture_index_head_t::count frames.
+ * All values are in the byte order of the host.
+ */
+typedef struct textalk_capture_index_head_t
+{
+    uint32_t magic;     ///< ::TEXTALK_CAPTURE_MAGIC.
+    uint32_t version;   ///< ::TEXTALK_CAPTURE_VERSION.
+    uint64_t srcsize;   ///< Size of the capture.
+    uint64_t count;     ///< Count of frames.
+} textalk_capture_index_head_t;
+
+/**
+ * @class textalk_capture_t
+ * @brief Offline decoder of raw serial captures.
+ * @details A capture file is memory mapped and split into chunks at STX,
+ *          chunks are decoded by worker threads,
+ *          and frames found are merged in order of the capture,
+ *          and are the same as decoding the whole capture in one pass.
+ */
+typedef struct textalk_capture_t
+{
+    const char *data;       // The capture.
+    size_t      size;       // Size of the capture.
+    int         fd;         // The file mapped, or NEGATIVE if the capture is in memory.
+
+    textalk_capture_frame_t *frames;
+    size_t                   count;
+} textalk_capture_t;
+
+void textalk_capture_init(textalk_capture_t *self, const void *data, size_t size);
+int  textalk_capture_open(textalk_capture_t *self, const char *filename);
+void textalk_capture_close(textalk_capture_t *self);
+
+int textalk_capture_decode(textalk_capture_t *self, const textalk_conf_t *conf, unsigned threads);
+
+const textalk_capture_frame_t* textalk_capture_get_frames(const textalk_capture_t *self, size_t *count);
+bool textalk_capture_get_text(const textalk_capture_t       *self,
+                              const textalk_capture_frame_t *frame,
+                              const textalk_conf_t          *conf,
+                              char                          *buf,
+                              size_t                         bufsz);
+
+int textalk_capture_write_index(const textalk_capture_t *self, FILE *file);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
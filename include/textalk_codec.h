@@ -0,0 +1,68 @@
+/**
+ * @file
+ * @brief     Text communication library - packet codec.
+ * @author    王文佑
+ * @date      2026/10/17
+ * @copyright ZLib Licence
+ */
+#ifndef _TEXTALK_CODEC_H_
+#define _TEXTALK_CODEC_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "textalk_conf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Results of packet decoding.
+ */
+enum textalk_codec_status_t
+{
+    TEXTALK_CODEC_OK = 0,
+    TEXTALK_CODEC_BAD_INTEGRITY,    ///< STX, ETX, or ETB not found at their place.
+    TEXTALK_CODEC_BAD_PARITY,       ///< Parity check failed.
+    TEXTALK_CODEC_BAD_LRC,          ///< LRC check failed.
+    TEXTALK_CODEC_BUF_NOT_ENOUGH,   ///< The output buffer is not long enough.
+};
+
+/**
+ * @class textalk_codec_t
+ * @brief Packet encoder and decoder to be used by an engine.
+ * @details The default codec follows the configuration at runtime,
+ *          and a codec specialised for a fixed packet format
+ *          (see TTextalkProfile::codec) can be used instead.
+ */
+typedef struct textalk_codec_t
+{
+    /// Check if the codec produces the packets of a configuration,
+    /// and can be NULL if the codec follows any configuration.
+    bool (*match)(const textalk_conf_t *conf);
+
+    /// Encode a packet,
+    /// and return size of the packet; or ZERO if the buffer is not long enough.
+    size_t (*encode)(char                 *buf,
+                     size_t                bufsz,
+                     const char           *text,
+                     size_t                textlen,
+                     const textalk_conf_t *conf,
+                     bool                  havemore);
+
+    /// Check a packet and extract its text (null-terminated),
+    /// and return one of ::textalk_codec_status_t.
+    int (*decode)(char                 *buf,
+                  size_t                bufsz,
+                  const char           *pkt,
+                  size_t                pktsz,
+                  const textalk_conf_t *conf,
+                  size_t               *textlen,
+                  bool                 *havemore);
+} textalk_codec_t;
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
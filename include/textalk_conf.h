@@ -8,12 +8,17 @@
 #ifndef _TEXTALK_CONF_H_
 #define _TEXTALK_CONF_H_
 
+#include <stddef.h>
 #include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define TEXTALK_PKT_MAX_SIZE 1024  // The default maximum size of a packet.
+#define TEXTALK_PKT_MIN_SIZE 3     // The minimum size of a packet (STX, ETX, and LRC).
+#define TEXTALK_WINDOW_MAX   32    // The maximum count of packets in the send window.
+
 /**
  * @brief Text talk character configuration.
  * @details Characters to be used as what it named.
@@ -39,14 +44,43 @@ enum textalk_conf_parity_t
     TEXTALK_PARITY_EVEN = 2,    ///< Even parity.
 };
 
+/**
+ * Line bid role configuration.
+ */
+enum textalk_conf_role_t
+{
+    TEXTALK_ROLE_NONE      = 0,     ///< Do not bid for the line before sending.
+    TEXTALK_ROLE_PRIMARY   = 1,     ///< Bid for the line, and win when both sides bid at once.
+    TEXTALK_ROLE_SECONDARY = 2,     ///< Bid for the line, and yield when both sides bid at once.
+};
+
 /**
  * Text talk time-out configuration.
  */
 typedef struct textalk_conf_timeout_t
 {
-    unsigned send;  ///< Time-out when sending data in milliseconds.
-    unsigned echo;  ///< Time-out when waiting response code in milliseconds.
-    unsigned resp;  ///< Time-out when waiting text in milliseconds.
+    unsigned send;      ///< Time-out when sending data in milliseconds.
+    unsigned echo;      ///< Time-out when waiting response code in milliseconds,
+                        ///< and the upper limit if the adaptive time-out is used.
+    unsigned resp;      ///< Time-out when waiting text in milliseconds.
+    unsigned bid;       ///< The maximum random delay before bidding for the line again in milliseconds.
+    unsigned echo_min;  ///< The lower limit of the adaptive time-out in milliseconds,
+                        ///< and ZERO to derive it from ::textalk_conf_timeout_t::char_time
+                        ///< and the clock granularity (see textalk_rtt_init).
+    unsigned char_time; ///< Time to transmit a character on the line in microseconds,
+                        ///< and ZERO if not known (see textalk_conf_get_char_time).
+    unsigned gap;       ///< The maximum time between two characters of a packet in milliseconds,
+                        ///< the packet will be dropped and NAKed if the line goes quiet longer;
+                        ///< and ZERO to wait until ::textalk_conf_timeout_t::resp expired.
+    bool     adaptive;  ///< Derive the time-out of waiting response code from
+                        ///< the round-trip time measured (TRUE),
+                        ///< or use the fixed value (FALSE).
+                        ///< See ::textalk_rtt_t for more information.
+                        ///< A time-out shorter than the actual echo makes a packet be sent again
+                        ///< after it was received, and the stop-and-wait mode can not tell
+                        ///< the copy from a new packet, so it will be delivered twice.
+                        ///< Set the character time, or a lower limit long enough
+                        ///< for the largest packet to go through the line.
 } textalk_conf_timeout_t;
 
 /**
@@ -55,8 +89,19 @@ typedef struct textalk_conf_timeout_t
 typedef struct textalk_conf_comm_t
 {
     int      parity;        ///< Parity, see ::textalk_conf_parity_t for more information.
+    bool     parity_reject; ///< Drop and NAK a packet as soon as a character of it fails
+                            ///< the parity check (TRUE), or check the packet after it received (FALSE).
     bool     have_lrc;      ///< Does packet have LRC or not.
     unsigned retry_max;     ///< The maximum count to retry text send or receive.
+    size_t   frame_max;     ///< The maximum size of a packet in bytes,
+                            ///< and ZERO to use ::TEXTALK_PKT_MAX_SIZE.
+    unsigned window;        ///< The count of packets that can be sent before echoes received,
+                            ///< and ZERO or 1 to use the classic stop-and-wait mode.
+                            ///< Both sides must use the same mode,
+                            ///< see ::TEXTALK_WINDOW_MAX and textalk_send_message.
+    int      role;          ///< Line bid role, see ::textalk_conf_role_t for more information.
+                            ///< Both sides must bid for the line with different roles,
+                            ///< or both not bid.
 
     textalk_conf_timeout_t timeout;     ///< Time-out configuration.
 
@@ -72,6 +117,7 @@ typedef struct textalk_conf_t
 } textalk_conf_t;
 
 const textalk_conf_t* textalk_conf_get_defaults(void);
+unsigned              textalk_conf_get_char_time(unsigned baudrate);
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -0,0 +1,838 @@
+/**
+ * @file
+ * @brief     Text communication library - C++20 coroutine interface.
+ * @author    王文佑
+ * @date      2026/10/17
+ * @copyright ZLib Licence
+ */
+#ifndef _TEXTALK_CORO_H_
+#define _TEXTALK_CORO_H_
+
+#if defined(__cplusplus) && __cplusplus >= 202002L && __has_include(<coroutine>)
+
+#include <cerrno>
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/epoll.h>
+#endif
+#include "textalk.h"
+#include "textalk_engine.h"
+
+class TTextalkCoLine;
+class TTextalkExecutor;
+
+/**
+ * @brief   Coroutine task.
+ * @details The return type of coroutines that use the awaitable operations.
+ *          A task starts when it be awaited by another task,
+ *          or be spawned to an executor by TTextalkExecutor::Spawn.
+ */
+class TTextalkTask
+{
+public:
+
+    struct promise_type;
+    typedef std::coroutine_handle<promise_type> Handle;
+
+    struct FinalAwaiter
+    {
+        bool await_ready() noexcept { return false; }
+        void await_resume() noexcept {}
+
+        std::coroutine_handle<> await_suspend(Handle handle) noexcept
+        {
+            promise_type &promise = handle.promise();
+            if( promise.continuation ) return promise.continuation;
+
+            if( promise.tasks )
+            {
+                // A spawned task owns itself.
+                --*promise.tasks;
+                handle.destroy();
+            }
+
+            return std::noop_coroutine();
+        }
+    };
+
+    struct promise_type
+    {
+        std::coroutine_handle<> continuation;   // The task awaiting this one.
+        unsigned               *tasks = NULL;   // Task counter of the executor, if spawned.
+
+        TTextalkTask get_return_object() { return TTextalkTask(Handle::from_promise(*this)); }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        FinalAwaiter        final_suspend() noexcept { return {}; }
+
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+private:
+    Handle handle;
+
+public:
+
+    explicit TTextalkTask(Handle handle) : handle(handle) {}
+    TTextalkTask(TTextalkTask &&src) noexcept : handle(std::exchange(src.handle, nullptr)) {}
+
+    ~TTextalkTask()
+    {
+        if( handle ) handle.destroy();
+    }
+
+    TTextalkTask(const TTextalkTask &src) = delete;
+    TTextalkTask& operator=(const TTextalkTask &src) = delete;
+
+    Handle Release()
+    {
+        /// Give up the ownership of the coroutine.
+        return std::exchange(handle, nullptr);
+    }
+
+    auto operator co_await() && noexcept
+    {
+        struct Awaiter
+        {
+            Handle handle;
+
+            bool await_ready() noexcept { return !handle || handle.done(); }
+            void await_resume() noexcept {}
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept
+            {
+                handle.promise().continuation = caller;
+                return handle;
+            }
+        };
+
+        return Awaiter{ handle };
+    }
+
+};
+
+/**
+ * @brief   Executor adapter interface.
+ * @details An executor resumes coroutines, watches I/O readiness of lines,
+ *          and fires timers of lines.
+ *          Implement this interface to drive lines by an external event loop:
+ *          call TTextalkCoLine::OnReady when the file descriptor of a watched line be ready
+ *          (or be hung up, or failed),
+ *          and call TTextalkCoLine::OnTime when the time armed by a line be reached.
+ *
+ * @remarks All members of an executor and its lines are called from the same thread.
+ */
+class TTextalkExecutor
+{
+protected:
+    unsigned tasks = 0;     // Count of spawned tasks not finished.
+
+public:
+
+    virtual ~TTextalkExecutor() {}
+
+    /// Get the current time in milliseconds of a monotonic clock.
+    virtual unsigned Now() = 0;
+
+    /// Resume a coroutine later, and not inside the current call.
+    virtual void Post(std::coroutine_handle<> handle) = 0;
+
+    /// Start or change to watch readiness of a line:
+    /// always for reading, and for writing also if @a want_send is TRUE.
+    virtual void Watch(TTextalkCoLine *line, int fd, bool want_send) = 0;
+
+    /// Stop watching a line, and drop its timer.
+    virtual void Unwatch(TTextalkCoLine *line, int fd) = 0;
+
+    /// Call TTextalkCoLine::OnTime of a line at the time specified,
+    /// and replace the previous one armed by the line.
+    /// Calls at other times are harmless.
+    virtual void Arm(TTextalkCoLine *line, unsigned deadline) = 0;
+
+    void Spawn(TTextalkTask &&task)
+    {
+        /// Start a task that owns itself, and it will be destroyed when finished.
+        TTextalkTask::Handle handle = task.Release();
+        handle.promise().tasks = &tasks;
+        ++tasks;
+
+        Post(handle);
+    }
+
+    unsigned GetTaskCount() const
+    {
+        /// Get the count of spawned tasks not finished.
+        return tasks;
+    }
+
+};
+
+/**
+ * Result of TTextalkCoLine::Receive.
+ */
+struct TTextalkCoText
+{
+    int         errcode;    ///< One of error codes defined in ::textalk_errcode_t.
+    std::string text;       ///< The text received.
+    bool        havemore;   ///< The text have more parts (ETB) or not.
+};
+
+/**
+ * Result of TTextalkCoLine::WaitCtrl.
+ */
+struct TTextalkCoCtrl
+{
+    int  errcode;   ///< One of error codes defined in ::textalk_errcode_t.
+    char ctrl;      ///< The control code received.
+};
+
+/**
+ * @brief   A session driven by coroutines.
+ * @details The line runs the protocol of a session by the non-blocking engine,
+ *          on the file descriptor used by the sender and receiver of the session,
+ *          and operations suspend the caller until they finished
+ *          or their time-out reached, instead of blocking the thread.
+ *
+ * @remarks The blocking functions of the session should not be used
+ *          while the line exists,
+ *          and the line must not be destroyed while an operation on it is awaited.
+ */
+class TTextalkCoLine
+{
+private:
+
+    struct SendOp
+    {
+        std::coroutine_handle<> handle;
+        std::string_view        text;
+        bool                    havemore;
+        int                     errcode;
+    };
+
+    struct RecvOp
+    {
+        std::coroutine_handle<> handle;
+        unsigned                deadline;
+        TTextalkCoText          result;
+    };
+
+    struct CtrlOp
+    {
+        std::coroutine_handle<> handle;
+        unsigned                deadline;
+        char                    target;
+        TTextalkCoCtrl          result;
+    };
+
+    TTextalkExecutor &exec;
+    textalk_t        &session;
+    int               fd;
+
+    textalk_engine_t engine;
+    bool             broken;
+    bool             want_send;
+    bool             txbusy;
+    bool             armed;         // A timer is armed on the executor.
+    unsigned         armdeadline;   // Time of the timer armed.
+
+    std::deque<SendOp*>        txops;
+    std::deque<RecvOp*>        rxops;
+    std::deque<CtrlOp*>        ctrlops;
+    std::deque<TTextalkCoText> rxtexts;     // Texts received and not taken.
+
+public:
+
+    TTextalkCoLine(TTextalkExecutor      &exec,
+                   textalk_t             &session,
+                   int                    fd,
+                   const textalk_codec_t *codec = nullptr) :
+        exec(exec), session(session), fd(fd), broken(false), want_send(false), txbusy(false), armed(false), armdeadline(0)
+    {
+        /**
+         * @param exec    The executor to drive the line.
+         * @param session The session that supplies configuration, allocator,
+         *                data sender and receiver, and event callbacks.
+         * @param fd      The file descriptor used by the sender and receiver of the session.
+         * @param codec   The codec of packets (see TTextalkProfile::codec),
+         *                or NULL to follow the configuration of the session at runtime.
+         *                The line is broken if the codec does not match the configuration.
+         */
+        if( textalk_engine_init_ex(&engine, &session.conf, exec.Now(), &session.alloc) ||
+            textalk_engine_set_codec(&engine, codec) )
+            broken = true;
+        else
+            exec.Watch(this, fd, false);
+
+        textalk_engine_set_stats(&engine, &session.stats);
+        textalk_engine_set_trace(&engine, session.trace);
+    }
+
+    ~TTextalkCoLine()
+    {
+        if( !broken ) exec.Unwatch(this, fd);
+        textalk_engine_deinit(&engine);
+    }
+
+    TTextalkCoLine(const TTextalkCoLine &src) = delete;
+    TTextalkCoLine& operator=(const TTextalkCoLine &src) = delete;
+
+private:
+
+    static bool TimeIsReached(unsigned now, unsigned deadline)
+    {
+        return (int)( now - deadline ) >= 0;
+    }
+
+    void Complete(SendOp *op, int errcode)
+    {
+        op->errcode = errcode;
+        exec.Post(op->handle);
+    }
+
+    void Complete(RecvOp *op, TTextalkCoText &&result)
+    {
+        op->result = std::move(result);
+        exec.Post(op->handle);
+    }
+
+    void Complete(CtrlOp *op, int errcode, char ctrl)
+    {
+        op->result = TTextalkCoCtrl{ errcode, ctrl };
+        exec.Post(op->handle);
+    }
+
+    void StartSend()
+    {
+        while( !txbusy && !txops.empty() )
+        {
+            SendOp *op = txops.front();
+
+            int errcode = broken ?
+                          TEXTALK_ERR_STREAM_FAIL :
+                          textalk_engine_send(&engine, op->text.data(), op->text.size(), op->havemore);
+            if( errcode )
+            {
+                txops.pop_front();
+                Complete(op, errcode);
+            }
+            else
+            {
+                txbusy = true;
+            }
+        }
+    }
+
+    void FinishSend(int errcode)
+    {
+        txbusy = false;
+        if( txops.empty() ) return;
+
+        SendOp *op = txops.front();
+        txops.pop_front();
+        Complete(op, errcode);
+
+        StartSend();
+    }
+
+    void DeliverTexts()
+    {
+        while( !rxops.empty() && !rxtexts.empty() )
+        {
+            RecvOp *op = rxops.front();
+            rxops.pop_front();
+
+            Complete(op, std::move(rxtexts.front()));
+            rxtexts.pop_front();
+        }
+    }
+
+    void DeliverCtrl(char ctrl)
+    {
+        for(auto iter = ctrlops.begin(); iter != ctrlops.end(); ++iter)
+        {
+            CtrlOp *op = *iter;
+            if( op->target && op->target != ctrl ) continue;
+
+            ctrlops.erase(iter);
+            Complete(op, TEXTALK_ERR_SUCCESS, ctrl);
+            return;
+        }
+    }
+
+    void Dispatch()
+    {
+        textalk_events_t *events = &session.events;
+
+        textalk_engine_event_t event;
+        while( textalk_engine_next_event(&engine, &event) )
+        {
+            switch( event.type )
+            {
+            case TEXTALK_ENGINE_EV_TEXT:
+                events->on_recv_text(events->userarg, event.text);
+                rxtexts.push_back(TTextalkCoText{ TEXTALK_ERR_SUCCESS,
+                                                  std::string(event.text, event.textlen),
+                                                  event.havemore });
+                break;
+
+            case TEXTALK_ENGINE_EV_SENT:
+                events->on_send_text(events->userarg, event.text);
+                FinishSend(TEXTALK_ERR_SUCCESS);
+                break;
+
+            case TEXTALK_ENGINE_EV_FAILED:
+                FinishSend(event.errcode);
+                break;
+
+            case TEXTALK_ENGINE_EV_CTRL_SENT:
+                events->on_send_ctrl(events->userarg, event.ctrl);
+                break;
+
+            case TEXTALK_ENGINE_EV_CTRL_TAKEN:
+                events->on_recv_ctrl(events->userarg, event.ctrl);
+                break;
+
+            case TEXTALK_ENGINE_EV_CTRL:
+                events->on_recv_ctrl(events->userarg, event.ctrl);
+                DeliverCtrl(event.ctrl);
+                break;
+            }
+        }
+
+        DeliverTexts();
+    }
+
+    void SetBroken()
+    {
+        if( broken ) return;
+
+        exec.Unwatch(this, fd);
+        broken = true;
+
+        textalk_engine_reset(&engine, exec.Now());
+        Dispatch();
+
+        FinishSend(TEXTALK_ERR_STREAM_FAIL);
+        while( !rxops.empty() )
+        {
+            Complete(rxops.front(), TTextalkCoText{ TEXTALK_ERR_STREAM_FAIL, std::string(), false });
+            rxops.pop_front();
+        }
+        while( !ctrlops.empty() )
+        {
+            Complete(ctrlops.front(), TEXTALK_ERR_STREAM_FAIL, 0);
+            ctrlops.pop_front();
+        }
+    }
+
+    void Flush()
+    {
+        textalk_events_t *events = &session.events;
+
+        const void *data;
+        size_t      size = 0;
+        while( !broken && ( size = textalk_engine_peek_output(&engine, &data) ) )
+        {
+            int sendsz = events->sender(events->userarg, data, size);
+            if( sendsz < 0 || size < (size_t) sendsz )
+            {
+                SetBroken();
+                return;
+            }
+
+            if( !sendsz ) break;
+            textalk_engine_drop_output(&engine, sendsz);
+        }
+
+        if( !broken && want_send != ( size != 0 ) )
+        {
+            want_send = size;
+            exec.Watch(this, fd, want_send);
+        }
+    }
+
+    void Rearm()
+    {
+        if( broken ) return;
+
+        unsigned deadline;
+        bool     due = textalk_engine_get_deadline(&engine, &deadline);
+
+        for(RecvOp *op : rxops)
+        {
+            if( !due || TimeIsReached(deadline, op->deadline) )
+                deadline = op->deadline;
+            due = true;
+        }
+
+        for(CtrlOp *op : ctrlops)
+        {
+            if( !due || TimeIsReached(deadline, op->deadline) )
+                deadline = op->deadline;
+            due = true;
+        }
+
+        // The executor keeps only the latest timer of a line, so arm only when changed.
+        if( due && ( !armed || deadline != armdeadline ) )
+            exec.Arm(this, deadline);
+
+        armed       = due;
+        armdeadline = deadline;
+    }
+
+    void Pump()
+    {
+        Dispatch();
+        Flush();
+        Rearm();
+    }
+
+public:
+
+    void OnReady(bool readable, bool writable, bool hangup = false)
+    {
+        /**
+         * @brief Process I/O readiness, to be called by the executor.
+         * @param readable The descriptor is readable.
+         * @param writable The descriptor is writable.
+         * @param hangup   The remote hung up or the descriptor failed,
+         *                 and the line will be broken after data left be read.
+         *
+         * @remarks Nothing can be read after the descriptor be reported readable
+         *          means the remote closed, and the line will be broken also.
+         */
+        if( broken ) return;
+
+        textalk_events_t *events = &session.events;
+        bool              first  = true;
+        while( readable && !broken )
+        {
+            char buf[512];
+            int  recvsz = events->recver(events->userarg, buf, sizeof(buf));
+            if( recvsz < 0 || sizeof(buf) < (size_t) recvsz || ( first && !recvsz ) )
+            {
+                SetBroken();
+                break;
+            }
+            first = false;
+
+            for(size_t pos = 0; pos < (size_t) recvsz; )
+            {
+                pos += textalk_engine_feed(&engine, buf + pos, recvsz - pos);
+                Dispatch();
+            }
+
+            readable = ( recvsz == sizeof(buf) );
+        }
+
+        if( hangup ) SetBroken();
+
+        Pump();
+    }
+
+    void OnTime(unsigned now)
+    {
+        /// Process time-outs, to be called by the executor.
+        if( broken ) return;
+
+        armed = false;
+
+        textalk_engine_on_time(&engine, now);
+
+        for(auto iter = rxops.begin(); iter != rxops.end(); )
+        {
+            if( !TimeIsReached(now, (*iter)->deadline) )
+            {
+                ++iter;
+                continue;
+            }
+
+            Complete(*iter, TTextalkCoText{ TEXTALK_ERR_TIMEOUT, std::string(), false });
+            iter = rxops.erase(iter);
+        }
+
+        for(auto iter = ctrlops.begin(); iter != ctrlops.end(); )
+        {
+            if( !TimeIsReached(now, (*iter)->deadline) )
+            {
+                ++iter;
+                continue;
+            }
+
+            Complete(*iter, TEXTALK_ERR_TIMEOUT, 0);
+            iter = ctrlops.erase(iter);
+        }
+
+        Pump();
+    }
+
+    auto Send(std::string_view text, bool havemore = false)
+    {
+        /**
+         * @brief Send a text, @see textalk_t::textalk_send_data
+         * @return An awaitable that gives one of error codes defined in ::textalk_errcode_t.
+         *
+         * @remarks Texts sent by more than one coroutines are queued and sent in order.
+         *          The text only needs to be valid until the operation starts.
+         */
+        struct Awaiter
+        {
+            TTextalkCoLine *line;
+            SendOp          op;
+
+            bool await_ready() noexcept { return line->broken; }
+            int  await_resume() noexcept { return ( op.handle )?( op.errcode ):( TEXTALK_ERR_STREAM_FAIL ); }
+
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                op.handle = handle;
+                line->txops.push_back(&op);
+                line->StartSend();
+                line->Flush();
+                line->Rearm();
+            }
+        };
+
+        return Awaiter{ this, SendOp{ nullptr, text, havemore, TEXTALK_ERR_SUCCESS } };
+    }
+
+    auto Receive()
+    {
+        /**
+         * @brief Receive a text, @see textalk_t::textalk_wait_text
+         * @return An awaitable that gives a ::TTextalkCoText.
+         *
+         * @remarks Texts received while nobody waiting are queued,
+         *          and the time-out is ::textalk_conf_timeout_t::resp.
+         */
+        struct Awaiter
+        {
+            TTextalkCoLine *line;
+            RecvOp          op;
+
+            bool await_ready() noexcept { return line->broken || !line->rxtexts.empty(); }
+
+            TTextalkCoText await_resume()
+            {
+                if( op.handle ) return std::move(op.result);
+                if( line->rxtexts.empty() )
+                    return TTextalkCoText{ TEXTALK_ERR_STREAM_FAIL, std::string(), false };
+
+                TTextalkCoText result = std::move(line->rxtexts.front());
+                line->rxtexts.pop_front();
+                return result;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                op.handle   = handle;
+                op.deadline = line->exec.Now() + line->session.conf.comm.timeout.resp;
+                line->rxops.push_back(&op);
+                line->Rearm();
+            }
+        };
+
+        return Awaiter{ this, RecvOp{ nullptr, 0, TTextalkCoText{ TEXTALK_ERR_SUCCESS, std::string(), false } } };
+    }
+
+    auto WaitCtrl(char target)
+    {
+        /**
+         * @brief Wait for a control code, @see textalk_t::textalk_wait_ctrl
+         * @param target The control code to wait for; or ZERO to wait for any.
+         * @return An awaitable that gives a ::TTextalkCoCtrl.
+         *
+         * @remarks The time-out is ::textalk_conf_timeout_t::echo,
+         *          and echoes of texts being sent are consumed by the line itself.
+         */
+        struct Awaiter
+        {
+            TTextalkCoLine *line;
+            CtrlOp          op;
+
+            bool           await_ready() noexcept { return line->broken; }
+            TTextalkCoCtrl await_resume() noexcept { return ( op.handle )?( op.result ):( TTextalkCoCtrl{ TEXTALK_ERR_STREAM_FAIL, 0 } ); }
+
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                op.handle   = handle;
+                op.deadline = line->exec.Now() + line->session.conf.comm.timeout.echo;
+                line->ctrlops.push_back(&op);
+                line->Rearm();
+            }
+        };
+
+        return Awaiter{ this, CtrlOp{ nullptr, 0, target, TTextalkCoCtrl{ TEXTALK_ERR_SUCCESS, 0 } } };
+    }
+
+};
+
+#ifdef __linux__
+
+/**
+ * @brief   Minimal single-threaded executor.
+ * @details Runs coroutines, watches lines by epoll, and fires timers of lines,
+ *          all on the thread that calls RunOnce or Run.
+ */
+class TTextalkLoop : public TTextalkExecutor
+{
+private:
+
+    struct Timer
+    {
+        unsigned        deadline;
+        TTextalkCoLine *line;
+        unsigned        gen;
+
+        bool operator<(const Timer &other) const
+        {
+            // Earliest on the top of the heap.
+            return (int)( deadline - other.deadline ) > 0;
+        }
+    };
+
+    int epfd;
+
+    std::vector<std::coroutine_handle<>>         ready;
+    std::vector<std::coroutine_handle<>>         running;
+    std::priority_queue<Timer>                   timers;
+    std::unordered_map<TTextalkCoLine*,unsigned> timergens;   // Latest timer of each line.
+
+public:
+
+    TTextalkLoop()
+    {
+        epfd = epoll_create1(EPOLL_CLOEXEC);
+    }
+
+    ~TTextalkLoop()
+    {
+        if( epfd >= 0 ) close(epfd);
+    }
+
+    TTextalkLoop(const TTextalkLoop &src) = delete;
+    TTextalkLoop& operator=(const TTextalkLoop &src) = delete;
+
+    unsigned Now() override
+    {
+        using namespace std::chrono;
+        return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    void Post(std::coroutine_handle<> handle) override
+    {
+        ready.push_back(handle);
+    }
+
+    void Watch(TTextalkCoLine *line, int fd, bool want_send) override
+    {
+        struct epoll_event event = {};
+        event.events   = EPOLLIN | EPOLLRDHUP | ( want_send ? EPOLLOUT : 0 );
+        event.data.ptr = line;
+
+        if( epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &event) )
+            epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &event);
+    }
+
+    void Unwatch(TTextalkCoLine *line, int fd) override
+    {
+        epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+        timergens.erase(line);
+    }
+
+    void Arm(TTextalkCoLine *line, unsigned deadline) override
+    {
+        timers.push(Timer{ deadline, line, ++timergens[line] });
+    }
+
+    int RunOnce(int timeout)
+    {
+        /**
+         * @brief Run ready coroutines, fire timers, and then wait for I/O once.
+         * @param timeout The maximum time to wait in milliseconds; or NEGATIVE to wait infinitely.
+         * @return One of error codes defined in ::textalk_errcode_t.
+         */
+        RunReady();
+
+        unsigned now = Now();
+        while( !timers.empty() && (int)( now - timers.top().deadline ) >= 0 )
+        {
+            Timer timer = timers.top();
+            timers.pop();
+
+            auto iter = timergens.find(timer.line);
+            if( iter != timergens.end() && iter->second == timer.gen )
+                timer.line->OnTime(now);
+        }
+
+        if( !ready.empty() )
+        {
+            timeout = 0;
+        }
+        else if( !timers.empty() )
+        {
+            int remain = timers.top().deadline - now;
+            if( remain < 0 ) remain = 0;
+            if( timeout < 0 || remain < timeout ) timeout = remain;
+        }
+
+        struct epoll_event events[64];
+        int count = epoll_wait(epfd, events, 64, timeout);
+        if( count < 0 ) return ( errno == EINTR )?( TEXTALK_ERR_SUCCESS ):( TEXTALK_ERR_STREAM_FAIL );
+
+        for(int i = 0; i < count; ++i)
+        {
+            TTextalkCoLine *line = (TTextalkCoLine*) events[i].data.ptr;
+            line->OnReady(events[i].events & ( EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP ),
+                          events[i].events & EPOLLOUT,
+                          events[i].events & ( EPOLLRDHUP | EPOLLERR | EPOLLHUP ));
+        }
+
+        RunReady();
+        return TEXTALK_ERR_SUCCESS;
+    }
+
+    int Run()
+    {
+        /**
+         * @brief Run until all spawned tasks finished.
+         * @return One of error codes defined in ::textalk_errcode_t.
+         */
+        while( tasks )
+        {
+            int errcode = RunOnce(-1);
+            if( errcode ) return errcode;
+        }
+
+        return TEXTALK_ERR_SUCCESS;
+    }
+
+private:
+
+    void RunReady()
+    {
+        // Coroutines posted while running are left to the next round.
+        running.swap(ready);
+        for(std::coroutine_handle<> handle : running)
+            handle.resume();
+        running.clear();
+    }
+
+};
+
+#endif   // __linux__
+
+#endif   // C++20
+
+#endif
@@ -0,0 +1,213 @@
+/**
+ * @file
+ * @brief     Text communication library - non-blocking protocol engine.
+ * @author    王文佑
+ * @date      2026/10/17
+ * @copyright ZLib Licence
+ */
+#ifndef _TEXTALK_ENGINE_H_
+#define _TEXTALK_ENGINE_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "textalk_conf.h"
+#include "textalk_alloc.h"
+#include "textalk_rtt.h"
+#include "textalk_stats.h"
+#include "textalk_trace.h"
+#include "textalk_event.h"
+#include "textalk_errcode.h"
+#include "textalk_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Engine event types.
+ */
+enum textalk_engine_event_type_t
+{
+    TEXTALK_ENGINE_EV_NONE = 0,
+    TEXTALK_ENGINE_EV_TEXT,         ///< A text received, and ACK queued
+                                    ///< (or the text be held, see textalk_engine_set_manual_ack).
+    TEXTALK_ENGINE_EV_NAK_SENT,     ///< A bad text received, and NAK queued
+                                    ///< if the remote can be told which one to send again.
+    TEXTALK_ENGINE_EV_SENT,         ///< The text be sent, and ACK received.
+    TEXTALK_ENGINE_EV_NAK_RECV,     ///< NAK received, and the text will be sent again.
+    TEXTALK_ENGINE_EV_TIMEOUT,      ///< No echo received, and the text will be sent again.
+    TEXTALK_ENGINE_EV_FAILED,       ///< The text could not be sent (retries exhausted,
+                                    ///< terminated by remote, time-out on sending,
+                                    ///< or the line yielded to the remote).
+    TEXTALK_ENGINE_EV_CTRL,         ///< Another control code received.
+    TEXTALK_ENGINE_EV_CTRL_SENT,    ///< A control code queued to send.
+    TEXTALK_ENGINE_EV_CTRL_TAKEN,   ///< A control code received and taken by the engine,
+                                    ///< as an echo, a line bid, or the answer of a line bid.
+};
+
+/**
+ * Engine event.
+ */
+typedef struct textalk_engine_event_t
+{
+    int         type;       ///< Event type, see ::textalk_engine_event_type_t.
+    int         errcode;    ///< One of error codes defined in ::textalk_errcode_t.
+    char        ctrl;       ///< The control code received or sent.
+    const char *text;       ///< The text received or sent.
+    size_t      textlen;    ///< Length of the text.
+    bool        havemore;   ///< The text have more parts (ETB) or not.
+} textalk_engine_event_t;
+
+#define TEXTALK_ENGINE_EVENT_MAX 16 // The maximum count of events queued.
+
+/*
+ * A packet received out of order in window mode.
+ */
+typedef struct textalk_engine_slot_t
+{
+    size_t len;         // Length of the text.
+    bool   used;        // The slot have a text or not.
+    bool   havemore;    // The text have more parts (ETB) or not.
+} textalk_engine_slot_t;
+
+/*
+ * A packet of the exchange being sent in window mode.
+ */
+typedef struct textalk_engine_block_t
+{
+    unsigned sent;      // Time of the block be sent.
+    unsigned deadline;  // Time to send the block again if no echo received.
+    unsigned tries;     // Count of the block be sent.
+    bool     acked;     // The block be acknowledged or not.
+    bool     resend;    // The block is waiting to be sent again.
+} textalk_engine_block_t;
+
+/**
+ * @class textalk_engine_t
+ * @brief Non-blocking (sans-I/O) protocol engine.
+ * @details The engine does not do any I/O by itself:
+ *          received data are pushed in by textalk_engine_feed,
+ *          data to send are pulled out by textalk_engine_take_output
+ *          (or textalk_engine_peek_output and textalk_engine_drop_output),
+ *          and time-outs are processed by textalk_engine_on_time.
+ *          Results are reported as events taken by textalk_engine_next_event.
+ *
+ * @remarks Times are milliseconds of any monotonic clock chosen by the user,
+ *          and they are allowed to wrap around.
+ * @remarks The engine runs the whole protocol:
+ *          the stop-and-wait exchange, the window mode (textalk_conf_comm_t::window),
+ *          and line bids (textalk_conf_comm_t::role).
+ *          The blocking session (textalk_t) and the drivers
+ *          (the reactor, the executor, and the coroutine line) are all built on it.
+ */
+typedef struct textalk_engine_t
+{
+    textalk_conf_t         conf;
+    textalk_conf_ctrl_t    wire;        // Control characters with parity added.
+    const textalk_codec_t *codec;       // The packet codec, never NULL.
+    textalk_allocator_t    alloc;
+    void                  *mem;         // The memory block of all buffers.
+    unsigned               now;
+    bool                   manualack;   // Texts received wait for the user to accept or reject.
+    bool                   vectored;    // Packets refer to the text instead of being encoded.
+
+    int      rxstate;
+    char    *rxpkt;
+    size_t   rxpktsz;
+    bool     rxoverflow;
+    unsigned rxstarted;
+    unsigned rxdeadline;
+    unsigned rxgapdeadline;
+    char    *rxtext;
+    bool     rxinslot;      // The text held comes from a slot.
+    char     rxecho;        // The echo waiting for its sequence characters in window mode.
+
+    char                   rxstart;     // Start character of the exchange received in window mode,
+                                        // or ZERO if not synchronised.
+    unsigned               rxseq;       // Sequence of the next packet expected in the exchange.
+    textalk_engine_slot_t *rxslots;     // Packets received out of order in window mode.
+    char                  *rxwin;       // Text buffers of the slots.
+
+    int         txstate;
+    char       *txpkt;
+    char       *txtext;
+    const char *txdata;     // The text being sent, the copy or the data of the user.
+    size_t      txlen;
+    bool        txhavemore;
+    unsigned    txtries;
+    unsigned    txsent;
+    unsigned    txdeadline;
+
+    char        txhead[2];  // The packet being taken out: head, body, and tail.
+    size_t      txheadsz;
+    const char *txbody;
+    size_t      txbodysz;
+    char        txtail[2];
+    size_t      txtailsz;
+    size_t      txoutsz;    // Size of the packet being taken out, or ZERO if none.
+    size_t      txpos;
+
+    char                   txstart;     // Start character of the last exchange sent in window mode.
+    size_t                 txcount;     // Count of blocks of the exchange.
+    size_t                 txbase;      // The first block not acknowledged.
+    size_t                 txnext;      // The next block to be sent for the first time.
+    size_t                 txcur;       // The block being taken out.
+    textalk_engine_block_t txblocks[TEXTALK_WINDOW_MAX];
+
+    bool     txholding;     // The line is held by this side (line bid) or not.
+    unsigned bidseed;       // Random seed of the line bid delay.
+
+    textalk_rtt_t    rtt;
+    textalk_stats_t *stats;     // Counters to be updated, or NULL if not used.
+    textalk_trace_t *trace;     // Protocol trace ring, or NULL if not used.
+
+    char   ctrlout[16];
+    size_t ctrloutsz;
+
+    textalk_engine_event_t evqueue[TEXTALK_ENGINE_EVENT_MAX];
+    unsigned               evhead;
+    unsigned               evcount;
+} textalk_engine_t;
+
+int  textalk_engine_init(textalk_engine_t *self, const textalk_conf_t *conf, unsigned now);
+int  textalk_engine_init_ex(textalk_engine_t          *self,
+                            const textalk_conf_t      *conf,
+                            unsigned                   now,
+                            const textalk_allocator_t *alloc);
+void textalk_engine_deinit(textalk_engine_t *self);
+void textalk_engine_reset(textalk_engine_t *self, unsigned now);
+
+int    textalk_engine_send(textalk_engine_t *self, const char *text, size_t len, bool havemore);
+int    textalk_engine_send_ref(textalk_engine_t *self, const void *data, size_t len, bool havemore);
+int    textalk_engine_send_ctrl(textalk_engine_t *self, char code);
+size_t textalk_engine_feed(textalk_engine_t *self, const void *data, size_t size);
+void   textalk_engine_on_time(textalk_engine_t *self, unsigned now);
+
+int  textalk_engine_accept(textalk_engine_t *self);
+int  textalk_engine_reject(textalk_engine_t *self);
+int  textalk_engine_terminate(textalk_engine_t *self);
+void textalk_engine_on_resp_timeout(textalk_engine_t *self);
+
+size_t textalk_engine_peek_output(const textalk_engine_t *self, const void **data);
+int    textalk_engine_peek_vector(const textalk_engine_t *self, textalk_iovec_t *iov, int iovmax);
+void   textalk_engine_drop_output(textalk_engine_t *self, size_t size);
+size_t textalk_engine_take_output(textalk_engine_t *self, void *buf, size_t size);
+
+void textalk_engine_set_stats(textalk_engine_t *self, textalk_stats_t *stats);
+void textalk_engine_set_trace(textalk_engine_t *self, textalk_trace_t *trace);
+int  textalk_engine_set_codec(textalk_engine_t *self, const textalk_codec_t *codec);
+void textalk_engine_set_manual_ack(textalk_engine_t *self, bool manual);
+void textalk_engine_set_vectored(textalk_engine_t *self, bool vectored);
+
+bool   textalk_engine_next_event(textalk_engine_t *self, textalk_engine_event_t *event);
+bool   textalk_engine_peek_event(const textalk_engine_t *self, textalk_engine_event_t *event);
+bool   textalk_engine_get_deadline(const textalk_engine_t *self, unsigned *deadline);
+bool   textalk_engine_is_busy(const textalk_engine_t *self);
+bool   textalk_engine_is_receiving(const textalk_engine_t *self);
+size_t textalk_engine_get_block_size(const textalk_engine_t *self);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
@@ -26,6 +26,8 @@ enum textalk_errcode_t
     TEXTALK_ERR_BAD_EXCHANGE,       ///< Communication be aborted by the bad packet data or echo!
     TEXTALK_ERR_TERMINATED,         ///< Communication be terminated by remote!
     TEXTALK_ERR_TIMEOUT,            ///< Time-out!
+    TEXTALK_ERR_BUSY,               ///< Another exchange is still in progress!
+    TEXTALK_ERR_CONTENTION,         ///< The line be yielded to the remote, receive its text first!
 
     TEXTALK_ERR_GENERAL     = -1,
 };
@@ -42,6 +42,31 @@ typedef int(*textalk_sender_t)(void *userarg, const void *data, size_t size);
  */
 typedef int(*textalk_recver_t)(void *userarg, void *buf, size_t size);
 
+/**
+ * Data segment of ::textalk_sendv_t.
+ */
+typedef struct textalk_iovec_t
+{
+    const void *data;   ///< The data.
+    size_t      size;   ///< Size of the data.
+} textalk_iovec_t;
+
+/**
+ * @brief   Vectored data sender.
+ * @details The callback function that will be called to send
+ *          several segments of binary data in one call (like writev).
+ *
+ * @param userarg An user defined argument.
+ * @param iov     The data segments to be sent in order.
+ * @param iovcnt  Count of the data segments.
+ * @retval POSITIVE A positive value (including ZERO) indicates
+ *         how many data in bytes have been sent out.
+ * @retval NEGATIVE A negative value indicates error occurred.
+ *
+ * @remarks This function should work under non-blocking mode.
+ */
+typedef int(*textalk_sendv_t)(void *userarg, const textalk_iovec_t *iov, int iovcnt);
+
 /**
  * @brief   Event on control code sent.
  * @details The callback function that will be called when
@@ -82,6 +107,47 @@ typedef void(*textalk_on_send_text_t)(void *userarg, const char *text);
  */
 typedef void(*textalk_on_recv_text_t)(void *userarg, const char *text);
 
+/**
+ * Readiness flags of ::textalk_waiter_t.
+ */
+enum textalk_wait_flags_t
+{
+    TEXTALK_WAIT_RECV = 0x01,   ///< Wait until data can be received.
+    TEXTALK_WAIT_SEND = 0x02,   ///< Wait until data can be sent.
+};
+
+/**
+ * @brief   Readiness waiter.
+ * @details The callback function that will be called when
+ *          the sender or receiver can not make progress,
+ *          to block until the link be ready or the time-out expired.
+ *
+ * @param userarg An user defined argument.
+ * @param flags   What to wait for, a combination of ::textalk_wait_flags_t;
+ *                or ZERO to just wait until the time-out expired.
+ * @param timeout The maximum time to wait in milliseconds.
+ * @retval POSITIVE A positive value indicates that the link is ready.
+ * @retval ZERO     Time-out.
+ * @retval NEGATIVE A negative value indicates error occurred.
+ *
+ * @remarks This is usually a wrapper of poll() on the file descriptor
+ *          used by the sender and receiver.
+ */
+typedef int(*textalk_waiter_t)(void *userarg, int flags, unsigned timeout);
+
+/**
+ * @brief   Clock.
+ * @details The callback function that will be called to get the current time.
+ *
+ * @param userarg An user defined argument.
+ * @return The current time in milliseconds of a monotonic clock,
+ *         and it is allowed to wrap around.
+ *
+ * @remarks This is usually used to run sessions on a virtual clock of a simulator,
+ *          and the waiter should be supplied also to let the time go.
+ */
+typedef unsigned(*textalk_clock_t)(void *userarg);
+
 /**
  * Event callbacks.
  */
@@ -101,6 +167,18 @@ typedef struct textalk_events_t
     textalk_on_recv_text_t on_recv_text;    ///< Event on text received.
                                             ///< it is optional and can be NULL to not use.
 
+    textalk_waiter_t waiter;    ///< Readiness waiter,
+                                ///< it is optional and can be NULL to
+                                ///< poll the sender and receiver with short sleeps.
+
+    textalk_sendv_t sendv;      ///< Vectored data sender,
+                                ///< it is optional and can be NULL to not use.
+                                ///< It will be used to send texts without copying
+                                ///< when parity is not used.
+
+    textalk_clock_t clock;      ///< Clock,
+                                ///< it is optional and can be NULL to use the system clock.
+
 } textalk_events_t;
 
 #ifdef __cplusplus
@@ -0,0 +1,132 @@
+/**
+ * @file
+ * @brief     Text communication library - threaded session executor.
+ * @author    王文佑
+ * @date      2026/10/17
+ * @copyright ZLib Licence
+ */
+#ifndef _TEXTALK_EXECUTOR_H_
+#define _TEXTALK_EXECUTOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "textalk.h"
+#include "textalk_reactor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TEXTALK_EXECUTOR_PORT_MAX 16    // The maximum count of sessions of an executor.
+
+/**
+ * A request to send a text through an executor.
+ * The request is owned by the caller, and must be kept until it be completed.
+ */
+typedef struct textalk_exec_req_t
+{
+    struct textalk_exec_req_t *next;    // Link of queues, private.
+
+    const char *text;       ///< The text to be sent, and must be kept until the request completed.
+    bool        havemore;   ///< Send with ETB (TRUE) or ETX (FALSE).
+    void       *userarg;    ///< A user defined argument, untouched by the executor.
+
+    unsigned port;          ///< The port sent to, filled when submitted.
+    int      errcode;       ///< Result of the exchange, filled when completed.
+} textalk_exec_req_t;
+
+/**
+ * A text received by an executor.
+ */
+typedef struct textalk_exec_text_t
+{
+    struct textalk_exec_text_t *next;   // Link of queues, private.
+
+    unsigned port;      ///< The port received from.
+    size_t   len;       ///< Length of the text.
+    bool     havemore;  ///< The text have more parts (ETB) or not (ETX).
+    char     text[];    ///< The text, and it is null-terminated.
+} textalk_exec_text_t;
+
+struct textalk_executor_t;
+
+/**
+ * A session owned by an executor.
+ */
+typedef struct textalk_executor_port_t
+{
+    struct textalk_executor_t *owner;
+    unsigned                   index;
+
+    textalk_t              *session;
+    int                     fd;
+    textalk_events_t        events;     // The original events of the session.
+    textalk_reactor_line_t *line;
+
+    textalk_exec_req_t *pendhead;       // Requests waiting for the line.
+    textalk_exec_req_t *pendtail;
+    textalk_exec_req_t *current;        // The request being sent.
+} textalk_executor_port_t;
+
+/**
+ * @class textalk_executor_t
+ * @brief Run sessions on a dedicated I/O thread.
+ * @details The executor owns a group of sessions, and drives them by a reactor
+ *          on its own thread.
+ *          Application threads submit texts to send through a lock-free queue,
+ *          and take results and texts received from lock-free queues.
+ *          Requests queued behind a busy exchange are started right
+ *          when the exchange finished, on the I/O thread.
+ *
+ * @remarks Ports are added before the executor starts.
+ *          textalk_executor_submit can be called from any thread,
+ *          and other functions for results and texts
+ *          should be called from one consumer thread.
+ */
+typedef struct textalk_executor_t
+{
+    textalk_reactor_t reactor;
+    pthread_t         thread;
+    bool              running;
+    int               stopping;
+
+    textalk_allocator_t alloc;      // Allocator of texts received.
+    int                 notifyfd;   // Becomes readable when results or texts arrived.
+
+    textalk_exec_req_t  *subqueue;  // Requests submitted, pushed by any thread.
+    textalk_exec_req_t  *donequeue; // Requests completed, pushed by the I/O thread.
+    textalk_exec_text_t *textqueue; // Texts received, pushed by the I/O thread.
+
+    textalk_exec_req_t  *donelist;  // Requests completed, taken by the consumer in order.
+    textalk_exec_text_t *textlist;  // Texts received, taken by the consumer in order.
+
+    textalk_executor_port_t ports[TEXTALK_EXECUTOR_PORT_MAX];
+    unsigned                portcount;
+
+    uint64_t textdropped;   // Texts received but failed to be kept, updated by the I/O thread.
+} textalk_executor_t;
+
+int  textalk_executor_init(textalk_executor_t *self, const textalk_allocator_t *alloc);
+void textalk_executor_deinit(textalk_executor_t *self);
+
+int  textalk_executor_add(textalk_executor_t *self, textalk_t *session, int fd, unsigned *port);
+int  textalk_executor_start(textalk_executor_t *self);
+void textalk_executor_stop(textalk_executor_t *self);
+
+int textalk_executor_submit(textalk_executor_t *self, unsigned port, textalk_exec_req_t *req);
+
+textalk_exec_req_t*  textalk_executor_take_done(textalk_executor_t *self);
+textalk_exec_text_t* textalk_executor_take_text(textalk_executor_t *self);
+void                 textalk_executor_free_text(textalk_executor_t *self, textalk_exec_text_t *text);
+uint64_t             textalk_executor_get_dropped(const textalk_executor_t *self);
+
+int textalk_executor_get_notify_fd(const textalk_executor_t *self);
+int textalk_executor_wait(textalk_executor_t *self, unsigned timeout);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,320 @@
+/**
+ * @file
+ * @brief     Text communication library - compile-time protocol profiles.
+ * @author    王文佑
+ * @date      2026/10/17
+ * @copyright ZLib Licence
+ */
+#ifndef _TEXTALK_PROFILE_H_
+#define _TEXTALK_PROFILE_H_
+
+#if defined(__cplusplus) && __cplusplus >= 201703L
+
+#include <stddef.h>
+#include <string.h>
+#include "textalk_conf.h"
+#include "textalk_codec.h"
+#include "textalk_errcode.h"
+
+/**
+ * @brief   Control characters of a profile.
+ * @details The default characters are the same as ::textalk_conf_get_defaults.
+ */
+template < char Stx = 0x02,
+           char Etx = 0x03,
+           char Etb = 0x17,
+           char Enq = 0x05,
+           char Ack = 0x06,
+           char Nak = 0x15,
+           char Eot = 0x04 >
+struct TTextalkCtrl
+{
+    static constexpr textalk_conf_ctrl_t chars = { Stx, Etx, Etb, Enq, Ack, Nak, Eot };
+};
+
+/**
+ * @brief   Protocol profile fixed at compile time.
+ * @details The packet format (parity, LRC, and control characters) of a profile
+ *          is a set of template arguments,
+ *          so the encoder, the decoder, and the packet scanner
+ *          are specialised for it with no branches on the configuration,
+ *          and control characters on the line are computed at compile time.
+ *
+ *          Packets produced and accepted are the same as
+ *          the runtime configured path with the configuration of GetConf,
+ *          which can be used for sessions, engines, and other dynamic setups.
+ *          An engine (or a line driven by it) of such configuration
+ *          takes the specialised codec by textalk_engine_set_codec with ::codec.
+ *
+ * @tparam Parity  One of ::textalk_conf_parity_t.
+ * @tparam HaveLrc Does packet have LRC or not.
+ * @tparam Ctrl    Control characters, see ::TTextalkCtrl.
+ */
+template < int Parity, bool HaveLrc, typename Ctrl = TTextalkCtrl<> >
+class TTextalkProfile
+{
+    static_assert( Parity == TEXTALK_PARITY_NONE ||
+                   Parity == TEXTALK_PARITY_ODD  ||
+                   Parity == TEXTALK_PARITY_EVEN, "Unknown parity!" );
+
+private:
+
+    static constexpr unsigned char BitsParity(unsigned char ch)
+    {
+        // 1 if the character have odd count of bits set, computed without branches.
+        ch ^= ch >> 4;
+        ch ^= ch >> 2;
+        ch ^= ch >> 1;
+        return ch & 0x01;
+    }
+
+    static constexpr char AddParity(char ch)
+    {
+        if constexpr( Parity == TEXTALK_PARITY_NONE )
+        {
+            return ch;
+        }
+        else
+        {
+            unsigned char data = ch & 0x7F;
+            unsigned char flip = ( Parity == TEXTALK_PARITY_ODD )?( 1 ):( 0 );
+            return data | ( ( BitsParity(data) ^ flip ) << 7 );
+        }
+    }
+
+    static constexpr unsigned char BadParity(char ch)
+    {
+        // Non-zero if the parity of a character received is wrong.
+        if constexpr( Parity == TEXTALK_PARITY_NONE )
+            return 0;
+        else if constexpr( Parity == TEXTALK_PARITY_ODD )
+            return BitsParity(ch) ^ 1;
+        else
+            return BitsParity(ch);
+    }
+
+    template < bool Copy >
+    static unsigned char ScanText(char *buf, const char *text, size_t len, char *lrc)
+    {
+        // Accumulate parity errors and LRC of a text,
+        // and copy it with parity removed if required.
+        unsigned char bad = 0;
+        for(size_t i = 0; i < len; ++i)
+        {
+            char ch = text[i];
+            bad    |= BadParity(ch);
+            *lrc   ^= ch;
+            if constexpr( Copy )
+                buf[i] = ( Parity == TEXTALK_PARITY_NONE )?( ch ):( ch & 0x7F );
+        }
+
+        return bad;
+    }
+
+    static int DecodePacket(char       *buf,
+                            size_t      bufsz,
+                            const char *pkt,
+                            size_t      pktsz,
+                            size_t     *textlen,
+                            bool       *havemore)
+    {
+        // Decode a packet, and return one of textalk_codec_status_t.
+        if( pktsz < overhead ) return TEXTALK_CODEC_BAD_INTEGRITY;
+
+        // Control characters are recognised without their parity bits
+        // (the same as the runtime decoder), and their parity be checked with the text.
+        size_t len  = pktsz - overhead;
+        char   stx  = pkt[0];
+        char   end  = pkt[len+1];
+        char   code = end & 0x7F;
+        if( ( stx & 0x7F ) != Ctrl::chars.stx || ( code != Ctrl::chars.etx && code != Ctrl::chars.etb ) )
+            return TEXTALK_CODEC_BAD_INTEGRITY;
+
+        // A bad packet is reported in priority to the buffer size.
+        bool          fits = ( bufsz >= len + 1 );
+        char          lrc  = end;
+        unsigned char bad  = BadParity(stx) | BadParity(end);
+        if( fits )
+        {
+            bad |= ScanText<true>(buf, pkt + 1, len, &lrc);
+            buf[len] = 0;
+        }
+        else
+        {
+            bad |= ScanText<false>(buf, pkt + 1, len, &lrc);
+        }
+
+        if( bad ) return TEXTALK_CODEC_BAD_PARITY;
+        if constexpr( HaveLrc )
+        {
+            if( lrc != pkt[pktsz-1] ) return TEXTALK_CODEC_BAD_LRC;
+        }
+        if( !fits ) return TEXTALK_CODEC_BUF_NOT_ENOUGH;
+
+        if( textlen  ) *textlen  = len;
+        if( havemore ) *havemore = ( code == Ctrl::chars.etb );
+
+        return TEXTALK_CODEC_OK;
+    }
+
+    static bool CodecMatch(const textalk_conf_t *conf)
+    {
+        return Match(*conf);
+    }
+
+    static size_t CodecEncode(char                 *buf,
+                              size_t                bufsz,
+                              const char           *text,
+                              size_t                textlen,
+                              const textalk_conf_t *conf,
+                              bool                  havemore)
+    {
+        return Encode(buf, bufsz, text, textlen, havemore);
+    }
+
+    static int CodecDecode(char                 *buf,
+                           size_t                bufsz,
+                           const char           *pkt,
+                           size_t                pktsz,
+                           const textalk_conf_t *conf,
+                           size_t               *textlen,
+                           bool                 *havemore)
+    {
+        return DecodePacket(buf, bufsz, pkt, pktsz, textlen, havemore);
+    }
+
+public:
+
+    /// Size of the packet besides the text.
+    static constexpr size_t overhead = (1/*STX*/) + (1/*ETX*/) + ( HaveLrc ? 1 : 0 );
+
+    /// Control characters with parity added, as they are on the line.
+    static constexpr textalk_conf_ctrl_t wire =
+    {
+        AddParity(Ctrl::chars.stx),
+        AddParity(Ctrl::chars.etx),
+        AddParity(Ctrl::chars.etb),
+        AddParity(Ctrl::chars.enq),
+        AddParity(Ctrl::chars.ack),
+        AddParity(Ctrl::chars.nak),
+        AddParity(Ctrl::chars.eot),
+    };
+
+    /// The codec to be used by engines, see textalk_engine_set_codec.
+    static constexpr textalk_codec_t codec = { CodecMatch, CodecEncode, CodecDecode };
+
+    static textalk_conf_t GetConf()
+    {
+        /// Get the runtime configuration equivalent to the profile,
+        /// based on the default configuration.
+        textalk_conf_t conf = *textalk_conf_get_defaults();
+        conf.ctrl          = Ctrl::chars;
+        conf.comm.parity   = Parity;
+        conf.comm.have_lrc = HaveLrc;
+
+        return conf;
+    }
+
+    static bool Match(const textalk_conf_t &conf)
+    {
+        /// Check if a runtime configuration produces the same packets as the profile.
+        return conf.comm.parity   == Parity &&
+               conf.comm.have_lrc == HaveLrc &&
+               !memcmp(&conf.ctrl, &Ctrl::chars, sizeof(conf.ctrl));
+    }
+
+    static size_t Encode(char *buf, size_t bufsz, const char *text, size_t textlen, bool havemore)
+    {
+        /**
+         * @brief Encode a packet.
+         *
+         * @param buf      The buffer to receive the packet.
+         * @param bufsz    Size of the buffer.
+         * @param text     The text.
+         * @param textlen  Length of the text.
+         * @param havemore End the packet with ETB (TRUE) or ETX (FALSE).
+         * @return Size of the packet; or ZERO if the buffer is not long enough.
+         */
+        size_t pktsz = textlen + overhead;
+        if( bufsz < pktsz ) return 0;
+
+        // Parity, copy, and LRC be done in one pass.
+        char lrc = 0;
+        for(size_t i = 0; i < textlen; ++i)
+        {
+            char ch = AddParity(text[i]);
+            buf[i+1] = ch;
+            lrc     ^= ch;
+        }
+
+        char end = havemore ? wire.etb : wire.etx;
+
+        buf[0]         = wire.stx;
+        buf[textlen+1] = end;
+        if constexpr( HaveLrc )
+            buf[textlen+2] = lrc ^ end;
+
+        return pktsz;
+    }
+
+    static int Decode(char       *buf,
+                      size_t      bufsz,
+                      const char *pkt,
+                      size_t      pktsz,
+                      size_t     *textlen,
+                      bool       *havemore)
+    {
+        /**
+         * @brief Check a packet and extract its text (null-terminated) in one pass.
+         *
+         * @param buf      The buffer to receive the text.
+         * @param bufsz    Size of the buffer.
+         * @param pkt      The packet.
+         * @param pktsz    Size of the packet.
+         * @param textlen  Returns length of the text, and can be NULL to not report.
+         * @param havemore Returns if the packet ends with ETB, and can be NULL to not report.
+         * @return One of error codes defined in ::textalk_errcode_t:
+         *         ::TEXTALK_ERR_BAD_EXCHANGE if the packet is broken,
+         *         or ::TEXTALK_ERR_BUF_NOT_ENOUGH if the buffer is not long enough.
+         */
+        switch( DecodePacket(buf, bufsz, pkt, pktsz, textlen, havemore) )
+        {
+        case TEXTALK_CODEC_OK:             return TEXTALK_ERR_SUCCESS;
+        case TEXTALK_CODEC_BUF_NOT_ENOUGH: return TEXTALK_ERR_BUF_NOT_ENOUGH;
+        default:                           return TEXTALK_ERR_BAD_EXCHANGE;
+        }
+    }
+
+    static size_t FindStart(const char *data, size_t size)
+    {
+        /**
+         * @brief Find the start (STX) of a packet in data received.
+         * @return Position of STX; or @a size if not found.
+         */
+        const char *pos = (const char*) memchr(data, wire.stx, size);
+        return ( pos )?( pos - data ):( size );
+    }
+
+    static size_t FindEnd(const char *data, size_t size)
+    {
+        /**
+         * @brief Find the end of a packet in data received after STX.
+         * @return Size of the data up to and including ETX/ETB (and LRC);
+         *         or ZERO if the end is not received yet.
+         */
+        for(size_t i = 0; i < size; ++i)
+        {
+            if( data[i] != wire.etx && data[i] != wire.etb ) continue;
+
+            size_t endsz = i + 1 + ( HaveLrc ? 1 : 0 );
+            return ( endsz <= size )?( endsz ):( 0 );
+        }
+
+        return 0;
+    }
+
+};
+
+#endif   // C++17
+
+#endif
@@ -0,0 +1,105 @@
+/**
+ * @file
+ * @brief     Text communication library - event reactor of many sessions.
+ * @author    王文佑
+ * @date      2026/10/17
+ * @copyright ZLib Licence
+ */
+#ifndef _TEXTALK_REACTOR_H_
+#define _TEXTALK_REACTOR_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "textalk.h"
+#include "textalk_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Event on text exchange finished.
+ * @details The callback function that will be called when
+ *          a text sent by textalk_reactor_send_text be finished.
+ *
+ * @param userarg The user defined argument of the session events.
+ * @param session The session.
+ * @param errcode One of error codes defined in ::textalk_errcode_t.
+ */
+typedef void(*textalk_reactor_on_done_t)(void *userarg, textalk_t *session, int errcode);
+
+/**
+ * @brief   Event on a text received, with its details.
+ * @details The callback function that will be called
+ *          after textalk_events_t::on_recv_text of a line,
+ *          when it be set by textalk_reactor_set_on_text.
+ *
+ * @param userarg  The user defined argument of the session events.
+ * @param session  The session.
+ * @param text     The text received, and it is null-terminated.
+ * @param len      Length of the text.
+ * @param havemore The text have more parts (ETB) or not (ETX).
+ */
+typedef void(*textalk_reactor_on_text_t)(void       *userarg,
+                                         textalk_t  *session,
+                                         const char *text,
+                                         size_t      len,
+                                         bool        havemore);
+
+/**
+ * A line (a session with its file descriptor) registered to a reactor.
+ */
+typedef struct textalk_reactor_line_t textalk_reactor_line_t;
+
+/**
+ * @class textalk_reactor_t
+ * @brief Drive protocol exchanges of many sessions on one thread.
+ *
+ * @remarks A reactor is not thread-safe,
+ *          all functions of it should be called from the same thread
+ *          (except textalk_reactor_wakeup);
+ *          use one reactor per thread to scale on more cores.
+ */
+typedef struct textalk_reactor_t
+{
+    int epfd;
+    int wakefd;
+
+    textalk_reactor_line_t *lines;
+    size_t                  linecount;
+    textalk_reactor_line_t *removed;    // Lines removed by callbacks, to be freed when idle.
+    unsigned                busy;       // Depth of calls that may call back the user.
+
+    textalk_reactor_line_t **timers;    // Lines with deadlines, in a min-heap.
+    size_t                   timercount;
+    size_t                   timercap;
+} textalk_reactor_t;
+
+int  textalk_reactor_init(textalk_reactor_t *self);
+void textalk_reactor_deinit(textalk_reactor_t *self);
+
+textalk_reactor_line_t* textalk_reactor_add(textalk_reactor_t         *self,
+                                            textalk_t                 *session,
+                                            int                        fd,
+                                            textalk_reactor_on_done_t  on_done);
+void textalk_reactor_remove(textalk_reactor_t *self, textalk_reactor_line_t *line);
+int  textalk_reactor_set_codec(textalk_reactor_t      *self,
+                               textalk_reactor_line_t *line,
+                               const textalk_codec_t  *codec);
+void textalk_reactor_set_on_text(textalk_reactor_t         *self,
+                                 textalk_reactor_line_t    *line,
+                                 textalk_reactor_on_text_t  on_text);
+
+int textalk_reactor_send_text(textalk_reactor_t      *self,
+                              textalk_reactor_line_t *line,
+                              const char             *text,
+                              bool                    havemore);
+
+int  textalk_reactor_run_once(textalk_reactor_t *self, unsigned timeout);
+void textalk_reactor_wakeup(textalk_reactor_t *self);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
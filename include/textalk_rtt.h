@@ -0,0 +1,50 @@
+/**
+ * @file
+ * @brief     Text communication library - round-trip time estimator.
+ * @author    王文佑
+ * @date      2026/10/17
+ * @copyright ZLib Licence
+ */
+#ifndef _TEXTALK_RTT_H_
+#define _TEXTALK_RTT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "textalk_conf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @class textalk_rtt_t
+ * @brief Round-trip time estimator.
+ * @details The echo time-out is derived from the smoothed round-trip time
+ *          and its mean deviation (Jacobson/Karels),
+ *          and it will be doubled for each retry (exponential backoff).
+ *          The results are clamped between textalk_conf_timeout_t::echo_min
+ *          (or the floor derived from textalk_conf_timeout_t::char_time if it is ZERO)
+ *          and textalk_conf_timeout_t::echo.
+ */
+typedef struct textalk_rtt_t
+{
+    bool     adaptive;
+    unsigned min;
+    unsigned max;
+
+    bool     measured;
+    unsigned srtt;      // Smoothed round-trip time, scaled by 8.
+    unsigned rttvar;    // Mean deviation of the round-trip time, scaled by 4.
+    unsigned rto;       // The echo time-out of the first try.
+} textalk_rtt_t;
+
+void     textalk_rtt_init(textalk_rtt_t *self, const textalk_conf_comm_t *conf);
+void     textalk_rtt_reset(textalk_rtt_t *self);
+void     textalk_rtt_update(textalk_rtt_t *self, unsigned rtt);
+unsigned textalk_rtt_get_timeout(const textalk_rtt_t *self, unsigned tries);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
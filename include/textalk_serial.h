@@ -0,0 +1,54 @@
+/**
+ * @file
+ * @brief     Text communication library - POSIX serial port transport.
+ * @author    王文佑
+ * @date      2026/10/17
+ * @copyright ZLib Licence
+ */
+#ifndef _TEXTALK_SERIAL_H_
+#define _TEXTALK_SERIAL_H_
+
+#include <stddef.h>
+#include "textalk_event.h"
+#include "textalk_errcode.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @class textalk_serial_t
+ * @brief Serial port transport of the text talk sessions.
+ *
+ * @remarks The parity bit of each character is handled by the text talk
+ *          session itself (see textalk_conf_comm_t::parity),
+ *          so the port always be configured to raw mode with
+ *          8 data bits, no hardware parity, and 1 stop bit;
+ *          that is the same as 7 data bits with parity on the wire.
+ */
+typedef struct textalk_serial_t
+{
+    int fd;
+} textalk_serial_t;
+
+void textalk_serial_init(textalk_serial_t *self);
+void textalk_serial_deinit(textalk_serial_t *self);
+
+int  textalk_serial_open(textalk_serial_t *self, const char *path, unsigned baudrate);
+int  textalk_serial_open_loopback(textalk_serial_t *self, textalk_serial_t *peer);
+void textalk_serial_close(textalk_serial_t *self);
+
+int textalk_serial_get_fd(const textalk_serial_t *self);
+
+void textalk_serial_fill_events(textalk_serial_t *self, textalk_events_t *events);
+
+int textalk_serial_sender(void *userarg, const void *data, size_t size);
+int textalk_serial_sendv(void *userarg, const textalk_iovec_t *iov, int iovcnt);
+int textalk_serial_recver(void *userarg, void *buf, size_t size);
+int textalk_serial_waiter(void *userarg, int flags, unsigned timeout);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
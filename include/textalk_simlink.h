@@ -0,0 +1,133 @@
+/**
+ * @file
+ * @brief     Text communication library - simulated serial link.
+ * @author    王文佑
+ * @date      2026/10/17
+ * @copyright ZLib Licence
+ */
+#ifndef _TEXTALK_SIMLINK_H_
+#define _TEXTALK_SIMLINK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "textalk_event.h"
+#include "textalk_errcode.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TEXTALK_SIMLINK_QUEUE_SIZE 4096     // The maximum count of characters on the way of a direction.
+
+/**
+ * Simulated link configuration, for each direction.
+ */
+typedef struct textalk_simlink_conf_t
+{
+    unsigned baudrate;      ///< Bits per second, and ZERO for infinite speed.
+    unsigned charbits;      ///< Bits of a character on the line (start, data, parity, and stop bits),
+                            ///< and ZERO to use 10.
+    unsigned delay;         ///< Propagation delay in microseconds.
+    double   bit_error;     ///< Probability of each data bit be flipped.
+    double   drop;          ///< Probability of each character be lost.
+    double   burst;         ///< Probability of a noise burst start at each character.
+    unsigned burst_len;     ///< Count of characters be corrupted by a noise burst.
+    uint32_t seed;          ///< Seed of the random generator, the same seed gives the same errors.
+} textalk_simlink_conf_t;
+
+/**
+ * Simulated link counters, for each direction.
+ */
+typedef struct textalk_simlink_stats_t
+{
+    uint64_t chars;         ///< Characters sent.
+    uint64_t dropped;       ///< Characters lost.
+    uint64_t corrupted;     ///< Characters changed by bit errors or noise bursts.
+} textalk_simlink_stats_t;
+
+struct textalk_simlink_t;
+
+/*
+ * A direction of the link, from the end point of the same index.
+ */
+typedef struct textalk_simlink_dir_t
+{
+    textalk_simlink_conf_t  conf;
+    textalk_simlink_stats_t stats;
+
+    uint64_t chartime;      // Time to transmit a character in nanoseconds.
+    uint64_t linefree;      // Time that the transmitter finishes the last character.
+    uint32_t random;        // State of the random generator.
+    unsigned burstremain;   // Count of characters remaining in the current burst.
+
+    char     chars[TEXTALK_SIMLINK_QUEUE_SIZE];
+    uint64_t arrivals[TEXTALK_SIMLINK_QUEUE_SIZE];
+    size_t   head;
+    size_t   size;
+} textalk_simlink_dir_t;
+
+/*
+ * An end point of the link.
+ */
+typedef struct textalk_simlink_end_t
+{
+    struct textalk_simlink_t *link;
+    int                       index;
+    bool                      attached;     // A session is driving this end point.
+    bool                      waiting;      // The session is blocked in the waiter.
+    int                       waitflags;
+    uint64_t                  deadline;     // Time that the waiting ends.
+} textalk_simlink_end_t;
+
+/**
+ * @class textalk_simlink_t
+ * @brief Simulated serial link.
+ * @details Two end points of the link send characters to each other,
+ *          with transmit time by the baud rate, propagation delay,
+ *          and errors generated by a seeded random generator.
+ *
+ *          The link runs on a virtual clock,
+ *          and the clock only goes when all sessions attached are blocked in the waiter.
+ *          It then jumps to the nearest time that something can happen,
+ *          so the simulation runs faster than real time,
+ *          and timings are reproducible no matter how the threads be scheduled.
+ *
+ * @remarks Each end point should be driven by one session on its own thread,
+ *          and be detached when the session does not use it any more,
+ *          or the clock will be stopped forever.
+ *          Both end points should be attached before the sessions start,
+ *          or the clock could run away with the one attached first.
+ */
+typedef struct textalk_simlink_t
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    uint64_t        now;    // The virtual time in nanoseconds.
+
+    textalk_simlink_dir_t dirs[2];
+    textalk_simlink_end_t ends[2];
+} textalk_simlink_t;
+
+void textalk_simlink_init(textalk_simlink_t            *self,
+                          const textalk_simlink_conf_t *conf0,
+                          const textalk_simlink_conf_t *conf1);
+void textalk_simlink_deinit(textalk_simlink_t *self);
+
+void textalk_simlink_attach(textalk_simlink_t *self, int index, textalk_events_t *events);
+void textalk_simlink_detach(textalk_simlink_t *self, int index);
+
+unsigned textalk_simlink_get_time(textalk_simlink_t *self);
+void     textalk_simlink_get_stats(textalk_simlink_t *self, int index, textalk_simlink_stats_t *stats);
+
+int      textalk_simlink_sender(void *userarg, const void *data, size_t size);
+int      textalk_simlink_recver(void *userarg, void *buf, size_t size);
+int      textalk_simlink_waiter(void *userarg, int flags, unsigned timeout);
+unsigned textalk_simlink_clock(void *userarg);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
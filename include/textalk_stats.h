@@ -0,0 +1,74 @@
+/**
+ * @file
+ * @brief     Text communication library - session metrics.
+ * @author    王文佑
+ * @date      2026/10/17
+ * @copyright ZLib Licence
+ */
+#ifndef _TEXTALK_STATS_H_
+#define _TEXTALK_STATS_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TEXTALK_HIST_SIZE 16    // The count of buckets of a histogram.
+
+/**
+ * @class textalk_hist_t
+ * @brief Histogram of times in milliseconds with log-scaled buckets.
+ * @details Bucket ZERO counts times less than 1 ms,
+ *          bucket N counts times from 2^(N-1) to 2^N - 1 ms,
+ *          and the last bucket counts all times longer.
+ */
+typedef struct textalk_hist_t
+{
+    uint64_t count[TEXTALK_HIST_SIZE];  ///< Count of samples in each bucket.
+    uint64_t total;                     ///< Count of all samples.
+    uint64_t sum;                       ///< Sum of all samples in milliseconds.
+    unsigned max;                       ///< The maximum sample in milliseconds.
+} textalk_hist_t;
+
+void     textalk_hist_reset(textalk_hist_t *self);
+void     textalk_hist_add(textalk_hist_t *self, unsigned ms);
+unsigned textalk_hist_get_percentile(const textalk_hist_t *self, unsigned percent);
+
+/**
+ * Counters of a session.
+ */
+typedef struct textalk_stats_t
+{
+    uint64_t tx_bytes;          ///< Bytes sent, including control codes.
+    uint64_t rx_bytes;          ///< Bytes received, including control codes and noise.
+    uint64_t tx_frames;         ///< Packets sent, including the packets sent again.
+    uint64_t rx_frames;         ///< Packets received, including the bad ones.
+    uint64_t retries;           ///< Packets sent again after NAK or echo time-out.
+
+    uint64_t nak_sent;          ///< NAK sent.
+    uint64_t nak_recv;          ///< NAK received.
+    uint64_t eot_sent;          ///< EOT sent (exchanges terminated by this side).
+    uint64_t eot_recv;          ///< EOT received (exchanges terminated by remote).
+
+    uint64_t err_parity;        ///< Packets failed on the parity check.
+    uint64_t err_lrc;           ///< Packets failed on the LRC check.
+    uint64_t err_integrity;     ///< Packets with STX, ETX, or ETB broken; or too long.
+
+    uint64_t timeout_send;      ///< Time-outs on sending data.
+    uint64_t timeout_echo;      ///< Time-outs on waiting echoes.
+    uint64_t timeout_resp;      ///< Time-outs on waiting the start of a packet.
+    uint64_t timeout_frame;     ///< Time-outs on waiting the rest of a packet.
+
+    textalk_hist_t rtt;         ///< Time from a packet sent to its ACK received,
+                                ///< packets sent again are not measured.
+    textalk_hist_t rx_time;     ///< Time from STX to the end of a packet received.
+} textalk_stats_t;
+
+void textalk_stats_reset(textalk_stats_t *self);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ * @file
+ * @brief     Text communication library - protocol trace.
+ * @author    王文佑
+ * @date      2026/10/17
+ * @copyright ZLib Licence
+ */
+#ifndef _TEXTALK_TRACE_H_
+#define _TEXTALK_TRACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Trace record types.
+ */
+enum textalk_trace_type_t
+{
+    TEXTALK_TRACE_NONE = 0,
+    TEXTALK_TRACE_SEND_CTRL,        ///< A control code sent.
+    TEXTALK_TRACE_RECV_CTRL,        ///< A control code received.
+    TEXTALK_TRACE_SEND_FRAME,       ///< A packet sent, and the length is the packet size.
+    TEXTALK_TRACE_RECV_FRAME,       ///< A packet received, and the length is the packet size.
+    TEXTALK_TRACE_BAD_FRAME,        ///< A packet received but broken,
+                                    ///< and the error code tells why.
+    TEXTALK_TRACE_TIMEOUT_SEND,     ///< Time-out on sending data.
+    TEXTALK_TRACE_TIMEOUT_ECHO,     ///< Time-out on waiting an echo.
+    TEXTALK_TRACE_TIMEOUT_RESP,     ///< Time-out on waiting a packet.
+};
+
+/**
+ * A trace record.
+ */
+typedef struct textalk_trace_rec_t
+{
+    uint32_t seq;       ///< Sequence of the record, start from ZERO.
+    uint32_t time;      ///< Time of the event in milliseconds of the session clock.
+    uint32_t len;       ///< Length of the packet.
+    int16_t  errcode;   ///< One of error codes defined in ::textalk_errcode_t.
+    uint8_t  type;      ///< Record type, see ::textalk_trace_type_t.
+    uint8_t  ctrl;      ///< The control code.
+} textalk_trace_rec_t;
+
+/**
+ * @class textalk_trace_t
+ * @brief Lock-free trace ring.
+ * @details Records are written by the session without locks or system calls,
+ *          and the oldest records will be overwritten when the ring is full.
+ *          Records can be read by another thread at the same time,
+ *          and records overwritten during the reading will be dropped
+ *          (and it can be found by the gap of sequences).
+ *
+ * @remarks There should be only one writer of a ring.
+ */
+typedef struct textalk_trace_t
+{
+    textalk_trace_rec_t *recs;
+    uint32_t             mask;
+    uint32_t             head;  // Count of records written, accessed atomically.
+} textalk_trace_t;
+
+int      textalk_trace_init(textalk_trace_t *self, textalk_trace_rec_t *recs, size_t count);
+void     textalk_trace_put(textalk_trace_t *self,
+                           unsigned         time,
+                           int              type,
+                           char             ctrl,
+                           size_t           len,
+                           int              errcode);
+size_t   textalk_trace_read(const textalk_trace_t *self,
+                            uint32_t              *cursor,
+                            textalk_trace_rec_t   *recs,
+                            size_t                 count);
+uint32_t textalk_trace_get_head(const textalk_trace_t *self);
+
+const char* textalk_trace_type_to_str(int type);
+size_t      textalk_trace_format(const textalk_trace_rec_t *rec, char *buf, size_t bufsz);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
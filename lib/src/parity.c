@@ -0,0 +1,492 @@
+#include "parity.h"
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+    #define PARITY_HAVE_X86_KERNELS
+    #include <immintrin.h>
+#endif
+
+#define P2(n) n, n^1, n^1, n
+#define P4(n) P2(n), P2(n^1), P2(n^1), P2(n)
+#define P6(n) P4(n), P4(n^1), P4(n^1), P4(n)
+
+const unsigned char parity_odd_bits[256] = { P6(0), P6(1), P6(1), P6(0) };
+
+#undef P6
+#undef P4
+#undef P2
+
+/*
+ * Kernels take the parity type as a flag:
+ * 1 for odd parity, and 0 for even parity.
+ */
+typedef void(*add_kernel_t)(char *arr, size_t len, int odd);
+typedef bool(*check_kernel_t)(const char *arr, size_t len, int odd);
+typedef void(*remove_kernel_t)(char *arr, size_t len);
+typedef char(*copy_add_kernel_t)(char *dst, const char *src, size_t len, int odd_even);
+typedef char(*copy_remove_kernel_t)(char       *dst,
+                                    const char *src,
+                                    size_t      len,
+                                    int         odd_even,
+                                    bool       *parity_ok);
+
+typedef struct kernels_t
+{
+    add_kernel_t         add;
+    check_kernel_t       check;
+    remove_kernel_t      remove;
+    copy_add_kernel_t    copy_add;
+    copy_remove_kernel_t copy_remove;
+} kernels_t;
+
+//------------------------------------------------------------------------------
+static
+void add_table(char *arr, size_t len, int odd)
+{
+    for(; len; --len, ++arr)
+    {
+        unsigned char ch = *arr;
+        *arr = ch | ( ( parity_odd_bits[ ch & 0x7F ] ^ odd ) << 7 );
+    }
+}
+//------------------------------------------------------------------------------
+static
+bool check_table(const char *arr, size_t len, int odd)
+{
+    unsigned char bad = 0;
+    for(; len; --len, ++arr)
+        bad |= parity_odd_bits[ (unsigned char) *arr ] ^ odd;
+
+    return !bad;
+}
+//------------------------------------------------------------------------------
+static
+void remove_table(char *arr, size_t len)
+{
+    for(; len; --len, ++arr)
+        *arr = parity_ch_remove(*arr);
+}
+//------------------------------------------------------------------------------
+static
+char copy_add_table(char *dst, const char *src, size_t len, int odd_even)
+{
+    unsigned char sum = 0;
+
+    if( !odd_even )
+    {
+        for(; len; --len)
+            sum ^= *dst++ = *src++;
+    }
+    else
+    {
+        int odd = odd_even & 0x01;
+        for(; len; --len)
+        {
+            unsigned char ch = *src++;
+            ch |= ( parity_odd_bits[ ch & 0x7F ] ^ odd ) << 7;
+            sum ^= *dst++ = ch;
+        }
+    }
+
+    return sum;
+}
+//------------------------------------------------------------------------------
+static
+char copy_remove_table(char *dst, const char *src, size_t len, int odd_even, bool *parity_ok)
+{
+    unsigned char sum = 0;
+    unsigned char bad = 0;
+
+    if( !odd_even )
+    {
+        for(; len; --len)
+            sum ^= *dst++ = *src++;
+    }
+    else
+    {
+        int odd = odd_even & 0x01;
+        for(; len; --len)
+        {
+            unsigned char ch = *src++;
+            bad  |= parity_odd_bits[ch] ^ odd;
+            sum  ^= ch;
+            *dst++ = ch & 0x7F;
+        }
+    }
+
+    *parity_ok = !bad;
+    return sum;
+}
+//------------------------------------------------------------------------------
+#ifdef PARITY_HAVE_X86_KERNELS
+/*
+ * The parity of each byte be folded to its lowest bit by
+ * x ^= x >> 4; x ^= x >> 2; x ^= x >> 1;
+ * 16-bit shifts are fine here, because bits that cross into the byte from its
+ * neighbour never reach the lowest bit.
+ */
+__attribute__((target("sse2")))
+static
+__m128i fold_sse2(__m128i x)
+{
+    x = _mm_xor_si128(x, _mm_srli_epi16(x, 4));
+    x = _mm_xor_si128(x, _mm_srli_epi16(x, 2));
+    x = _mm_xor_si128(x, _mm_srli_epi16(x, 1));
+    return _mm_and_si128(x, _mm_set1_epi8(0x01));
+}
+//------------------------------------------------------------------------------
+__attribute__((target("sse2")))
+static
+void add_sse2(char *arr, size_t len, int odd)
+{
+    const __m128i mask7 = _mm_set1_epi8(0x7F);
+    const __m128i flip  = _mm_set1_epi8(odd);
+
+    for(; len >= 16; len -= 16, arr += 16)
+    {
+        __m128i data = _mm_loadu_si128((const __m128i*) arr);
+        __m128i bit  = _mm_xor_si128(fold_sse2(_mm_and_si128(data, mask7)), flip);
+        _mm_storeu_si128((__m128i*) arr, _mm_or_si128(data, _mm_slli_epi16(bit, 7)));
+    }
+
+    add_table(arr, len, odd);
+}
+//------------------------------------------------------------------------------
+__attribute__((target("sse2")))
+static
+bool check_sse2(const char *arr, size_t len, int odd)
+{
+    const __m128i flip = _mm_set1_epi8(odd);
+
+    __m128i bad = _mm_setzero_si128();
+    for(; len >= 16; len -= 16, arr += 16)
+    {
+        __m128i data = _mm_loadu_si128((const __m128i*) arr);
+        bad = _mm_or_si128(bad, _mm_xor_si128(fold_sse2(data), flip));
+    }
+
+    if( _mm_movemask_epi8(_mm_cmpeq_epi8(bad, _mm_setzero_si128())) != 0xFFFF )
+        return false;
+
+    return check_table(arr, len, odd);
+}
+//------------------------------------------------------------------------------
+__attribute__((target("sse2")))
+static
+void remove_sse2(char *arr, size_t len)
+{
+    const __m128i mask7 = _mm_set1_epi8(0x7F);
+
+    for(; len >= 16; len -= 16, arr += 16)
+    {
+        __m128i data = _mm_loadu_si128((const __m128i*) arr);
+        _mm_storeu_si128((__m128i*) arr, _mm_and_si128(data, mask7));
+    }
+
+    remove_table(arr, len);
+}
+//------------------------------------------------------------------------------
+__attribute__((target("sse2")))
+static
+char xor_reduce_sse2(__m128i x)
+{
+    x = _mm_xor_si128(x, _mm_srli_si128(x, 8));
+    x = _mm_xor_si128(x, _mm_srli_si128(x, 4));
+    x = _mm_xor_si128(x, _mm_srli_si128(x, 2));
+    x = _mm_xor_si128(x, _mm_srli_si128(x, 1));
+    return _mm_cvtsi128_si32(x);
+}
+//------------------------------------------------------------------------------
+__attribute__((target("sse2")))
+static
+char copy_add_sse2(char *dst, const char *src, size_t len, int odd_even)
+{
+    const __m128i mask7 = _mm_set1_epi8(0x7F);
+    const __m128i flip  = _mm_set1_epi8(odd_even & 0x01);
+
+    __m128i sum = _mm_setzero_si128();
+    for(; len >= 16; len -= 16, src += 16, dst += 16)
+    {
+        __m128i data = _mm_loadu_si128((const __m128i*) src);
+        if( odd_even )
+        {
+            __m128i bit = _mm_xor_si128(fold_sse2(_mm_and_si128(data, mask7)), flip);
+            data = _mm_or_si128(data, _mm_slli_epi16(bit, 7));
+        }
+
+        _mm_storeu_si128((__m128i*) dst, data);
+        sum = _mm_xor_si128(sum, data);
+    }
+
+    return xor_reduce_sse2(sum) ^ copy_add_table(dst, src, len, odd_even);
+}
+//------------------------------------------------------------------------------
+__attribute__((target("sse2")))
+static
+char copy_remove_sse2(char *dst, const char *src, size_t len, int odd_even, bool *parity_ok)
+{
+    const __m128i mask7 = _mm_set1_epi8(odd_even ? 0x7F : 0xFF);
+    const __m128i flip  = _mm_set1_epi8(odd_even & 0x01);
+
+    __m128i sum = _mm_setzero_si128();
+    __m128i bad = _mm_setzero_si128();
+    for(; len >= 16; len -= 16, src += 16, dst += 16)
+    {
+        __m128i data = _mm_loadu_si128((const __m128i*) src);
+        if( odd_even )
+            bad = _mm_or_si128(bad, _mm_xor_si128(fold_sse2(data), flip));
+
+        sum = _mm_xor_si128(sum, data);
+        _mm_storeu_si128((__m128i*) dst, _mm_and_si128(data, mask7));
+    }
+
+    bool tail_ok;
+    char tail_sum = copy_remove_table(dst, src, len, odd_even, &tail_ok);
+
+    *parity_ok = tail_ok &&
+                 _mm_movemask_epi8(_mm_cmpeq_epi8(bad, _mm_setzero_si128())) == 0xFFFF;
+    return xor_reduce_sse2(sum) ^ tail_sum;
+}
+//------------------------------------------------------------------------------
+__attribute__((target("avx2")))
+static
+__m256i fold_avx2(__m256i x)
+{
+    x = _mm256_xor_si256(x, _mm256_srli_epi16(x, 4));
+    x = _mm256_xor_si256(x, _mm256_srli_epi16(x, 2));
+    x = _mm256_xor_si256(x, _mm256_srli_epi16(x, 1));
+    return _mm256_and_si256(x, _mm256_set1_epi8(0x01));
+}
+//------------------------------------------------------------------------------
+__attribute__((target("avx2")))
+static
+void add_avx2(char *arr, size_t len, int odd)
+{
+    const __m256i mask7 = _mm256_set1_epi8(0x7F);
+    const __m256i flip  = _mm256_set1_epi8(odd);
+
+    for(; len >= 32; len -= 32, arr += 32)
+    {
+        __m256i data = _mm256_loadu_si256((const __m256i*) arr);
+        __m256i bit  = _mm256_xor_si256(fold_avx2(_mm256_and_si256(data, mask7)), flip);
+        _mm256_storeu_si256((__m256i*) arr, _mm256_or_si256(data, _mm256_slli_epi16(bit, 7)));
+    }
+
+    add_sse2(arr, len, odd);
+}
+//------------------------------------------------------------------------------
+__attribute__((target("avx2")))
+static
+bool check_avx2(const char *arr, size_t len, int odd)
+{
+    const __m256i flip = _mm256_set1_epi8(odd);
+
+    __m256i bad = _mm256_setzero_si256();
+    for(; len >= 32; len -= 32, arr += 32)
+    {
+        __m256i data = _mm256_loadu_si256((const __m256i*) arr);
+        bad = _mm256_or_si256(bad, _mm256_xor_si256(fold_avx2(data), flip));
+    }
+
+    if( !_mm256_testz_si256(bad, bad) )
+        return false;
+
+    return check_sse2(arr, len, odd);
+}
+//------------------------------------------------------------------------------
+__attribute__((target("avx2")))
+static
+void remove_avx2(char *arr, size_t len)
+{
+    const __m256i mask7 = _mm256_set1_epi8(0x7F);
+
+    for(; len >= 32; len -= 32, arr += 32)
+    {
+        __m256i data = _mm256_loadu_si256((const __m256i*) arr);
+        _mm256_storeu_si256((__m256i*) arr, _mm256_and_si256(data, mask7));
+    }
+
+    remove_sse2(arr, len);
+}
+//------------------------------------------------------------------------------
+__attribute__((target("avx2")))
+static
+char copy_add_avx2(char *dst, const char *src, size_t len, int odd_even)
+{
+    const __m256i mask7 = _mm256_set1_epi8(0x7F);
+    const __m256i flip  = _mm256_set1_epi8(odd_even & 0x01);
+
+    __m256i sum = _mm256_setzero_si256();
+    for(; len >= 32; len -= 32, src += 32, dst += 32)
+    {
+        __m256i data = _mm256_loadu_si256((const __m256i*) src);
+        if( odd_even )
+        {
+            __m256i bit = _mm256_xor_si256(fold_avx2(_mm256_and_si256(data, mask7)), flip);
+            data = _mm256_or_si256(data, _mm256_slli_epi16(bit, 7));
+        }
+
+        _mm256_storeu_si256((__m256i*) dst, data);
+        sum = _mm256_xor_si256(sum, data);
+    }
+
+    __m128i half = _mm_xor_si128(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    return xor_reduce_sse2(half) ^ copy_add_sse2(dst, src, len, odd_even);
+}
+//------------------------------------------------------------------------------
+__attribute__((target("avx2")))
+static
+char copy_remove_avx2(char *dst, const char *src, size_t len, int odd_even, bool *parity_ok)
+{
+    const __m256i mask7 = _mm256_set1_epi8(odd_even ? 0x7F : 0xFF);
+    const __m256i flip  = _mm256_set1_epi8(odd_even & 0x01);
+
+    __m256i sum = _mm256_setzero_si256();
+    __m256i bad = _mm256_setzero_si256();
+    for(; len >= 32; len -= 32, src += 32, dst += 32)
+    {
+        __m256i data = _mm256_loadu_si256((const __m256i*) src);
+        if( odd_even )
+            bad = _mm256_or_si256(bad, _mm256_xor_si256(fold_avx2(data), flip));
+
+        sum = _mm256_xor_si256(sum, data);
+        _mm256_storeu_si256((__m256i*) dst, _mm256_and_si256(data, mask7));
+    }
+
+    bool tail_ok;
+    char tail_sum = copy_remove_sse2(dst, src, len, odd_even, &tail_ok);
+
+    __m128i half = _mm_xor_si128(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    *parity_ok = tail_ok && _mm256_testz_si256(bad, bad);
+    return xor_reduce_sse2(half) ^ tail_sum;
+}
+#endif  // PARITY_HAVE_X86_KERNELS
+//------------------------------------------------------------------------------
+static const kernels_t table_kernels =
+{
+    .add         = add_table,
+    .check       = check_table,
+    .remove      = remove_table,
+    .copy_add    = copy_add_table,
+    .copy_remove = copy_remove_table,
+};
+
+#ifdef PARITY_HAVE_X86_KERNELS
+static const kernels_t sse2_kernels =
+{
+    .add         = add_sse2,
+    .check       = check_sse2,
+    .remove      = remove_sse2,
+    .copy_add    = copy_add_sse2,
+    .copy_remove = copy_remove_sse2,
+};
+
+static const kernels_t avx2_kernels =
+{
+    .add         = add_avx2,
+    .check       = check_avx2,
+    .remove      = remove_avx2,
+    .copy_add    = copy_add_avx2,
+    .copy_remove = copy_remove_avx2,
+};
+#endif
+
+/*
+ * The kernel set be selected at the first call,
+ * and be published by an atomic store because sessions may run on many threads.
+ * The selection gives the same result on every thread,
+ * so threads racing at the first call only store the same value more than once.
+ */
+static const kernels_t *kernels = NULL;
+
+//------------------------------------------------------------------------------
+static
+const kernels_t* find_kernels(int kernel)
+{
+    switch( kernel )
+    {
+    case PARITY_KERNEL_TABLE:
+        return &table_kernels;
+
+#ifdef PARITY_HAVE_X86_KERNELS
+    case PARITY_KERNEL_SSE2:
+        __builtin_cpu_init();
+        return ( __builtin_cpu_supports("sse2") )?( &sse2_kernels ):( NULL );
+
+    case PARITY_KERNEL_AVX2:
+        __builtin_cpu_init();
+        return ( __builtin_cpu_supports("avx2") )?( &avx2_kernels ):( NULL );
+
+    case PARITY_KERNEL_AUTO:
+        __builtin_cpu_init();
+        if( __builtin_cpu_supports("avx2") ) return &avx2_kernels;
+        if( __builtin_cpu_supports("sse2") ) return &sse2_kernels;
+        return &table_kernels;
+#else
+    case PARITY_KERNEL_AUTO:
+        return &table_kernels;
+#endif
+
+    default:
+        return NULL;
+    }
+}
+//------------------------------------------------------------------------------
+static inline
+const kernels_t* get_kernels(void)
+{
+    const kernels_t *found = __atomic_load_n(&kernels, __ATOMIC_ACQUIRE);
+    if( found ) return found;
+
+    found = find_kernels(PARITY_KERNEL_AUTO);
+    __atomic_store_n(&kernels, found, __ATOMIC_RELEASE);
+    return found;
+}
+//------------------------------------------------------------------------------
+bool parity_select_kernel(int kernel)
+{
+    const kernels_t *found = find_kernels(kernel);
+    if( !found ) return false;
+
+    __atomic_store_n(&kernels, found, __ATOMIC_RELEASE);
+    return true;
+}
+//------------------------------------------------------------------------------
+void parity_arr_add_odd(char *arr, size_t len)
+{
+    get_kernels()->add(arr, len, 1);
+}
+//------------------------------------------------------------------------------
+void parity_arr_add_even(char *arr, size_t len)
+{
+    get_kernels()->add(arr, len, 0);
+}
+//------------------------------------------------------------------------------
+bool parity_arr_check_odd(const char *arr, size_t len)
+{
+    return get_kernels()->check(arr, len, 1);
+}
+//------------------------------------------------------------------------------
+bool parity_arr_check_even(const char *arr, size_t len)
+{
+    return get_kernels()->check(arr, len, 0);
+}
+//------------------------------------------------------------------------------
+void parity_arr_remove_bits(char *arr, size_t len)
+{
+    get_kernels()->remove(arr, len);
+}
+//------------------------------------------------------------------------------
+char parity_arr_copy_add(char *dst, const char *src, size_t len, int odd_even)
+{
+    return get_kernels()->copy_add(dst, src, len, odd_even);
+}
+//------------------------------------------------------------------------------
+char parity_arr_copy_remove(char       *dst,
+                            const char *src,
+                            size_t      len,
+                            int         odd_even,
+                            bool       *parity_ok)
+{
+    return get_kernels()->copy_remove(dst, src, len, odd_even, parity_ok);
+}
+//------------------------------------------------------------------------------
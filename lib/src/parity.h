@@ -6,22 +6,23 @@
 
 #include <stddef.h>
 #include <stdbool.h>
-#include <gen/bits.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+extern const unsigned char parity_odd_bits[256];  // Non-zero if a byte have odd count of bits set.
+
 static inline
 char parity_ch_add_odd(char ch)
 {
-    return ( bits_count_bits_8( ch & 0x7F ) & 0x01 )?( ch ):( ch | 0x80 );
+    return ( parity_odd_bits[ ch & 0x7F ] )?( ch ):( ch | 0x80 );
 }
 
 static inline
 char parity_ch_add_even(char ch)
 {
-    return ( bits_count_bits_8( ch & 0x7F ) & 0x01 )?( ch | 0x80 ):( ch );
+    return ( parity_odd_bits[ ch & 0x7F ] )?( ch | 0x80 ):( ch );
 }
 
 static inline
@@ -42,62 +43,87 @@ char parity_ch_remove(char ch)
 }
 
 static inline
-void parity_arr_add_odd(char *arr, size_t len)
+bool parity_ch_check_odd(char ch)
 {
-    for(; len; --len, ++arr)
-        *arr = parity_ch_add_odd(*arr);
+    return parity_odd_bits[ (unsigned char) ch ];
 }
 
 static inline
-void parity_arr_add_even(char *arr, size_t len)
+bool parity_ch_check_even(char ch)
 {
-    for(; len; --len, ++arr)
-        *arr = parity_ch_add_even(*arr);
+    return !parity_odd_bits[ (unsigned char) ch ];
 }
 
 static inline
-void parity_arr_add(char *arr, size_t len, int odd_even)
+bool parity_ch_check(char ch, int odd_even)
 {
     if( !odd_even )
-        (void)0;  // Nothing to do.
+        return true;
     else if( odd_even & 0x01 )
-        return parity_arr_add_odd(arr, len);
+        return parity_ch_check_odd(ch);
     else
-        return parity_arr_add_even(arr, len);
+        return parity_ch_check_even(ch);
 }
 
-static inline
-void parity_arr_remove(char *arr, size_t len, int odd_even)
+/*
+ * Array functions below select the fastest kernel (AVX2, SSE2, or table look-up)
+ * supported by the running CPU at the first call.
+ */
+
+enum
 {
-    if( odd_even )
-    {
-        for(; len; --len, ++arr)
-            *arr = parity_ch_remove(*arr);
-    }
-}
+    PARITY_KERNEL_AUTO,     // The fastest one supported.
+    PARITY_KERNEL_TABLE,
+    PARITY_KERNEL_SSE2,
+    PARITY_KERNEL_AVX2,
+};
+
+/*
+ * Force array functions to use a kernel (for tests and benchmarks),
+ * and returns FALSE if it is not supported by the running CPU.
+ */
+bool parity_select_kernel(int kernel);
+
+void parity_arr_add_odd(char *arr, size_t len);
+void parity_arr_add_even(char *arr, size_t len);
+void parity_arr_remove_bits(char *arr, size_t len);
+bool parity_arr_check_odd(const char *arr, size_t len);
+bool parity_arr_check_even(const char *arr, size_t len);
+
+/*
+ * Copy characters with parity added (or just copy if odd_even is ZERO),
+ * and returns XOR of all characters written.
+ */
+char parity_arr_copy_add(char *dst, const char *src, size_t len, int odd_even);
+
+/*
+ * Check parity of characters and copy them with parity removed
+ * (or just copy if odd_even is ZERO),
+ * and returns XOR of all characters read.
+ * The destination can be the same as the source to work in place.
+ */
+char parity_arr_copy_remove(char       *dst,
+                            const char *src,
+                            size_t      len,
+                            int         odd_even,
+                            bool       *parity_ok);
 
 static inline
-bool parity_arr_check_odd(const char *arr, size_t len)
+void parity_arr_add(char *arr, size_t len, int odd_even)
 {
-    for(; len; --len, ++arr)
-    {
-        if( !( bits_count_bits_8(*arr) & 0x01 ) )
-            return false;
-    }
-
-    return true;
+    if( !odd_even )
+        (void)0;  // Nothing to do.
+    else if( odd_even & 0x01 )
+        return parity_arr_add_odd(arr, len);
+    else
+        return parity_arr_add_even(arr, len);
 }
 
 static inline
-bool parity_arr_check_even(const char *arr, size_t len)
+void parity_arr_remove(char *arr, size_t len, int odd_even)
 {
-    for(; len; --len, ++arr)
-    {
-        if( bits_count_bits_8(*arr) & 0x01 )
-            return false;
-    }
-
-    return true;
+    if( odd_even )
+        parity_arr_remove_bits(arr, len);
 }
 
 static inline
@@ -1,12 +1,19 @@
 #include <assert.h>
-#include <ctype.h>
-#include <gen/jmpbk.h>
-#include <gen/bufstm.h>
-#include <gen/timectr.h>
-#include "parity.h"
-#include "textalk_packet.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gen/systime.h>
 #include "textalk.h"
 
+/*
+ * A time-out counter on the clock of the session.
+ */
+typedef struct session_timer_t
+{
+    unsigned start;
+    unsigned timeout;
+} session_timer_t;
+
 //------------------------------------------------------------------------------
 static
 void on_send_ctrl_default(void *userarg, char code)
@@ -32,6 +39,43 @@ void on_recv_text_default(void *userarg, const char *text)
     // Nothing to do.
 }
 //------------------------------------------------------------------------------
+static inline
+unsigned clock_now(const textalk_t *self)
+{
+    return ( self->events.clock )?
+           ( self->events.clock(self->events.userarg) ):( systime_get_clock_count() );
+}
+//------------------------------------------------------------------------------
+static inline
+session_timer_t timer_init(const textalk_t *self, unsigned timeout)
+{
+    session_timer_t timer = { clock_now(self), timeout };
+    return timer;
+}
+//------------------------------------------------------------------------------
+static inline
+unsigned timer_get_remain(const textalk_t *self, const session_timer_t *timer)
+{
+    unsigned passed = clock_now(self) - timer->start;
+    return ( passed < timer->timeout )?( timer->timeout - passed ):( 0 );
+}
+//------------------------------------------------------------------------------
+static inline
+bool timer_is_expired(const textalk_t *self, const session_timer_t *timer)
+{
+    return !timer_get_remain(self, timer);
+}
+//------------------------------------------------------------------------------
+static
+int notify_send_timeout(textalk_t *self)
+{
+    ++self->stats.timeout_send;
+    if( self->trace )
+        textalk_trace_put(self->trace, clock_now(self), TEXTALK_TRACE_TIMEOUT_SEND, 0, 0, TEXTALK_ERR_TIMEOUT);
+
+    return TEXTALK_ERR_TIMEOUT;
+}
+//------------------------------------------------------------------------------
 void textalk_init(textalk_t              *self,
                   const textalk_conf_t   *conf,
                   const textalk_events_t *events)
@@ -44,8 +88,43 @@ void textalk_init(textalk_t              *self,
      * @param conf         Communication configuration,
      *                     and can be NULL to use default values.
      * @param events       A set of event callbacks.
+     *
+     * @remarks Buffers will be allocated by the default allocator,
+     *          use textalk_init_ex to check the result or to use another allocator.
      */
-    self->conf = *conf;
+    textalk_init_ex(self, conf, events, NULL);
+}
+//------------------------------------------------------------------------------
+int textalk_init_ex(textalk_t                 *self,
+                    const textalk_conf_t      *conf,
+                    const textalk_events_t    *events,
+                    const textalk_allocator_t *alloc)
+{
+    /**
+     * @memberof textalk_t
+     * @brief Constructor with an allocator.
+     *
+     * @param self         Object instance.
+     * @param conf         Communication configuration,
+     *                     and can be NULL to use default values.
+     * @param events       A set of event callbacks.
+     * @param alloc        The allocator to allocate buffers of the session,
+     *                     and can be NULL to use the default allocator.
+     *                     Buffers are allocated once here,
+     *                     and their total size is about five times of
+     *                     the maximum packet size;
+     *                     plus one packet size for each packet of the window
+     *                     if the window mode is used.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     *
+     * @remarks The object must be de-initialised by textalk_deinit
+     *          even if this function failed.
+     * @remarks The protocol is run by a non-blocking engine (see textalk_engine_t),
+     *          and the blocking functions only move data and time between the engine
+     *          and the sender, receiver, and waiter of the session.
+     */
+    self->conf  = conf ? *conf : *textalk_conf_get_defaults();
+    self->alloc = alloc ? *alloc : *textalk_allocator_get_defaults();
 
     assert( events->sender && events->recver );
     self->events = *events;
@@ -54,6 +133,29 @@ void textalk_init(textalk_t              *self,
     if( !self->events.on_recv_ctrl ) self->events.on_recv_ctrl = on_recv_ctrl_default;
     if( !self->events.on_send_text ) self->events.on_send_text = on_send_text_default;
     if( !self->events.on_recv_text ) self->events.on_recv_text = on_recv_text_default;
+
+    self->rxbuf   = NULL;
+    self->rxbufsz = 0;
+    self->rxhead  = 0;
+    self->rxsize  = 0;
+
+    textalk_stats_reset(&self->stats);
+    self->trace = NULL;
+
+    int errcode = textalk_engine_init_ex(&self->engine, &self->conf, clock_now(self), &self->alloc);
+    textalk_engine_set_manual_ack(&self->engine, true);
+    textalk_engine_set_vectored(&self->engine, self->events.sendv);
+    textalk_engine_set_stats(&self->engine, &self->stats);
+    if( errcode ) return errcode;
+
+    // The engine fixes some values of the configuration, such as the default packet size.
+    self->conf = self->engine.conf;
+
+    self->rxbuf = self->alloc.alloc(self->alloc.userarg, self->conf.comm.frame_max);
+    if( !self->rxbuf ) return TEXTALK_ERR_BUF_NOT_ENOUGH;
+    self->rxbufsz = self->conf.comm.frame_max;
+
+    return TEXTALK_ERR_SUCCESS;
 }
 //------------------------------------------------------------------------------
 void textalk_deinit(textalk_t *self)
@@ -62,8 +164,222 @@ void textalk_deinit(textalk_t *self)
      * @memberof textalk_t
      * @brief Destructor.
      */
+    if( self->rxbuf && self->alloc.free )
+        self->alloc.free(self->alloc.userarg, self->rxbuf);
 
-    // Nothing to do.
+    textalk_engine_deinit(&self->engine);
+
+    self->rxbuf   = NULL;
+    self->rxbufsz = 0;
+    self->rxsize  = 0;
+}
+//------------------------------------------------------------------------------
+static
+int wait_link_ready(textalk_t *self, int flags, unsigned timeout)
+{
+    if( !self->events.waiter )
+    {
+        systime_sleep_awhile();
+        return TEXTALK_ERR_SUCCESS;
+    }
+
+    return ( self->events.waiter(self->events.userarg, flags, timeout) < 0 )?
+           ( TEXTALK_ERR_STREAM_FAIL ):( TEXTALK_ERR_SUCCESS );
+}
+//------------------------------------------------------------------------------
+static
+int rxbuf_fill(textalk_t *self)
+{
+    /*
+     * Pull as much data as the receiver can give into the free space
+     * (the contiguous part) of the receive buffer.
+     */
+    size_t tail = ( self->rxhead + self->rxsize ) % self->rxbufsz;
+    size_t room = ( tail < self->rxhead || self->rxsize == self->rxbufsz )?
+                  ( self->rxhead - tail ):( self->rxbufsz - tail );
+    if( !room ) return 0;
+
+    int recvsz = self->events.recver(self->events.userarg, self->rxbuf + tail, room);
+    if( recvsz < 0 || room < recvsz ) return -1;
+
+    self->rxsize += recvsz;
+    return recvsz;
+}
+//------------------------------------------------------------------------------
+static
+size_t rxbuf_get_span(const textalk_t *self, const char **span)
+{
+    // Get the contiguous part of data from the read position.
+    size_t tailsz = self->rxbufsz - self->rxhead;
+
+    *span = self->rxbuf + self->rxhead;
+    return ( self->rxsize < tailsz )?( self->rxsize ):( tailsz );
+}
+//------------------------------------------------------------------------------
+static
+void rxbuf_drop(textalk_t *self, size_t size)
+{
+    assert( size <= self->rxsize );
+
+    self->rxhead  = ( self->rxhead + size ) % self->rxbufsz;
+    self->rxsize -= size;
+    if( !self->rxsize ) self->rxhead = 0;
+}
+//------------------------------------------------------------------------------
+static
+void rxbuf_feed(textalk_t *self)
+{
+    // Push data received into the engine until it stops to take events out.
+    const char *span;
+    size_t      spansz;
+    while( ( spansz = rxbuf_get_span(self, &span) ) )
+    {
+        size_t feedsz = textalk_engine_feed(&self->engine, span, spansz);
+        rxbuf_drop(self, feedsz);
+
+        if( feedsz < spansz ) break;
+    }
+}
+//------------------------------------------------------------------------------
+static
+int session_flush(textalk_t *self)
+{
+    // Put out what the link takes now, and the rest waits for the link to be ready.
+    if( self->events.sendv )
+    {
+        textalk_iovec_t iov[3];
+        int             iovcnt;
+        while( ( iovcnt = textalk_engine_peek_vector(&self->engine, iov, 3) ) )
+        {
+            size_t size = 0;
+            for(int i = 0; i < iovcnt; ++i)
+                size += iov[i].size;
+
+            int sendsz = self->events.sendv(self->events.userarg, iov, iovcnt);
+            if( sendsz < 0 || size < sendsz ) return TEXTALK_ERR_STREAM_FAIL;
+            if( !sendsz ) break;
+
+            textalk_engine_drop_output(&self->engine, sendsz);
+        }
+    }
+    else
+    {
+        const void *data;
+        size_t      size;
+        while( ( size = textalk_engine_peek_output(&self->engine, &data) ) )
+        {
+            int sendsz = self->events.sender(self->events.userarg, data, size);
+            if( sendsz < 0 || size < sendsz ) return TEXTALK_ERR_STREAM_FAIL;
+            if( !sendsz ) break;
+
+            textalk_engine_drop_output(&self->engine, sendsz);
+        }
+    }
+
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+static
+void session_notify(textalk_t *self, const textalk_engine_event_t *event)
+{
+    // Control codes exchanged by the engine are reported to the user.
+    switch( event->type )
+    {
+    case TEXTALK_ENGINE_EV_CTRL_SENT:
+        self->events.on_send_ctrl(self->events.userarg, event->ctrl);
+        break;
+
+    case TEXTALK_ENGINE_EV_CTRL:
+    case TEXTALK_ENGINE_EV_CTRL_TAKEN:
+        self->events.on_recv_ctrl(self->events.userarg, event->ctrl);
+        break;
+    }
+}
+//------------------------------------------------------------------------------
+static
+unsigned session_get_wait_time(textalk_t *self, const session_timer_t *timer)
+{
+    // Wait until the timer of the caller or the nearest deadline of the engine.
+    unsigned timeout = ( timer )?( timer_get_remain(self, timer) ):( self->conf.comm.timeout.resp );
+    if( textalk_engine_is_receiving(&self->engine) ) timeout = self->conf.comm.timeout.resp;
+
+    unsigned deadline;
+    if( textalk_engine_get_deadline(&self->engine, &deadline) )
+    {
+        unsigned now    = clock_now(self);
+        unsigned remain = ( (int)( deadline - now ) > 0 )?( deadline - now ):( 0 );
+        if( remain < timeout ) timeout = remain;
+    }
+
+    return timeout;
+}
+//------------------------------------------------------------------------------
+static
+int session_next_event(textalk_t *self, const session_timer_t *timer, textalk_engine_event_t *event)
+{
+    /*
+     * Run the engine until an event for the caller be raised,
+     * or the timer expired (NULL for no timer).
+     * Control codes exchanged are reported on the way,
+     * and a packet being received is not broken by the timer.
+     */
+    while( true )
+    {
+        textalk_engine_on_time(&self->engine, clock_now(self));
+        rxbuf_feed(self);
+
+        int errcode;
+        if(( errcode = session_flush(self) )) return errcode;
+
+        while( textalk_engine_next_event(&self->engine, event) )
+        {
+            session_notify(self, event);
+            if( event->type != TEXTALK_ENGINE_EV_CTRL_SENT &&
+                event->type != TEXTALK_ENGINE_EV_CTRL_TAKEN )
+                return TEXTALK_ERR_SUCCESS;
+        }
+
+        // Data already received be taken first,
+        // and the timer only matters when there is nothing to read.
+        int recvsz = rxbuf_fill(self);
+        if( recvsz < 0 ) return TEXTALK_ERR_STREAM_FAIL;
+        if( recvsz ) continue;
+
+        if( timer && timer_is_expired(self, timer) && !textalk_engine_is_receiving(&self->engine) )
+            return TEXTALK_ERR_TIMEOUT;
+
+        const void *data;
+        int         flags = TEXTALK_WAIT_RECV;
+        if( textalk_engine_peek_output(&self->engine, &data) ) flags |= TEXTALK_WAIT_SEND;
+
+        if( wait_link_ready(self, flags, session_get_wait_time(self, timer)) )
+            return TEXTALK_ERR_STREAM_FAIL;
+    }
+}
+//------------------------------------------------------------------------------
+static
+void session_settle(textalk_t *self)
+{
+    // Put out the echo queued by the caller, and report it.
+    session_flush(self);
+
+    textalk_engine_event_t event;
+    while( textalk_engine_peek_event(&self->engine, &event) &&
+           event.type == TEXTALK_ENGINE_EV_CTRL_SENT )
+    {
+        textalk_engine_next_event(&self->engine, &event);
+        session_notify(self, &event);
+    }
+}
+//------------------------------------------------------------------------------
+static
+int session_fail(textalk_t *self, int errcode)
+{
+    // The link failed, and exchanges on it are abandoned.
+    if( errcode == TEXTALK_ERR_STREAM_FAIL )
+        textalk_engine_reset(&self->engine, clock_now(self));
+
+    return errcode;
 }
 //------------------------------------------------------------------------------
 int textalk_send_ctrl(textalk_t *self, char code)
@@ -76,20 +392,23 @@ int textalk_send_ctrl(textalk_t *self, char code)
      * @param code The character to be sent.
      * @return One of error codes defined in ::textalk_errcode_t.
      */
-    char data = parity_ch_add(code, self->conf.comm.parity);
+    int errcode;
+    if(( errcode = textalk_engine_send_ctrl(&self->engine, code) )) return errcode;
 
-    int sendsz = 0;
-    timectr_t timer = timectr_init_inline(self->conf.comm.timeout.send);
-    while( !sendsz && !timectr_is_expired(&timer) )
+    const void *data;
+    session_timer_t timer = timer_init(self, self->conf.comm.timeout.send);
+    while( true )
     {
-        sendsz = self->events.sender(self->events.userarg, &data, sizeof(data));
-        if( !sendsz ) systime_sleep_awhile();
-    }
+        if(( errcode = session_flush(self) )) return session_fail(self, errcode);
+        if( !textalk_engine_peek_output(&self->engine, &data) ) break;
 
-    if( sendsz < 0 ) return TEXTALK_ERR_STREAM_FAIL;
-    if( sendsz == 0 ) return TEXTALK_ERR_TIMEOUT;
+        // The time-out only counts while the link takes nothing.
+        if( timer_is_expired(self, &timer) ) return notify_send_timeout(self);
+        if( wait_link_ready(self, TEXTALK_WAIT_SEND, timer_get_remain(self, &timer)) )
+            return session_fail(self, TEXTALK_ERR_STREAM_FAIL);
+    }
 
-    self->events.on_send_ctrl(self->events.userarg, code);
+    session_settle(self);
     return TEXTALK_ERR_SUCCESS;
 }
 //------------------------------------------------------------------------------
@@ -106,75 +425,70 @@ int textalk_wait_ctrl(textalk_t *self, char target, char *result)
      *               and can be NULL to not report.
      * @return One of error codes defined in ::textalk_errcode_t.
      */
-    char ch = 0;
+    if( !self->rxbuf ) return TEXTALK_ERR_BUF_NOT_ENOUGH;
 
-    int recvsz = 0;
-    timectr_t timer = timectr_init_inline(self->conf.comm.timeout.echo);
-    while( !ch && recvsz >= 0 && !timectr_is_expired(&timer) )
+    textalk_engine_event_t event;
+    session_timer_t timer = timer_init(self, self->conf.comm.timeout.echo);
+    while( true )
     {
-        recvsz = self->events.recver(self->events.userarg, &ch, sizeof(ch));
-        if( recvsz > 0 )
+        int errcode;
+        if(( errcode = session_next_event(self, &timer, &event) )) return session_fail(self, errcode);
+
+        if( event.type == TEXTALK_ENGINE_EV_TEXT )
         {
-            ch = parity_ch_remove(ch);
-            if( !iscntrl(ch) || ( target && ch != target ) )
-                ch = 0;
+            // A text is not expected here.
+            textalk_engine_reject(&self->engine);
+            session_settle(self);
         }
-        else if( recvsz == 0 )
+        else if( event.type == TEXTALK_ENGINE_EV_CTRL && ( !target || event.ctrl == target ) )
         {
-            systime_sleep_awhile();
+            if( result ) *result = event.ctrl;
+            return TEXTALK_ERR_SUCCESS;
         }
     }
-
-    if( recvsz < 0 ) return TEXTALK_ERR_STREAM_FAIL;
-    if( recvsz == 0 ) return TEXTALK_ERR_TIMEOUT;
-    if( !ch ) return TEXTALK_ERR_TIMEOUT;
-
-    if( result ) *result = ch;
-    self->events.on_recv_ctrl(self->events.userarg, ch);
-    return TEXTALK_ERR_SUCCESS;
 }
 //------------------------------------------------------------------------------
 static
-int textalk_send_packet(textalk_t *self, const char *pkt, size_t size)
+int session_send(textalk_t *self, const char *data, size_t size, bool havemore, const char *text)
 {
-    timectr_t timer = timectr_init_inline(self->conf.comm.timeout.send);
-    while( size && !timectr_is_expired(&timer) )
+    /*
+     * Send data by the engine, and wait until they be acknowledged or failed.
+     * Line bids, retries, and the window mode are all run by the engine.
+     */
+    int errcode;
+    if(( errcode = textalk_engine_send_ref(&self->engine, data, size, havemore) )) return errcode;
+
+    textalk_engine_event_t event;
+    while( true )
     {
-        int sendsz = self->events.sender(self->events.userarg, pkt, size);
-        if( sendsz < 0 || size < sendsz ) return TEXTALK_ERR_STREAM_FAIL;
+        if(( errcode = session_next_event(self, NULL, &event) )) return session_fail(self, errcode);
 
-        if( sendsz )
+        switch( event.type )
         {
-            pkt  += sendsz;
-            size -= sendsz;
-        }
-        else
-        {
-            systime_sleep_awhile();
+        case TEXTALK_ENGINE_EV_SENT:
+            if( text ) self->events.on_send_text(self->events.userarg, text);
+            return TEXTALK_ERR_SUCCESS;
+
+        case TEXTALK_ENGINE_EV_FAILED:
+            return event.errcode;
+
+        case TEXTALK_ENGINE_EV_TEXT:
+            // A text is not expected while sending.
+            textalk_engine_reject(&self->engine);
+            break;
         }
     }
-
-    return size ? TEXTALK_ERR_TIMEOUT : TEXTALK_ERR_SUCCESS;
 }
 //------------------------------------------------------------------------------
 static
-int textalk_send_packet_and_wait_echo(textalk_t  *self,
-                                      const char *text,
-                                      const char *pkt,
-                                      size_t      size)
+int send_with_retry(textalk_t *self, const char *data, size_t size, bool havemore, bool is_text)
 {
-    int errcode;
-
-    if(( errcode = textalk_send_packet(self, pkt, size) )) return errcode;
-    self->events.on_send_text(self->events.userarg, text);
+    if( !self->engine.mem ) return TEXTALK_ERR_BUF_NOT_ENOUGH;
 
-    char echo;
-    if(( errcode = textalk_wait_ctrl(self, 0, &echo) )) return errcode;
+    // One packet only.
+    if( size > textalk_engine_get_block_size(&self->engine) ) return TEXTALK_ERR_BUF_NOT_ENOUGH;
 
-    if( echo == self->conf.ctrl.eot ) return TEXTALK_ERR_TERMINATED;
-    if( echo != self->conf.ctrl.ack ) return TEXTALK_ERR_BAD_EXCHANGE;
-
-    return TEXTALK_ERR_SUCCESS;
+    return session_send(self, data, size, havemore, is_text ? data : NULL);
 }
 //------------------------------------------------------------------------------
 int textalk_send_text(textalk_t *self, const char *text, bool havemore)
@@ -193,197 +507,346 @@ int textalk_send_text(textalk_t *self, const char *text, bool havemore)
      */
     if( !text ) return TEXTALK_ERR_INVALID_ARG;
 
-    char pkt[TEXTALK_PKT_MAX_SIZE];
-    size_t pktsz = textalk_packet_build(pkt, sizeof(pkt), text, &self->conf, havemore);
-    if( !pktsz ) return TEXTALK_ERR_BUF_NOT_ENOUGH;
-
-    int      errcode = TEXTALK_ERR_GENERAL;
-    unsigned trycnt  = self->conf.comm.retry_max + 1;
-    while( errcode &&
-           errcode != TEXTALK_ERR_STREAM_FAIL &&
-           errcode != TEXTALK_ERR_TERMINATED &&
-           trycnt-- )
-    {
-        errcode = textalk_send_packet_and_wait_echo(self, text, pkt, pktsz);
-    }
-
-    return errcode;
+    return send_with_retry(self, text, strlen(text), havemore, true);
 }
 //------------------------------------------------------------------------------
 static
-int recv_for_stx_only(textalk_t *self, bufostm_t *outstm, timectr_t *timer)
+bool data_have_end_char(const textalk_t *self, const char *data, size_t len)
 {
-    char stx = parity_ch_add(self->conf.ctrl.stx, self->conf.comm.parity);
+    // ETX and ETB inside the data would end the packet early on the receiver.
+    char etx = self->conf.ctrl.etx;
+    char etb = self->conf.ctrl.etb;
 
-    char ch;
-    while( !timectr_is_expired(timer) )
+    if( self->conf.comm.parity == TEXTALK_PARITY_NONE )
+        return memchr(data, etx, len) || memchr(data, etb, len);
+
+    // Parity bits of the data will be replaced, so they are not compared.
+    for(size_t i = 0; i < len; ++i)
     {
-        int recvsz = self->events.recver(self->events.userarg, &ch, sizeof(ch));
-        if( recvsz < 0 )
-        {
-            return TEXTALK_ERR_STREAM_FAIL;
-        }
-        else if( recvsz == 0 )
-        {
-            systime_sleep_awhile();
-        }
-        else if( ch == stx )
-        {
-            return bufostm_write(outstm, &ch, sizeof(ch)) ?
-                   TEXTALK_ERR_SUCCESS : TEXTALK_ERR_BUF_NOT_ENOUGH;
-        }
+        char ch = data[i] & 0x7F;
+        if( ch == etx || ch == etb ) return true;
     }
 
-    return TEXTALK_ERR_TIMEOUT;
+    return false;
 }
 //------------------------------------------------------------------------------
-static
-int recv_all_until_etx_or_etb_reached(textalk_t *self, bufostm_t *outstm, timectr_t *timer)
+int textalk_send_data(textalk_t *self, const void *data, size_t len, bool havemore)
 {
-    char etx = parity_ch_add(self->conf.ctrl.etx, self->conf.comm.parity);
-    char etb = parity_ch_add(self->conf.ctrl.etb, self->conf.comm.parity);
+    /**
+     * @memberof textalk_t
+     * @brief Send out a text with its length given.
+     *
+     * @param self     Object instance.
+     * @param data     The text to be sent, and it does not need to be null-terminated.
+     * @param len      Length of the text in bytes.
+     * @param havemore Set TRUE to notify the remote that
+     *                 there have more text to send;
+     *                 and set FALSE to notify that
+     *                 this is the last text for this exchange round.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     *
+     * @remarks The ::textalk_on_send_text_t event will not be raised by this function,
+     *          because the data may not be null-terminated.
+     * @remarks The data may contain null characters,
+     *          but must not contain the ETX and ETB characters,
+     *          and ::TEXTALK_ERR_INVALID_ARG will be returned if it does.
+     */
+    if( !data && len ) return TEXTALK_ERR_INVALID_ARG;
+    if( data_have_end_char(self, data, len) ) return TEXTALK_ERR_INVALID_ARG;
 
-    char ch;
-    while( ch != etx && ch != etb && !timectr_is_expired(timer) )
+    return send_with_retry(self, data, len, havemore, false);
+}
+//------------------------------------------------------------------------------
+static
+int session_wait_text(textalk_t *self, size_t bufsize, textalk_engine_event_t *event)
+{
+    /*
+     * Wait for a text that fits in the buffer,
+     * and the text is held by the engine until the caller accepts or terminates it.
+     * The remote is asked to send again (by NAK) if nothing or a bad text received.
+     */
+    unsigned        fails = 0;
+    session_timer_t timer = timer_init(self, self->conf.comm.timeout.resp);
+    while( true )
     {
-        int recvsz = self->events.recver(self->events.userarg, &ch, sizeof(ch));
-        if( recvsz < 0 )
+        int errcode = session_next_event(self, &timer, event);
+        if( errcode == TEXTALK_ERR_TIMEOUT )
         {
-            return TEXTALK_ERR_STREAM_FAIL;
+            textalk_engine_on_resp_timeout(&self->engine);
+            session_settle(self);
         }
-        else if( recvsz == 0 )
+        else if( errcode )
         {
-            systime_sleep_awhile();
+            return session_fail(self, errcode);
         }
-        else
+        else if( event->type == TEXTALK_ENGINE_EV_TEXT )
         {
-            if( !bufostm_write(outstm, &ch, sizeof(ch)) )
-                return TEXTALK_ERR_BUF_NOT_ENOUGH;
-        }
-    }
+            if( event->textlen < bufsize ) return TEXTALK_ERR_SUCCESS;
 
-    return ( ch == etx || ch == etb )?( TEXTALK_ERR_SUCCESS ):( TEXTALK_ERR_TIMEOUT );
-}
-//------------------------------------------------------------------------------
-static
-int recv_one_byte(textalk_t *self, bufostm_t *outstm, timectr_t *timer)
-{
-    char ch;
-    while( !timectr_is_expired(timer) )
-    {
-        int recvsz = self->events.recver(self->events.userarg, &ch, sizeof(ch));
-        if( recvsz < 0 )
-        {
-            return TEXTALK_ERR_STREAM_FAIL;
+            textalk_engine_reject(&self->engine);
+            session_settle(self);
+            errcode = TEXTALK_ERR_BUF_NOT_ENOUGH;
         }
-        else if( recvsz == 0 )
+        else if( event->type == TEXTALK_ENGINE_EV_NAK_SENT )
         {
-            systime_sleep_awhile();
+            errcode = ( event->errcode == TEXTALK_ERR_BUF_NOT_ENOUGH )?
+                      ( TEXTALK_ERR_BAD_EXCHANGE ):( event->errcode );
         }
         else
         {
-            return bufostm_write(outstm, &ch, sizeof(ch)) ?
-                   TEXTALK_ERR_SUCCESS : TEXTALK_ERR_BUF_NOT_ENOUGH;
+            continue;
         }
-    }
 
-    return TEXTALK_ERR_TIMEOUT;
+        if( ++fails > self->conf.comm.retry_max ) return errcode;
+        timer = timer_init(self, self->conf.comm.timeout.resp);
+    }
 }
 //------------------------------------------------------------------------------
-static
-int textalk_recv_packet(textalk_t *self, char *buf, size_t bufsz, size_t *pktsz)
+int textalk_wait_text(textalk_t *self, char *buf, size_t bufsize)
 {
-    timectr_t timer = timectr_init_inline(self->conf.comm.timeout.resp);
-
-    bufostm_t stream;
-    bufostm_init(&stream, buf, bufsz);
+    /**
+     * @memberof textalk_t
+     * @brief Receive text response.
+     *
+     * @param self    Object instance.
+     * @param buf     A buffer to receive the text data.
+     *                And a null-terminator will be appended at the end of text
+     *                if the buffer is large enough.
+     * @param bufsize Size of the output buffer.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     *
+     * @remarks This function may returns ::TEXTALK_ERR_HAVE_MORE,
+     *          and it does not means failure.
+     *          It actually means that the text be received successfully,
+     *          but there are more text needs to receive.
+     */
+    return textalk_wait_data(self, buf, bufsize, NULL);
+}
+//------------------------------------------------------------------------------
+int textalk_wait_data(textalk_t *self, void *buf, size_t bufsize, size_t *outlen)
+{
+    /**
+     * @memberof textalk_t
+     * @brief Receive text response and its length.
+     *
+     * @param self    Object instance.
+     * @param buf     A buffer to receive the text data,
+     *                and a null-terminator will be appended at the end of text.
+     *                The text may have null characters inside,
+     *                use the length returned to get its actual size.
+     * @param bufsize Size of the output buffer,
+     *                and it should be one byte larger than the text.
+     * @param outlen  Return length of the text received;
+     *                and can be NULL to not report.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     *
+     * @remarks This function may returns ::TEXTALK_ERR_HAVE_MORE,
+     *          and it does not means failure.
+     *          It actually means that the text be received successfully,
+     *          but there are more text needs to receive.
+     */
+    if( !buf || !bufsize ) return TEXTALK_ERR_INVALID_ARG;
+    if( !self->rxbuf ) return TEXTALK_ERR_BUF_NOT_ENOUGH;
 
     int errcode;
+    textalk_engine_event_t event;
+    if(( errcode = session_wait_text(self, bufsize, &event) )) return errcode;
+
+    char *text = buf;
+    memcpy(text, event.text, event.textlen);
+    text[event.textlen] = 0;
+
+    self->events.on_recv_text(self->events.userarg, text);
+    textalk_engine_accept(&self->engine);
+    session_settle(self);
+
+    if( outlen ) *outlen = event.textlen;
+    return event.havemore ? TEXTALK_ERR_HAVE_MORE : TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+int textalk_send_message(textalk_t *self, const void *data, size_t len)
+{
+    /**
+     * @memberof textalk_t
+     * @brief Send out a message of any size.
+     *
+     * @param self Object instance.
+     * @param data The message to be sent.
+     * @param len  Length of the message in bytes.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     *
+     * @remarks The message will be split into blocks of the maximum packet size,
+     *          and be sent with ETB except the last one.
+     * @remarks The ::textalk_on_send_text_t event will not be raised by this function,
+     *          and the message must not contain the ETX and ETB characters,
+     *          or ::TEXTALK_ERR_INVALID_ARG will be returned.
+     * @remarks In window mode (see textalk_conf_comm_t::window),
+     *          blocks will be sent without waiting for echoes of the previous blocks
+     *          until the window is full,
+     *          and only blocks NAKed or timed-out will be sent again.
+     */
+    if( !data && len ) return TEXTALK_ERR_INVALID_ARG;
+    if( data_have_end_char(self, data, len) ) return TEXTALK_ERR_INVALID_ARG;
+    if( !self->engine.mem ) return TEXTALK_ERR_BUF_NOT_ENOUGH;
 
-    if(( errcode = recv_for_stx_only(self, &stream, &timer) ))
-        return errcode;
+    // The engine splits the message itself in window mode.
+    if( self->engine.rxslots ) return session_send(self, data, len, false, NULL);
 
-    if(( errcode = recv_all_until_etx_or_etb_reached(self, &stream, &timer) ))
-        return errcode;
+    size_t blocksz = textalk_engine_get_block_size(&self->engine);
+    if( !blocksz ) return TEXTALK_ERR_BUF_NOT_ENOUGH;
 
-    if( self->conf.comm.have_lrc )
+    const char *pos = data;
+    do
     {
-        if(( errcode = recv_one_byte(self, &stream, &timer) ))
-            return errcode;
-    }
+        size_t size     = ( len < blocksz )?( len ):( blocksz );
+        bool   havemore = ( len > size );
+
+        int errcode = session_send(self, pos, size, havemore, NULL);
+        if( errcode ) return errcode;
 
-    *pktsz = bufostm_get_datasize(&stream);
+        pos += size;
+        len -= size;
+    } while( len );
 
     return TEXTALK_ERR_SUCCESS;
 }
 //------------------------------------------------------------------------------
-static
-int textalk_wait_text_without_retry(textalk_t *self, char *buf, size_t bufsize, bool *havemore)
+int textalk_recv_message(textalk_t *self, char **buf, size_t *bufsize, size_t *len)
 {
-    int res;
-    JMPBK_BEGIN
-    {
-        int errcode;
+    /**
+     * @memberof textalk_t
+     * @brief Receive a message of any size into a growable buffer.
+     *
+     * @param self    Object instance.
+     * @param buf     The address of a buffer allocated by @c malloc, or NULL;
+     *                and it will be enlarged by @c realloc if needed.
+     *                The message will be null-terminated.
+     *                The buffer should be released by @c free by the caller,
+     *                and can be reused for the next message.
+     * @param bufsize The address of size of the buffer,
+     *                and it will be updated if the buffer be enlarged.
+     * @param len     Return length of the message received,
+     *                or length of the part received if failed.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     *
+     * @remarks Blocks are received until one ended with ETX,
+     *          and each block is copied directly to its place in the buffer.
+     */
+    if( !buf || !bufsize || !len ) return TEXTALK_ERR_INVALID_ARG;
 
-        char   pkt[TEXTALK_PKT_MAX_SIZE];
-        size_t pktsz = 0;
-        if(( errcode = textalk_recv_packet(self, pkt, sizeof(pkt), &pktsz) ))
-            JMPBK_THROW(errcode);
+    *len = 0;
 
-        if( !textalk_packet_check_all(pkt, pktsz, &self->conf) )
-            JMPBK_THROW(TEXTALK_ERR_BAD_EXCHANGE);
+    int errcode = TEXTALK_ERR_HAVE_MORE;
+    while( errcode == TEXTALK_ERR_HAVE_MORE )
+    {
+        // Keep room for a whole block and the null-terminator.
+        size_t need = *len + self->conf.comm.frame_max;
+        if( !*buf || *bufsize < need )
+        {
+            size_t newsize = 2 * *bufsize;
+            if( newsize < need ) newsize = need;
 
-        *havemore = textalk_packet_have_etb(pkt, pktsz, &self->conf);
+            char *newbuf = realloc(*buf, newsize);
+            if( !newbuf ) return TEXTALK_ERR_BUF_NOT_ENOUGH;
 
-        if( !textalk_packet_get_text(buf, bufsize, pkt, pktsz, &self->conf) )
-            JMPBK_THROW(TEXTALK_ERR_BUF_NOT_ENOUGH);
+            *buf     = newbuf;
+            *bufsize = newsize;
+        }
 
-        self->events.on_recv_text(self->events.userarg, buf);
+        size_t blocklen = 0;
+        errcode = textalk_wait_data(self, *buf + *len, *bufsize - *len, &blocklen);
+        if( errcode == TEXTALK_ERR_SUCCESS || errcode == TEXTALK_ERR_HAVE_MORE )
+            *len += blocklen;
     }
-    JMPBK_FINAL
-    {
-        res = JMPBK_ERRCODE;
-        char echo = res ? self->conf.ctrl.nak : self->conf.ctrl.ack;
-        textalk_send_ctrl(self, echo);
-    }
-    JMPBK_END
 
-    return res;
+    return errcode;
 }
 //------------------------------------------------------------------------------
-int textalk_wait_text(textalk_t *self, char *buf, size_t bufsize)
+int textalk_recv_message_stream(textalk_t               *self,
+                                textalk_on_recv_chunk_t  on_chunk,
+                                void                    *userarg)
 {
     /**
      * @memberof textalk_t
-     * @brief Receive text response.
+     * @brief Receive a message of any size block by block.
      *
-     * @param self    Object instance.
-     * @param buf     A buffer to receive the text data.
-     *                And a null-terminator will be appended at the end of text
-     *                if the buffer is large enough.
-     * @param bufsize Size of the output buffer.
-     * @return One of error codes defined in ::textalk_errcode_t.
+     * @param self     Object instance.
+     * @param on_chunk The callback to receive each block of the message.
+     *                 Blocks are passed from the packet buffer of the session directly,
+     *                 and the block will be acknowledged after the callback returned.
+     * @param userarg  The user defined argument to be passed to the callback.
+     * @return One of error codes defined in ::textalk_errcode_t;
+     *         or the error code returned by the callback.
      *
-     * @remarks This function may returns ::TEXTALK_ERR_HAVE_MORE,
-     *          and it does not means failure.
-     *          It actually means that the text be received successfully,
-     *          but there are more text needs to receive.
+     * @remarks If the callback returns non-zero,
+     *          EOT will be sent to terminate the exchange.
      */
-    if( !buf || !bufsize ) return TEXTALK_ERR_INVALID_ARG;
+    if( !on_chunk ) return TEXTALK_ERR_INVALID_ARG;
+    if( !self->rxbuf ) return TEXTALK_ERR_BUF_NOT_ENOUGH;
 
-    bool havemore = false;
-
-    int      errcode = TEXTALK_ERR_GENERAL;
-    unsigned trycnt  = self->conf.comm.retry_max + 1;
-    while( errcode &&
-           errcode != TEXTALK_ERR_STREAM_FAIL &&
-           errcode != TEXTALK_ERR_TERMINATED &&
-           trycnt-- )
+    bool havemore = true;
+    while( havemore )
     {
-        errcode = textalk_wait_text_without_retry(self, buf, bufsize, &havemore);
+        int errcode;
+        textalk_engine_event_t event;
+        if(( errcode = session_wait_text(self, SIZE_MAX, &event) )) return errcode;
+
+        havemore = event.havemore;
+        self->events.on_recv_text(self->events.userarg, event.text);
+
+        if(( errcode = on_chunk(userarg, event.text, event.textlen, havemore) ))
+        {
+            textalk_engine_terminate(&self->engine);
+            session_settle(self);
+            return errcode;
+        }
+
+        textalk_engine_accept(&self->engine);
+        session_settle(self);
     }
 
-    return ( errcode )?( errcode ):
-           ( havemore ? TEXTALK_ERR_HAVE_MORE : TEXTALK_ERR_SUCCESS );
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+const textalk_stats_t* textalk_get_stats(const textalk_t *self)
+{
+    /**
+     * @memberof textalk_t
+     * @brief Get counters and histograms of the session.
+     *
+     * @param self Object instance.
+     * @return The metrics, and it will be updated by the session continuously.
+     *
+     * @remarks Sessions driven by the engine (the reactor, the executor, and the coroutine line)
+     *          are counted by the engine of their line,
+     *          and the metrics should be read on the thread that drives the line.
+     */
+    return &self->stats;
+}
+//------------------------------------------------------------------------------
+void textalk_reset_stats(textalk_t *self)
+{
+    /**
+     * @memberof textalk_t
+     * @brief Clear counters and histograms of the session.
+     */
+    textalk_stats_reset(&self->stats);
+}
+//------------------------------------------------------------------------------
+void textalk_set_trace(textalk_t *self, textalk_trace_t *trace)
+{
+    /**
+     * @memberof textalk_t
+     * @brief Set the trace ring to record protocol events.
+     *
+     * @param self  Object instance.
+     * @param trace The trace ring, and can be NULL to stop tracing.
+     *              It should be kept until tracing be stopped or the session be destroyed.
+     * @remarks Drivers built on the engine (the reactor, the executor, and the coroutine line)
+     *          take the ring when the session is attached,
+     *          so it should be set before that.
+     */
+    self->trace = trace;
+    textalk_engine_set_trace(&self->engine, trace);
 }
 //------------------------------------------------------------------------------
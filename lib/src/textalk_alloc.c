@@ -0,0 +1,101 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include "textalk_alloc.h"
+
+#define ARENA_ALIGN ( 2 * sizeof(void*) )
+
+//------------------------------------------------------------------------------
+static
+void* alloc_default(void *userarg, size_t size)
+{
+    return malloc(size);
+}
+//------------------------------------------------------------------------------
+static
+void free_default(void *userarg, void *ptr)
+{
+    free(ptr);
+}
+//------------------------------------------------------------------------------
+static const textalk_allocator_t allocator_default =
+{
+    .userarg = NULL,
+    .alloc   = alloc_default,
+    .free    = free_default,
+};
+//------------------------------------------------------------------------------
+const textalk_allocator_t* textalk_allocator_get_defaults(void)
+{
+    /**
+     * Get the default allocator (malloc and free).
+     */
+    return &allocator_default;
+}
+//------------------------------------------------------------------------------
+void textalk_arena_init(textalk_arena_t *self, void *buf, size_t size)
+{
+    /**
+     * @memberof textalk_arena_t
+     * @brief Constructor.
+     *
+     * @param self Object instance.
+     * @param buf  The memory block to allocate memory from,
+     *             and it must be kept valid while the arena being used.
+     * @param size Size of the memory block.
+     */
+    self->buf  = buf;
+    self->size = size;
+    self->used = 0;
+}
+//------------------------------------------------------------------------------
+void textalk_arena_reset(textalk_arena_t *self)
+{
+    /**
+     * @memberof textalk_arena_t
+     * @brief Release all memory allocated.
+     *
+     * @remarks Sessions using memory of the arena must be de-initialised before.
+     */
+    self->used = 0;
+}
+//------------------------------------------------------------------------------
+size_t textalk_arena_get_remain(const textalk_arena_t *self)
+{
+    /**
+     * @memberof textalk_arena_t
+     * @brief Get size of memory that have not been allocated.
+     */
+    return self->size - self->used;
+}
+//------------------------------------------------------------------------------
+static
+void* arena_alloc(void *userarg, size_t size)
+{
+    textalk_arena_t *self = userarg;
+
+    uintptr_t addr = (uintptr_t)( self->buf + self->used );
+    size_t    pad  = ( ARENA_ALIGN - addr % ARENA_ALIGN ) % ARENA_ALIGN;
+
+    if( pad > self->size - self->used || size > self->size - self->used - pad )
+        return NULL;
+
+    void *ptr = self->buf + self->used + pad;
+    self->used += pad + size;
+
+    return ptr;
+}
+//------------------------------------------------------------------------------
+void textalk_arena_fill_allocator(textalk_arena_t *self, textalk_allocator_t *allocator)
+{
+    /**
+     * @memberof textalk_arena_t
+     * @brief Fill an allocator to allocate memory from this arena.
+     *
+     * @param self      Object instance.
+     * @param allocator The allocator to be filled.
+     */
+    allocator->userarg = self;
+    allocator->alloc   = arena_alloc;
+    allocator->free    = NULL;
+}
+//------------------------------------------------------------------------------
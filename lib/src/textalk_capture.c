@@ -0,0 +1,556 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "parity.h"
+#include "textalk_packet.h"
+#include "textalk_capture.h"
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+    #define CAPTURE_HAVE_X86_KERNELS
+    #include <immintrin.h>
+#endif
+
+#define CHUNK_MIN_SIZE   ( 1 << 20 )    // Chunks smaller than this are not worth a thread.
+#define CHUNKS_PER_THREAD 4
+#define ECHO_SCAN_MAX     64            // The maximum distance to look for the echo of a frame.
+
+//------------------------------------------------------------------------------
+//---- Scanning kernels --------------------------------------------------------
+//------------------------------------------------------------------------------
+/*
+ * Find the first character equal to a or b,
+ * and returns its position or len if not found.
+ */
+typedef size_t(*scan_kernel_t)(const char *arr, size_t len, char a, char b);
+
+//------------------------------------------------------------------------------
+static
+size_t scan_plain(const char *arr, size_t len, char a, char b)
+{
+    if( a == b )
+    {
+        const char *pos = memchr(arr, a, len);
+        return ( pos )?( pos - arr ):( len );
+    }
+
+    for(size_t i = 0; i < len; ++i)
+    {
+        if( arr[i] == a || arr[i] == b )
+            return i;
+    }
+
+    return len;
+}
+//------------------------------------------------------------------------------
+#ifdef CAPTURE_HAVE_X86_KERNELS
+__attribute__((target("sse2")))
+static
+size_t scan_sse2(const char *arr, size_t len, char a, char b)
+{
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+
+    size_t pos = 0;
+    for(; pos + 16 <= len; pos += 16)
+    {
+        __m128i data = _mm_loadu_si128((const __m128i*)( arr + pos ));
+        __m128i hit  = _mm_or_si128(_mm_cmpeq_epi8(data, va), _mm_cmpeq_epi8(data, vb));
+
+        unsigned mask = _mm_movemask_epi8(hit);
+        if( mask ) return pos + __builtin_ctz(mask);
+    }
+
+    return pos + scan_plain(arr + pos, len - pos, a, b);
+}
+//------------------------------------------------------------------------------
+__attribute__((target("avx2")))
+static
+size_t scan_avx2(const char *arr, size_t len, char a, char b)
+{
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+
+    size_t pos = 0;
+    for(; pos + 32 <= len; pos += 32)
+    {
+        __m256i data = _mm256_loadu_si256((const __m256i*)( arr + pos ));
+        __m256i hit  = _mm256_or_si256(_mm256_cmpeq_epi8(data, va), _mm256_cmpeq_epi8(data, vb));
+
+        unsigned mask = _mm256_movemask_epi8(hit);
+        if( mask ) return pos + __builtin_ctz(mask);
+    }
+
+    return pos + scan_sse2(arr + pos, len - pos, a, b);
+}
+#endif
+//------------------------------------------------------------------------------
+static
+scan_kernel_t select_scan_kernel(void)
+{
+#ifdef CAPTURE_HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports("avx2") )
+        return scan_avx2;
+    else if( __builtin_cpu_supports("sse2") )
+        return scan_sse2;
+#endif
+
+    return scan_plain;
+}
+//------------------------------------------------------------------------------
+//---- Frame decoder -----------------------------------------------------------
+//------------------------------------------------------------------------------
+typedef struct decoder_t
+{
+    const char           *data;
+    size_t                size;
+    const textalk_conf_t *conf;
+    textalk_conf_ctrl_t   wire;
+    size_t                frame_max;
+    scan_kernel_t         scan;
+} decoder_t;
+
+//------------------------------------------------------------------------------
+static
+char find_echo(const decoder_t *dec, size_t pos)
+{
+    const textalk_conf_ctrl_t *ctrl = &dec->conf->ctrl;
+
+    size_t end = pos + ECHO_SCAN_MAX;
+    if( end > dec->size ) end = dec->size;
+
+    for(; pos < end; ++pos)
+    {
+        char ch = dec->data[pos];
+        if( ch == dec->wire.stx ) break;
+
+        char code = parity_ch_remove(ch);
+        if( code == ctrl->ack || code == ctrl->nak || code == ctrl->eot )
+            return code;
+    }
+
+    return 0;
+}
+//------------------------------------------------------------------------------
+static
+bool decode_next(const decoder_t         *dec,
+                 size_t                   pos,
+                 size_t                   stxlimit,
+                 textalk_capture_frame_t *frame,
+                 size_t                  *next)
+{
+    /*
+     * Decode the first frame that starts in [pos, stxlimit),
+     * and returns FALSE if there is none.
+     * The frame itself can run beyond the limit.
+     * The result depends only on the position STX be found,
+     * so decoders started at different places agree once they meet at the same STX.
+     */
+    if( pos >= stxlimit ) return false;
+
+    size_t start = pos + dec->scan(dec->data + pos, stxlimit - pos, dec->wire.stx, dec->wire.stx);
+    if( start >= stxlimit ) return false;
+
+    bool   havelrc = dec->conf->comm.have_lrc;
+    size_t limit   = ( dec->size - start > dec->frame_max )?( start + dec->frame_max ):( dec->size );
+    size_t end     = start + 1 + dec->scan(dec->data + start + 1,
+                                           limit - start - 1,
+                                           dec->wire.etx,
+                                           dec->wire.etb);
+
+    frame->offset   = start;
+    frame->echo     = 0;
+    frame->havemore = 0;
+    frame->reserved = 0;
+
+    size_t pktsz = end + 1 - start + ( havelrc ? 1 : 0 );
+    if( ( end >= limit && limit == dec->size ) || start + pktsz > dec->size )
+    {
+        // The capture ended within the frame.
+        frame->status = TEXTALK_CAPTURE_TRUNCATED;
+        frame->size   = dec->size - start;
+        *next         = dec->size;
+        return true;
+    }
+
+    if( end >= limit || pktsz > dec->frame_max )
+    {
+        // Not ended within the maximum size (or only its LRC is beyond it),
+        // and look for the next STX inside it, as the receiver would drop it.
+        frame->status = TEXTALK_CAPTURE_TOO_LONG;
+        frame->size   = ( end >= limit )?( limit - start ):( pktsz );
+        *next         = start + 1;
+        return true;
+    }
+
+    const char *pkt = dec->data + start;
+
+    // The same checks as textalk_packet_decode, without extracting the text.
+    if( !parity_arr_check(pkt, pktsz - ( havelrc ? 1 : 0 ), dec->conf->comm.parity) )
+        frame->status = TEXTALK_CAPTURE_BAD_PARITY;
+    else if( !textalk_packet_check_lrc(pkt, pktsz, dec->conf) )
+        frame->status = TEXTALK_CAPTURE_BAD_LRC;
+    else
+        frame->status = TEXTALK_CAPTURE_OK;
+
+    frame->size     = pktsz;
+    frame->havemore = ( dec->data[end] == dec->wire.etb );
+    frame->echo     = find_echo(dec, start + pktsz);
+
+    *next = start + pktsz;
+    return true;
+}
+//------------------------------------------------------------------------------
+//---- Frame list --------------------------------------------------------------
+//------------------------------------------------------------------------------
+typedef struct frame_list_t
+{
+    textalk_capture_frame_t *frames;
+    size_t                   count;
+    size_t                   capacity;
+} frame_list_t;
+
+//------------------------------------------------------------------------------
+static
+bool frame_list_push(frame_list_t *list, const textalk_capture_frame_t *frames, size_t count)
+{
+    if( list->count + count > list->capacity )
+    {
+        size_t capacity = list->capacity ? list->capacity : 1024;
+        while( capacity < list->count + count )
+            capacity *= 2;
+
+        textalk_capture_frame_t *newframes = realloc(list->frames, capacity * sizeof(*newframes));
+        if( !newframes ) return false;
+
+        list->frames   = newframes;
+        list->capacity = capacity;
+    }
+
+    memcpy(list->frames + list->count, frames, count * sizeof(*frames));
+    list->count += count;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+//---- Workers -----------------------------------------------------------------
+//------------------------------------------------------------------------------
+typedef struct chunk_t
+{
+    size_t       start;
+    size_t       end;
+    size_t       next;      // Position after the last frame decoded.
+    frame_list_t list;
+    bool         failed;
+} chunk_t;
+
+typedef struct job_t
+{
+    const decoder_t *dec;
+    chunk_t         *chunks;
+    size_t           count;
+    size_t           taken;     // Count of chunks taken by workers.
+} job_t;
+
+//------------------------------------------------------------------------------
+static
+void decode_chunk(const decoder_t *dec, chunk_t *chunk)
+{
+    textalk_capture_frame_t frame;
+
+    size_t pos = chunk->start;
+    while( decode_next(dec, pos, chunk->end, &frame, &pos) )
+    {
+        if( !frame_list_push(&chunk->list, &frame, 1) )
+        {
+            chunk->failed = true;
+            break;
+        }
+    }
+
+    chunk->next = pos;
+}
+//------------------------------------------------------------------------------
+static
+void* worker_thread(job_t *job)
+{
+    size_t index;
+    while( ( index = __atomic_fetch_add(&job->taken, 1, __ATOMIC_RELAXED) ) < job->count )
+        decode_chunk(job->dec, &job->chunks[index]);
+
+    return NULL;
+}
+//------------------------------------------------------------------------------
+static
+bool merge_chunk(const decoder_t *dec, const chunk_t *chunk, frame_list_t *out, size_t *pos)
+{
+    /*
+     * Frames of a chunk be decoded from the STX where the chunk starts,
+     * and the previous chunk may have decoded a frame across that STX;
+     * so decode from the actual position until meeting a frame of the chunk,
+     * and the rest of the chunk are the same as decoding in one pass.
+     */
+    const textalk_capture_frame_t *frames = chunk->list.frames;
+    size_t                         count  = chunk->list.count;
+    size_t                         index  = 0;
+
+    textalk_capture_frame_t frame;
+    size_t                  next;
+    while( decode_next(dec, *pos, chunk->end, &frame, &next) )
+    {
+        while( index < count && frames[index].offset < frame.offset )
+            ++index;
+
+        if( index < count && frames[index].offset == frame.offset )
+        {
+            *pos = chunk->next;
+            return frame_list_push(out, frames + index, count - index);
+        }
+
+        if( !frame_list_push(out, &frame, 1) ) return false;
+        *pos = next;
+    }
+
+    if( *pos < chunk->end ) *pos = chunk->end;
+    return true;
+}
+//------------------------------------------------------------------------------
+//---- Capture -----------------------------------------------------------------
+//------------------------------------------------------------------------------
+void textalk_capture_init(textalk_capture_t *self, const void *data, size_t size)
+{
+    /**
+     * @memberof textalk_capture_t
+     * @brief Constructor with a capture in memory.
+     *
+     * @param self Object instance.
+     * @param data The capture, and it must be kept until the object closed.
+     * @param size Size of the capture.
+     */
+    self->data   = data;
+    self->size   = size;
+    self->fd     = -1;
+    self->frames = NULL;
+    self->count  = 0;
+}
+//------------------------------------------------------------------------------
+int textalk_capture_open(textalk_capture_t *self, const char *filename)
+{
+    /**
+     * @memberof textalk_capture_t
+     * @brief Constructor with a capture file.
+     *
+     * @param self     Object instance.
+     * @param filename Name of the capture file, and it will be memory mapped.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     *
+     * @remarks The object must be closed by textalk_capture_close
+     *          even if this function failed.
+     */
+    textalk_capture_init(self, NULL, 0);
+
+    self->fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if( self->fd < 0 ) return TEXTALK_ERR_STREAM_FAIL;
+
+    struct stat st;
+    if( fstat(self->fd, &st) ) return TEXTALK_ERR_STREAM_FAIL;
+    if( !st.st_size ) return TEXTALK_ERR_SUCCESS;
+
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, self->fd, 0);
+    if( data == MAP_FAILED ) return TEXTALK_ERR_STREAM_FAIL;
+
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    self->data = data;
+    self->size = st.st_size;
+
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+void textalk_capture_close(textalk_capture_t *self)
+{
+    /**
+     * @memberof textalk_capture_t
+     * @brief Destructor.
+     */
+    if( self->fd >= 0 )
+    {
+        if( self->data ) munmap((void*) self->data, self->size);
+        close(self->fd);
+    }
+
+    free(self->frames);
+    textalk_capture_init(self, NULL, 0);
+}
+//------------------------------------------------------------------------------
+int textalk_capture_decode(textalk_capture_t *self, const textalk_conf_t *conf, unsigned threads)
+{
+    /**
+     * @memberof textalk_capture_t
+     * @brief Decode all frames of the capture.
+     *
+     * @param self    Object instance.
+     * @param conf    Communication configuration of the line captured,
+     *                and can be NULL to use the default one.
+     * @param threads Count of worker threads,
+     *                and ZERO to use one per processor.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     *
+     * @remarks Frames are checked for parity and LRC the same as a receiving session,
+     *          and a frame not ended within ::textalk_conf_comm_t::frame_max
+     *          is reported and skipped to the next STX.
+     */
+    if( !conf ) conf = textalk_conf_get_defaults();
+
+    free(self->frames);
+    self->frames = NULL;
+    self->count  = 0;
+
+    decoder_t dec =
+    {
+        .data      = self->data,
+        .size      = self->size,
+        .conf      = conf,
+        .frame_max = conf->comm.frame_max ? conf->comm.frame_max : TEXTALK_PKT_MAX_SIZE,
+        .scan      = select_scan_kernel(),
+    };
+    textalk_packet_get_wire_ctrl(&dec.wire, conf);
+
+    if( !threads )
+    {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = ( cores > 0 )?( cores ):( 1 );
+    }
+
+    size_t count = threads * CHUNKS_PER_THREAD;
+    if( count > self->size / CHUNK_MIN_SIZE ) count = self->size / CHUNK_MIN_SIZE;
+    if( !count ) count = 1;
+    if( threads > count ) threads = count;
+
+    chunk_t *chunks = calloc(count, sizeof(*chunks));
+    if( !chunks ) return TEXTALK_ERR_BUF_NOT_ENOUGH;
+
+    // Split at STX, so each chunk starts where a frame may start.
+    for(size_t i = 0; i < count; ++i)
+    {
+        size_t start = self->size / count * i;
+        if( i ) start += dec.scan(dec.data + start, dec.size - start, dec.wire.stx, dec.wire.stx);
+
+        chunks[i].start = start;
+        if( i ) chunks[i-1].end = start;
+    }
+    chunks[count-1].end = self->size;
+
+    job_t job = { &dec, chunks, count, 0 };
+
+    pthread_t *workers = calloc(threads, sizeof(*workers));
+    unsigned   started = 0;
+    if( workers )
+    {
+        for(; started + 1 < threads; ++started)
+        {
+            if( pthread_create(&workers[started], NULL, (void*(*)(void*)) worker_thread, &job) )
+                break;
+        }
+    }
+
+    // The calling thread works too.
+    worker_thread(&job);
+    for(unsigned i = 0; i < started; ++i)
+        pthread_join(workers[i], NULL);
+    free(workers);
+
+    frame_list_t out = { NULL, 0, 0 };
+
+    bool   ok  = true;
+    size_t pos = 0;
+    for(size_t i = 0; i < count; ++i)
+    {
+        ok = ok && !chunks[i].failed && merge_chunk(&dec, &chunks[i], &out, &pos);
+        free(chunks[i].list.frames);
+    }
+    free(chunks);
+
+    if( !ok )
+    {
+        free(out.frames);
+        return TEXTALK_ERR_BUF_NOT_ENOUGH;
+    }
+
+    self->frames = out.frames;
+    self->count  = out.count;
+
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+const textalk_capture_frame_t* textalk_capture_get_frames(const textalk_capture_t *self, size_t *count)
+{
+    /**
+     * @memberof textalk_capture_t
+     * @brief Get frames decoded.
+     *
+     * @param self  Object instance.
+     * @param count Returns the count of frames.
+     * @return The frames in order of the capture.
+     */
+    if( count ) *count = self->count;
+    return self->frames;
+}
+//------------------------------------------------------------------------------
+bool textalk_capture_get_text(const textalk_capture_t       *self,
+                              const textalk_capture_frame_t *frame,
+                              const textalk_conf_t          *conf,
+                              char                          *buf,
+                              size_t                         bufsz)
+{
+    /**
+     * @memberof textalk_capture_t
+     * @brief Extract the text of a frame.
+     *
+     * @param self  Object instance.
+     * @param frame The frame.
+     * @param conf  Communication configuration used to decode the capture,
+     *              and can be NULL to use the default one.
+     * @param buf   The buffer to receive the text (null-terminated).
+     * @param bufsz Size of the buffer.
+     * @return TRUE if succeed;
+     *         and FALSE if the frame is not complete or the buffer is not long enough.
+     */
+    if( !conf ) conf = textalk_conf_get_defaults();
+    if( frame->status == TEXTALK_CAPTURE_TOO_LONG || frame->status == TEXTALK_CAPTURE_TRUNCATED )
+        return false;
+
+    return textalk_packet_get_text(buf, bufsz, self->data + frame->offset, frame->size, conf);
+}
+//------------------------------------------------------------------------------
+int textalk_capture_write_index(const textalk_capture_t *self, FILE *file)
+{
+    /**
+     * @memberof textalk_capture_t
+     * @brief Write frames decoded as an index,
+     *        see ::textalk_capture_index_head_t.
+     *
+     * @param self Object instance.
+     * @param file The file to write.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     */
+    textalk_capture_index_head_t head =
+    {
+        .magic   = TEXTALK_CAPTURE_MAGIC,
+        .version = TEXTALK_CAPTURE_VERSION,
+        .srcsize = self->size,
+        .count   = self->count,
+    };
+
+    if( fwrite(&head, sizeof(head), 1, file) != 1 )
+        return TEXTALK_ERR_STREAM_FAIL;
+    if( self->count && fwrite(self->frames, sizeof(*self->frames), self->count, file) != self->count )
+        return TEXTALK_ERR_STREAM_FAIL;
+
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
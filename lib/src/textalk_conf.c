@@ -15,14 +15,23 @@ static const textalk_conf_t conf_default =
     },
     .comm =
     {
-        .parity     = TEXTALK_PARITY_NONE,
-        .have_lrc   = true,
-        .retry_max  = 3,
+        .parity         = TEXTALK_PARITY_NONE,
+        .parity_reject  = false,
+        .have_lrc       = true,
+        .retry_max      = 3,
+        .frame_max      = TEXTALK_PKT_MAX_SIZE,
+        .window         = 1,
+        .role           = TEXTALK_ROLE_NONE,
         .timeout =
         {
-            .send   = 500,
-            .echo   = 500,
-            .resp   = 3000,
+            .send       = 500,
+            .echo       = 500,
+            .resp       = 3000,
+            .bid        = 50,
+            .echo_min   = 0,
+            .char_time  = 0,
+            .gap        = 0,
+            .adaptive   = false,
         },
     },
 };
@@ -35,3 +44,13 @@ const textalk_conf_t* textalk_conf_get_defaults(void)
     return &conf_default;
 }
 //------------------------------------------------------------------------------
+unsigned textalk_conf_get_char_time(unsigned baudrate)
+{
+    /**
+     * Get time to transmit a character in microseconds (rounded up),
+     * with a start bit, eight data bits (or seven bits and parity), and a stop bit;
+     * or ZERO if the baud rate is ZERO.
+     */
+    return ( baudrate )?( ( 10 * 1000000 + baudrate - 1 ) / baudrate ):( 0 );
+}
+//------------------------------------------------------------------------------
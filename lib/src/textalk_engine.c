@@ -0,0 +1,1676 @@
+#include <assert.h>
+#include <ctype.h>
+#include <string.h>
+#include "parity.h"
+#include "textalk_packet.h"
+#include "textalk_engine.h"
+
+#define WINDOW_SEQ_BASE   0x20  // Sequence characters are printable characters from here.
+#define WINDOW_SEQ_MOD    64    // The count of sequence characters.
+#define WINDOW_START_BASE 0x60  // Start characters of exchanges follow sequence characters.
+#define WINDOW_START_MOD  31    // The count of start characters.
+
+enum
+{
+    RX_IDLE = 0,    // Waiting for STX.
+    RX_BODY,        // Receiving data until ETX or ETB reached.
+    RX_LRC,         // Waiting for LRC.
+    RX_ECHO_SEQ,    // Waiting for the sequence characters of an echo in window mode.
+    RX_HELD,        // A text be received, and waiting for the user to accept or reject it.
+};
+
+enum
+{
+    TX_IDLE = 0,    // Nothing to send.
+    TX_BID_DELAY,   // The line bid failed, and waiting to bid again.
+    TX_BIDDING,     // ENQ be sent, and waiting for the answer.
+    TX_SENDING,     // The packet is being taken out.
+    TX_WAIT_ECHO,   // The packet be taken out, and waiting for the echo.
+    TX_WINDOW,      // Blocks of an exchange are being sent in window mode.
+};
+
+// Codec that follows the configuration at runtime.
+static const textalk_codec_t runtime_codec =
+{
+    .match  = NULL,
+    .encode = textalk_packet_encode,
+    .decode = textalk_packet_decode,
+};
+
+//------------------------------------------------------------------------------
+static
+bool time_is_reached(unsigned now, unsigned deadline)
+{
+    return (int)( now - deadline ) >= 0;
+}
+//------------------------------------------------------------------------------
+static inline
+void trace_put(textalk_engine_t *self, int type, char ctrl, size_t len, int errcode)
+{
+    if( self->trace ) textalk_trace_put(self->trace, self->now, type, ctrl, len, errcode);
+}
+/*
+ * Each text sent in window mode is an exchange,
+ * and its first block carries a start character instead of a sequence character.
+ * The start character changes on every exchange,
+ * so the receiver knows where an exchange begins,
+ * and can tell a new exchange from the first block of the last one sent again.
+ * Other blocks of the exchange carry their sequence counted from the first block.
+ *
+ * The sender does not open the window until the first block be acknowledged,
+ * so the receiver is always synchronised by the first block of an exchange.
+ */
+//------------------------------------------------------------------------------
+static
+bool window_is_start_char(char ch)
+{
+    return (unsigned char)( ch - WINDOW_START_BASE ) < WINDOW_START_MOD;
+}
+//------------------------------------------------------------------------------
+static
+char window_next_start_char(char start)
+{
+    if( !window_is_start_char(start) ) return WINDOW_START_BASE;
+    return WINDOW_START_BASE + ( start - WINDOW_START_BASE + 1 ) % WINDOW_START_MOD;
+}
+//------------------------------------------------------------------------------
+static
+char window_seq_char(char start, unsigned seq)
+{
+    return ( seq )?( WINDOW_SEQ_BASE + seq % WINDOW_SEQ_MOD ):( start );
+}
+//------------------------------------------------------------------------------
+static
+unsigned window_seq_offset(unsigned base, char ch)
+{
+    // Distance from the base sequence to the sequence character, or -1 if invalid.
+    unsigned value = (unsigned char) ch - WINDOW_SEQ_BASE;
+    if( value >= WINDOW_SEQ_MOD ) return -1;
+
+    return ( value - base % WINDOW_SEQ_MOD + WINDOW_SEQ_MOD ) % WINDOW_SEQ_MOD;
+}
+//------------------------------------------------------------------------------
+static
+char* window_get_slot_text(textalk_engine_t *self, unsigned index)
+{
+    return self->rxwin + index * self->conf.comm.frame_max;
+}
+//------------------------------------------------------------------------------
+static
+textalk_engine_event_t* push_event(textalk_engine_t *self, int type, int errcode)
+{
+    assert( self->evcount < TEXTALK_ENGINE_EVENT_MAX );
+
+    unsigned index = ( self->evhead + self->evcount++ ) % TEXTALK_ENGINE_EVENT_MAX;
+    textalk_engine_event_t *event = &self->evqueue[index];
+
+    memset(event, 0, sizeof(*event));
+    event->type    = type;
+    event->errcode = errcode;
+
+    return event;
+}
+//------------------------------------------------------------------------------
+static
+void push_ctrl_output(textalk_engine_t *self, char code, char seqch)
+{
+    // The sequence (of window mode) be sent twice to protect it from being changed by line noise.
+    size_t size = ( seqch )?( 3 ):( 1 );
+    if( self->ctrloutsz + size > sizeof(self->ctrlout) ) return;
+
+    int parity = self->conf.comm.parity;
+    self->ctrlout[self->ctrloutsz++] = parity_ch_add(code, parity);
+    if( seqch )
+    {
+        self->ctrlout[self->ctrloutsz++] = parity_ch_add(seqch, parity);
+        self->ctrlout[self->ctrloutsz++] = parity_ch_add(seqch, parity);
+    }
+
+    if( self->stats && code == self->conf.ctrl.nak ) ++self->stats->nak_sent;
+    if( self->stats && code == self->conf.ctrl.eot ) ++self->stats->eot_sent;
+
+    trace_put(self, TEXTALK_TRACE_SEND_CTRL, code, 0, TEXTALK_ERR_SUCCESS);
+    push_event(self, TEXTALK_ENGINE_EV_CTRL_SENT, TEXTALK_ERR_SUCCESS)->ctrl = code;
+}
+//------------------------------------------------------------------------------
+static
+void push_tx_event(textalk_engine_t *self, int type, int errcode)
+{
+    textalk_engine_event_t *event = push_event(self, type, errcode);
+    event->text     = self->txdata;
+    event->textlen  = self->txlen;
+    event->havemore = self->txhavemore;
+}
+//------------------------------------------------------------------------------
+static
+void tx_set_output(textalk_engine_t *self)
+{
+    self->txpos   = 0;
+    self->txoutsz = self->txheadsz + self->txbodysz + self->txtailsz;
+}
+//------------------------------------------------------------------------------
+static
+void tx_finish(textalk_engine_t *self, int type, int errcode)
+{
+    // The line is held until the last text of an exchange round be sent.
+    if( errcode || !self->txhavemore )
+        self->txholding = false;
+
+    self->txstate = TX_IDLE;
+    self->txoutsz = 0;
+    push_tx_event(self, type, errcode);
+}
+//------------------------------------------------------------------------------
+static
+void tx_retry_or_fail(textalk_engine_t *self, int errcode)
+{
+    if( --self->txtries )
+    {
+        if( self->stats ) ++self->stats->retries;
+
+        self->txstate    = TX_SENDING;
+        self->txdeadline = self->now + self->conf.comm.timeout.send;
+        tx_set_output(self);
+    }
+    else
+    {
+        tx_finish(self, TEXTALK_ENGINE_EV_FAILED, errcode);
+    }
+}
+//------------------------------------------------------------------------------
+static
+void tx_on_echo(textalk_engine_t *self, char code)
+{
+    if( code == self->conf.ctrl.ack )
+    {
+        // An echo after a retry may be the answer of an earlier try, and is not measured.
+        if( self->txtries == self->conf.comm.retry_max + 1 )
+        {
+            textalk_rtt_update(&self->rtt, self->now - self->txsent);
+            if( self->stats ) textalk_hist_add(&self->stats->rtt, self->now - self->txsent);
+        }
+
+        tx_finish(self, TEXTALK_ENGINE_EV_SENT, TEXTALK_ERR_SUCCESS);
+    }
+    else if( code == self->conf.ctrl.eot )
+    {
+        if( self->stats ) ++self->stats->eot_recv;
+        tx_finish(self, TEXTALK_ENGINE_EV_FAILED, TEXTALK_ERR_TERMINATED);
+    }
+    else
+    {
+        if( code == self->conf.ctrl.nak )
+        {
+            if( self->stats ) ++self->stats->nak_recv;
+            push_tx_event(self, TEXTALK_ENGINE_EV_NAK_RECV, TEXTALK_ERR_BAD_EXCHANGE);
+        }
+
+        tx_retry_or_fail(self, TEXTALK_ERR_BAD_EXCHANGE);
+    }
+}
+//------------------------------------------------------------------------------
+static
+void tx_window_output(textalk_engine_t *self, size_t index)
+{
+    // Take out the Nth block of the text, and only the last block can be sent with ETX.
+    size_t      blocksz = textalk_engine_get_block_size(self);
+    size_t      offset  = index * blocksz;
+    size_t      size    = ( self->txlen - offset < blocksz )?( self->txlen - offset ):( blocksz );
+    bool        more    = ( index + 1 < self->txcount ) || self->txhavemore;
+    const char *data    = self->txdata + offset;
+    char        seqch   = window_seq_char(self->txstart, index);
+
+    if( self->vectored && self->conf.comm.parity == TEXTALK_PARITY_NONE )
+    {
+        self->txheadsz = textalk_packet_encode_head(self->txhead, sizeof(self->txhead), &self->conf);
+        self->txtailsz = textalk_packet_encode_tail(self->txtail,
+                                                    sizeof(self->txtail),
+                                                    data,
+                                                    size,
+                                                    &self->conf,
+                                                    more);
+
+        self->txhead[self->txheadsz++] = seqch;
+        if( self->conf.comm.have_lrc ) self->txtail[self->txtailsz-1] ^= seqch;
+
+        self->txbody   = data;
+        self->txbodysz = size;
+    }
+    else
+    {
+        self->txheadsz = 0;
+        self->txtailsz = 0;
+        self->txbody   = self->txpkt;
+        self->txbodysz = textalk_packet_encode_seq(self->txpkt,
+                                                   self->conf.comm.frame_max,
+                                                   seqch,
+                                                   data,
+                                                   size,
+                                                   &self->conf,
+                                                   more);
+    }
+
+    textalk_engine_block_t *block = &self->txblocks[ index % self->conf.comm.window ];
+    block->resend = false;
+
+    self->txcur      = index;
+    self->txdeadline = self->now + self->conf.comm.timeout.send;
+    tx_set_output(self);
+}
+//------------------------------------------------------------------------------
+static
+void tx_window_schedule(textalk_engine_t *self)
+{
+    // Blocks NAKed or timed-out go first, then new blocks while the window is open.
+    if( self->txoutsz ) return;
+
+    unsigned window = self->conf.comm.window;
+    for(size_t i = self->txbase; i < self->txnext; ++i)
+    {
+        textalk_engine_block_t *block = &self->txblocks[ i % window ];
+        if( !block->acked && block->resend )
+        {
+            tx_window_output(self, i);
+            return;
+        }
+    }
+
+    // The window opens after the first block be acknowledged.
+    size_t limit = ( self->txbase )?( self->txbase + window ):( 1 );
+    if( self->txnext < self->txcount && self->txnext < limit )
+    {
+        textalk_engine_block_t *block = &self->txblocks[ self->txnext % window ];
+        block->tries = 0;
+        block->acked = false;
+
+        tx_window_output(self, self->txnext++);
+    }
+}
+//------------------------------------------------------------------------------
+static
+void tx_window_on_output(textalk_engine_t *self)
+{
+    // A block be taken out completely.
+    textalk_engine_block_t *block = &self->txblocks[ self->txcur % self->conf.comm.window ];
+    if( self->stats && block->tries ) ++self->stats->retries;
+
+    block->sent     = self->now;
+    block->deadline = self->now + textalk_rtt_get_timeout(&self->rtt, block->tries);
+    block->tries   += 1;
+
+    self->txoutsz = 0;
+    if( self->txbase == self->txcount )
+        tx_finish(self, TEXTALK_ENGINE_EV_SENT, TEXTALK_ERR_SUCCESS);
+    else
+        tx_window_schedule(self);
+}
+//------------------------------------------------------------------------------
+static
+void tx_window_on_echo(textalk_engine_t *self, char code, char seq)
+{
+    if( code == self->conf.ctrl.nak && self->stats ) ++self->stats->nak_recv;
+
+    // Echoes of blocks not in the window are ignored,
+    // and the first block is echoed with the start character only.
+    unsigned window = self->conf.comm.window;
+    size_t   base   = self->txbase;
+    size_t   index  = ( seq == self->txstart )?( 0 ):( base + window_seq_offset(base, seq) );
+    if( index < base || index >= self->txnext ) return;
+    if( !index && seq != self->txstart ) return;
+
+    textalk_engine_block_t *block = &self->txblocks[ index % window ];
+    bool                    busy  = ( self->txoutsz && index == self->txcur );
+    if( code == self->conf.ctrl.ack )
+    {
+        if( !block->acked && block->tries == 1 && !busy )
+        {
+            textalk_rtt_update(&self->rtt, self->now - block->sent);
+            if( self->stats ) textalk_hist_add(&self->stats->rtt, self->now - block->sent);
+        }
+
+        block->acked = true;
+        while( self->txbase < self->txnext && self->txblocks[ self->txbase % window ].acked )
+            ++self->txbase;
+
+        // The exchange finishes after the block being taken out (if any) be completed.
+        if( self->txbase == self->txcount && !self->txoutsz )
+            tx_finish(self, TEXTALK_ENGINE_EV_SENT, TEXTALK_ERR_SUCCESS);
+        else
+            tx_window_schedule(self);
+    }
+    else if( code == self->conf.ctrl.nak && !block->acked && !busy )
+    {
+        if( block->tries > self->conf.comm.retry_max )
+        {
+            tx_finish(self, TEXTALK_ENGINE_EV_FAILED, TEXTALK_ERR_BAD_EXCHANGE);
+            return;
+        }
+
+        push_tx_event(self, TEXTALK_ENGINE_EV_NAK_RECV, TEXTALK_ERR_BAD_EXCHANGE);
+        block->resend = true;
+        tx_window_schedule(self);
+    }
+}
+//------------------------------------------------------------------------------
+static
+bool tx_window_get_deadline(const textalk_engine_t *self, unsigned *deadline)
+{
+    // The time-out of the block being taken out, or the nearest echo time-out.
+    if( self->txoutsz )
+    {
+        *deadline = self->txdeadline;
+        return true;
+    }
+
+    bool armed = false;
+    for(size_t i = self->txbase; i < self->txnext; ++i)
+    {
+        const textalk_engine_block_t *block = &self->txblocks[ i % self->conf.comm.window ];
+        if( block->acked || block->resend ) continue;
+
+        if( !armed || time_is_reached(*deadline, block->deadline) )
+            *deadline = block->deadline;
+        armed = true;
+    }
+
+    return armed;
+}
+//------------------------------------------------------------------------------
+static
+void tx_window_on_time(textalk_engine_t *self)
+{
+    if( self->txoutsz )
+    {
+        if( !time_is_reached(self->now, self->txdeadline) ) return;
+
+        if( self->stats ) ++self->stats->timeout_send;
+        trace_put(self, TEXTALK_TRACE_TIMEOUT_SEND, 0, 0, TEXTALK_ERR_TIMEOUT);
+        tx_finish(self, TEXTALK_ENGINE_EV_FAILED, TEXTALK_ERR_TIMEOUT);
+        return;
+    }
+
+    // Send the blocks timed-out again.
+    bool timeout = false;
+    for(size_t i = self->txbase; i < self->txnext; ++i)
+    {
+        textalk_engine_block_t *block = &self->txblocks[ i % self->conf.comm.window ];
+        if( block->acked || block->resend || !time_is_reached(self->now, block->deadline) )
+            continue;
+
+        if( !timeout )
+        {
+            timeout = true;
+            if( self->stats ) ++self->stats->timeout_echo;
+            trace_put(self, TEXTALK_TRACE_TIMEOUT_ECHO, 0, 0, TEXTALK_ERR_TIMEOUT);
+            push_tx_event(self, TEXTALK_ENGINE_EV_TIMEOUT, TEXTALK_ERR_TIMEOUT);
+        }
+
+        if( block->tries > self->conf.comm.retry_max )
+        {
+            tx_finish(self, TEXTALK_ENGINE_EV_FAILED, TEXTALK_ERR_TIMEOUT);
+            return;
+        }
+
+        block->resend = true;
+    }
+
+    if( timeout ) tx_window_schedule(self);
+}
+//------------------------------------------------------------------------------
+static
+void tx_start(textalk_engine_t *self)
+{
+    // The line be got (or no line bids used), and the text starts to be taken out.
+    if( self->rxslots )
+    {
+        size_t blocksz = textalk_engine_get_block_size(self);
+
+        self->txstate = TX_WINDOW;
+        self->txstart = window_next_start_char(self->txstart);
+        self->txcount = ( self->txlen )?( ( self->txlen + blocksz - 1 ) / blocksz ):( 1 );
+        self->txbase  = 0;
+        self->txnext  = 0;
+        tx_window_schedule(self);
+    }
+    else
+    {
+        self->txstate    = TX_SENDING;
+        self->txtries    = self->conf.comm.retry_max + 1;
+        self->txdeadline = self->now + self->conf.comm.timeout.send;
+        tx_set_output(self);
+    }
+}
+//------------------------------------------------------------------------------
+static
+unsigned bid_get_delay(textalk_engine_t *self)
+{
+    // A random delay to avoid bidding at the same time again.
+    self->bidseed = self->bidseed * 1103515245 + 12345;
+    return ( self->bidseed >> 16 ) % ( self->conf.comm.timeout.bid + 1 );
+}
+//------------------------------------------------------------------------------
+static
+void tx_bid(textalk_engine_t *self)
+{
+    // Send ENQ and wait for ACK to get the line before sending a text.
+    push_ctrl_output(self, self->conf.ctrl.enq, 0);
+
+    self->txstate    = TX_BIDDING;
+    self->txdeadline = self->now + textalk_rtt_get_timeout(&self->rtt, self->txtries++);
+}
+//------------------------------------------------------------------------------
+static
+void tx_bid_again_or_fail(textalk_engine_t *self, int errcode)
+{
+    // Bid again after a random delay if NAK or nothing answered.
+    if( self->txtries <= self->conf.comm.retry_max )
+    {
+        self->txstate    = TX_BID_DELAY;
+        self->txdeadline = self->now + bid_get_delay(self);
+    }
+    else
+    {
+        tx_finish(self, TEXTALK_ENGINE_EV_FAILED, errcode);
+    }
+}
+//------------------------------------------------------------------------------
+static
+void tx_on_bid_answer(textalk_engine_t *self, char code)
+{
+    if( code == self->conf.ctrl.enq )
+    {
+        // Both sides bid at once, and the secondary yields;
+        // and the primary ignores the bid from the secondary, which will yield soon.
+        if( self->conf.comm.role == TEXTALK_ROLE_SECONDARY )
+        {
+            push_ctrl_output(self, self->conf.ctrl.ack, 0);
+            tx_finish(self, TEXTALK_ENGINE_EV_FAILED, TEXTALK_ERR_CONTENTION);
+        }
+    }
+    else if( code == self->conf.ctrl.eot )
+    {
+        tx_finish(self, TEXTALK_ENGINE_EV_FAILED, TEXTALK_ERR_TERMINATED);
+    }
+    else if( self->txstate != TX_BIDDING )
+    {
+        // Answers of an earlier bid are ignored while waiting to bid again.
+    }
+    else if( code == self->conf.ctrl.ack )
+    {
+        self->txholding = true;
+        tx_start(self);
+    }
+    else if( code == self->conf.ctrl.nak )
+    {
+        tx_bid_again_or_fail(self, TEXTALK_ERR_BAD_EXCHANGE);
+    }
+}
+//------------------------------------------------------------------------------
+static
+void rx_on_ctrl(textalk_engine_t *self, char code)
+{
+    trace_put(self, TEXTALK_TRACE_RECV_CTRL, code, 0, TEXTALK_ERR_SUCCESS);
+
+    bool is_bid = ( code == self->conf.ctrl.enq && self->conf.comm.role != TEXTALK_ROLE_NONE );
+    switch( self->txstate )
+    {
+    case TX_WAIT_ECHO:
+        push_event(self, TEXTALK_ENGINE_EV_CTRL_TAKEN, TEXTALK_ERR_SUCCESS)->ctrl = code;
+        tx_on_echo(self, code);
+        return;
+
+    case TX_WINDOW:
+        push_event(self, TEXTALK_ENGINE_EV_CTRL_TAKEN, TEXTALK_ERR_SUCCESS)->ctrl = code;
+        if( code == self->conf.ctrl.ack || code == self->conf.ctrl.nak )
+        {
+            // The sequence follows the code immediately.
+            self->rxstate    = RX_ECHO_SEQ;
+            self->rxecho     = code;
+            self->rxpktsz    = 0;
+            self->rxdeadline = self->now + self->conf.comm.timeout.echo;
+        }
+        else if( code == self->conf.ctrl.eot )
+        {
+            if( self->stats ) ++self->stats->eot_recv;
+            tx_finish(self, TEXTALK_ENGINE_EV_FAILED, TEXTALK_ERR_TERMINATED);
+        }
+        return;
+
+    case TX_BIDDING:
+    case TX_BID_DELAY:
+        push_event(self, TEXTALK_ENGINE_EV_CTRL_TAKEN, TEXTALK_ERR_SUCCESS)->ctrl = code;
+        tx_on_bid_answer(self, code);
+        return;
+
+    case TX_IDLE:
+        if( !is_bid ) break;
+
+        // Answer line bids from the remote while no text to send.
+        push_event(self, TEXTALK_ENGINE_EV_CTRL_TAKEN, TEXTALK_ERR_SUCCESS)->ctrl = code;
+        push_ctrl_output(self, self->conf.ctrl.ack, 0);
+        return;
+    }
+
+    push_event(self, TEXTALK_ENGINE_EV_CTRL, TEXTALK_ERR_SUCCESS)->ctrl = code;
+}
+//------------------------------------------------------------------------------
+static
+void rx_on_echo_seq(textalk_engine_t *self, char ch)
+{
+    // The echo will be ignored if the two copies of the sequence are different.
+    self->rxpkt[self->rxpktsz++] = parity_ch_remove(ch);
+    if( self->rxpktsz < 2 ) return;
+
+    self->rxstate = RX_IDLE;
+    if( self->rxpkt[0] == self->rxpkt[1] && self->txstate == TX_WINDOW )
+        tx_window_on_echo(self, self->rxecho, self->rxpkt[0]);
+}
+//------------------------------------------------------------------------------
+static
+void rx_count_decode_error(textalk_engine_t *self, int status)
+{
+    if( !self->stats ) return;
+
+    switch( status )
+    {
+    case TEXTALK_PACKET_BAD_PARITY:     ++self->stats->err_parity;      break;
+    case TEXTALK_PACKET_BAD_LRC:        ++self->stats->err_lrc;         break;
+    default:                            ++self->stats->err_integrity;   break;
+    }
+}
+//------------------------------------------------------------------------------
+static
+void rx_send_window_nak(textalk_engine_t *self, char seqch)
+{
+    // Ask the sender to send the block broken (or the block expected if unknown) again.
+    if( window_is_start_char(seqch) )
+    {
+        push_ctrl_output(self, self->conf.ctrl.nak, seqch);
+    }
+    else if( self->rxstart )
+    {
+        unsigned window = self->conf.comm.window;
+        unsigned offset = ( seqch )?( window_seq_offset(self->rxseq, seqch) ):( 0 );
+        if( offset < window && self->rxseq + offset )
+            push_ctrl_output(self,
+                             self->conf.ctrl.nak,
+                             window_seq_char(self->rxstart, self->rxseq + offset));
+    }
+}
+//------------------------------------------------------------------------------
+static
+void rx_reject(textalk_engine_t *self, int errcode)
+{
+    trace_put(self, TEXTALK_TRACE_BAD_FRAME, 0, self->rxpktsz, errcode);
+    if( self->stats ) ++self->stats->rx_frames;
+
+    self->rxstate = RX_IDLE;
+    if( self->rxslots )
+    {
+        // The sequence of a broken packet may still help the sender to resend quickly.
+        bool known = ( errcode != TEXTALK_ERR_TIMEOUT && self->rxpktsz > 1 );
+        rx_send_window_nak(self, known ? parity_ch_remove(self->rxpkt[1]) : 0);
+    }
+    else
+    {
+        push_ctrl_output(self, self->conf.ctrl.nak, 0);
+    }
+
+    push_event(self, TEXTALK_ENGINE_EV_NAK_SENT, errcode);
+}
+//------------------------------------------------------------------------------
+static
+void rx_acknowledge(textalk_engine_t *self, bool inslot)
+{
+    // The text delivered be consumed.
+    if( !self->rxslots )
+    {
+        push_ctrl_output(self, self->conf.ctrl.ack, 0);
+        return;
+    }
+
+    if( inslot )
+        self->rxslots[ self->rxseq % self->conf.comm.window ].used = false;
+    else
+        push_ctrl_output(self, self->conf.ctrl.ack, window_seq_char(self->rxstart, self->rxseq));
+
+    ++self->rxseq;
+}
+//------------------------------------------------------------------------------
+static
+void rx_deliver(textalk_engine_t *self, const char *text, size_t len, bool havemore, bool inslot)
+{
+    textalk_engine_event_t *event = push_event(self, TEXTALK_ENGINE_EV_TEXT, TEXTALK_ERR_SUCCESS);
+    event->text     = text;
+    event->textlen  = len;
+    event->havemore = havemore;
+
+    if( self->manualack )
+    {
+        self->rxstate  = RX_HELD;
+        self->rxinslot = inslot;
+    }
+    else
+    {
+        self->rxstate = RX_IDLE;
+        rx_acknowledge(self, inslot);
+    }
+}
+//------------------------------------------------------------------------------
+static
+bool rx_slot_is_ready(const textalk_engine_t *self)
+{
+    return self->rxslots &&
+           self->rxstate == RX_IDLE &&
+           self->rxstart &&
+           self->rxslots[ self->rxseq % self->conf.comm.window ].used;
+}
+//------------------------------------------------------------------------------
+static
+bool rx_deliver_slots(textalk_engine_t *self)
+{
+    // Deliver blocks arrived early when their turn comes.
+    bool delivered = false;
+    while( rx_slot_is_ready(self) && self->evcount + 2 <= TEXTALK_ENGINE_EVENT_MAX )
+    {
+        unsigned               index = self->rxseq % self->conf.comm.window;
+        textalk_engine_slot_t *slot  = &self->rxslots[index];
+
+        rx_deliver(self, window_get_slot_text(self, index), slot->len, slot->havemore, true);
+        delivered = true;
+    }
+
+    return delivered;
+}
+//------------------------------------------------------------------------------
+static
+bool rx_window_take(textalk_engine_t *self, char *text, size_t len, bool havemore)
+{
+    /*
+     * Take a block received in window mode,
+     * the sequence (parity removed) is at the first character of the text.
+     * Blocks arrived early are kept in the slots and acknowledged at once.
+     * Returns TRUE if a text be delivered.
+     */
+    unsigned window = self->conf.comm.window;
+    char     seqch  = text[0];
+
+    self->rxstate = RX_IDLE;
+    if( window_is_start_char(seqch) )
+    {
+        if( seqch != self->rxstart )
+        {
+            // The first block of a new exchange.
+            self->rxstart = seqch;
+            self->rxseq   = 0;
+            for(unsigned i = 0; i < window; ++i)
+                self->rxslots[i].used = false;
+        }
+        else if( self->rxseq )
+        {
+            // The first block delivered already, and its echo may be lost.
+            push_ctrl_output(self, self->conf.ctrl.ack, seqch);
+            return false;
+        }
+
+        rx_deliver(self, text + 1, len - 1, havemore, false);
+        return true;
+    }
+
+    // Blocks are ignored until the start of an exchange be received.
+    if( !self->rxstart ) return false;
+
+    // The first block has the start character only.
+    unsigned offset = window_seq_offset(self->rxseq, seqch);
+    if( offset < window && !( self->rxseq + offset ) ) return false;
+
+    if( !offset )
+    {
+        rx_deliver(self, text + 1, len - 1, havemore, false);
+        return true;
+    }
+    else if( offset < window )
+    {
+        // Keep the block arrived early.
+        unsigned index = ( self->rxseq + offset ) % window;
+        if( !self->rxslots[index].used )
+        {
+            memcpy(window_get_slot_text(self, index), text + 1, len);
+            self->rxslots[index].len      = len - 1;
+            self->rxslots[index].havemore = havemore;
+            self->rxslots[index].used     = true;
+        }
+
+        push_ctrl_output(self, self->conf.ctrl.ack, seqch);
+    }
+    else if( offset < WINDOW_SEQ_MOD && offset >= WINDOW_SEQ_MOD - window &&
+             WINDOW_SEQ_MOD - offset < self->rxseq )
+    {
+        // A block of this exchange delivered already, and its echo may be lost.
+        push_ctrl_output(self, self->conf.ctrl.ack, seqch);
+    }
+
+    return false;
+}
+//------------------------------------------------------------------------------
+static
+bool rx_finish_packet(textalk_engine_t *self)
+{
+    if( self->rxoverflow )
+    {
+        rx_count_decode_error(self, TEXTALK_PACKET_BAD_INTEGRITY);
+        rx_reject(self, TEXTALK_ERR_BUF_NOT_ENOUGH);
+        return false;
+    }
+
+    size_t textlen;
+    bool   havemore;
+    int    status = self->codec->decode(self->rxtext,
+                                        self->conf.comm.frame_max,
+                                        self->rxpkt,
+                                        self->rxpktsz,
+                                        &self->conf,
+                                        &textlen,
+                                        &havemore);
+
+    // Packets of window mode have the sequence at least.
+    if( !status && self->rxslots && !textlen ) status = TEXTALK_PACKET_BAD_INTEGRITY;
+    if( status )
+    {
+        rx_count_decode_error(self, status);
+        rx_reject(self,
+                  status == TEXTALK_PACKET_BUF_NOT_ENOUGH ?
+                  TEXTALK_ERR_BUF_NOT_ENOUGH : TEXTALK_ERR_BAD_EXCHANGE);
+        return false;
+    }
+
+    trace_put(self, TEXTALK_TRACE_RECV_FRAME, 0, self->rxpktsz, TEXTALK_ERR_SUCCESS);
+    if( self->stats )
+    {
+        ++self->stats->rx_frames;
+        textalk_hist_add(&self->stats->rx_time, self->now - self->rxstarted);
+    }
+
+    if( self->rxslots ) return rx_window_take(self, self->rxtext, textlen, havemore);
+
+    rx_deliver(self, self->rxtext, textlen, havemore, false);
+    return true;
+}
+//------------------------------------------------------------------------------
+static
+void rx_append(textalk_engine_t *self, char ch)
+{
+    if( self->rxpktsz < self->conf.comm.frame_max )
+        self->rxpkt[self->rxpktsz++] = ch;
+    else
+        self->rxoverflow = true;
+}
+//------------------------------------------------------------------------------
+static
+unsigned rx_get_deadline(const textalk_engine_t *self)
+{
+    // The packet deadline, or the gap deadline if it is nearer.
+    if( !self->conf.comm.timeout.gap || self->rxstate == RX_ECHO_SEQ ) return self->rxdeadline;
+
+    return time_is_reached(self->rxgapdeadline, self->rxdeadline) ?
+           self->rxdeadline : self->rxgapdeadline;
+}
+//------------------------------------------------------------------------------
+static
+bool rx_process_byte(textalk_engine_t *self, char ch)
+{
+    // Returns TRUE if a text be received.
+    int parity = self->conf.comm.parity;
+
+    self->rxgapdeadline = self->now + self->conf.comm.timeout.gap;
+
+    switch( self->rxstate )
+    {
+    case RX_IDLE:
+        if( ch == self->wire.stx )
+        {
+            self->rxstate    = RX_BODY;
+            self->rxpktsz    = 0;
+            self->rxoverflow = false;
+            self->rxstarted  = self->now;
+            self->rxdeadline = self->now + self->conf.comm.timeout.resp;
+            rx_append(self, ch);
+        }
+        else
+        {
+            char code = parity_ch_remove(ch);
+            if( iscntrl(code) ) rx_on_ctrl(self, code);
+        }
+        break;
+
+    case RX_BODY:
+        if( self->conf.comm.parity_reject && !parity_ch_check(ch, parity) )
+        {
+            rx_count_decode_error(self, TEXTALK_PACKET_BAD_PARITY);
+            rx_reject(self, TEXTALK_ERR_BAD_EXCHANGE);
+            break;
+        }
+
+        rx_append(self, ch);
+        if( ch == self->wire.etx || ch == self->wire.etb )
+        {
+            if( !self->conf.comm.have_lrc )
+                return rx_finish_packet(self);
+
+            self->rxstate = RX_LRC;
+        }
+        break;
+
+    case RX_LRC:
+        rx_append(self, ch);
+        return rx_finish_packet(self);
+
+    case RX_ECHO_SEQ:
+        rx_on_echo_seq(self, ch);
+        break;
+    }
+
+    return false;
+}
+//------------------------------------------------------------------------------
+int textalk_engine_init(textalk_engine_t *self, const textalk_conf_t *conf, unsigned now)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Constructor.
+     *
+     * @param self Object instance.
+     * @param conf Communication configuration.
+     * @param now  The current time in milliseconds.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     *
+     * @remarks Buffers will be allocated by the default allocator.
+     */
+    return textalk_engine_init_ex(self, conf, now, NULL);
+}
+//------------------------------------------------------------------------------
+int textalk_engine_init_ex(textalk_engine_t          *self,
+                           const textalk_conf_t      *conf,
+                           unsigned                   now,
+                           const textalk_allocator_t *alloc)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Constructor with an allocator.
+     *
+     * @param self  Object instance.
+     * @param conf  Communication configuration.
+     * @param now   The current time in milliseconds.
+     * @param alloc The allocator to allocate buffers of the engine,
+     *              and can be NULL to use the default allocator.
+     *              Buffers are allocated once here,
+     *              and their total size is about four times of the maximum packet size;
+     *              plus one packet size for each packet of the window
+     *              if the window mode is used.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     *
+     * @remarks The object must be de-initialised by textalk_engine_deinit
+     *          even if this function failed.
+     */
+    memset(self, 0, sizeof(*self));
+
+    self->conf    = *conf;
+    textalk_packet_get_wire_ctrl(&self->wire, &self->conf);
+    self->codec   = &runtime_codec;
+    self->alloc   = alloc ? *alloc : *textalk_allocator_get_defaults();
+    self->now     = now;
+    self->bidseed = now ^ (unsigned)(size_t) self;
+
+    textalk_rtt_init(&self->rtt, &self->conf.comm);
+
+    if( !self->conf.comm.frame_max )
+        self->conf.comm.frame_max = TEXTALK_PKT_MAX_SIZE;
+    if( self->conf.comm.frame_max < TEXTALK_PKT_MIN_SIZE )
+        return TEXTALK_ERR_INVALID_ARG;
+
+    if( self->conf.comm.window > TEXTALK_WINDOW_MAX )
+        return TEXTALK_ERR_INVALID_ARG;
+    unsigned window = ( self->conf.comm.window > 1 )?( self->conf.comm.window ):( 0 );
+
+    /*
+     * One block for the slot records,
+     * the send packet and text, the receive packet and text,
+     * and the slot buffers.
+     */
+    size_t framesz = self->conf.comm.frame_max;
+    size_t slotsz  = window * sizeof(textalk_engine_slot_t);
+    char  *block   = self->alloc.alloc(self->alloc.userarg, slotsz + ( 4 + window ) * framesz);
+    if( !block ) return TEXTALK_ERR_BUF_NOT_ENOUGH;
+
+    self->mem     = block;
+    self->rxslots = window ? (textalk_engine_slot_t*) block : NULL;
+    self->txpkt   = block + slotsz;
+    self->txtext  = self->txpkt + framesz;
+    self->rxpkt   = self->txtext + framesz;
+    self->rxtext  = self->rxpkt + framesz;
+    self->rxwin   = window ? self->rxtext + framesz : NULL;
+
+    for(unsigned i = 0; i < window; ++i)
+        self->rxslots[i].used = false;
+
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+void textalk_engine_deinit(textalk_engine_t *self)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Destructor.
+     */
+    if( self->mem && self->alloc.free )
+        self->alloc.free(self->alloc.userarg, self->mem);
+
+    self->mem     = NULL;
+    self->rxslots = NULL;
+    self->rxwin   = NULL;
+    self->txpkt   = NULL;
+    self->txtext  = NULL;
+    self->rxpkt   = NULL;
+    self->rxtext  = NULL;
+}
+//------------------------------------------------------------------------------
+void textalk_engine_reset(textalk_engine_t *self, unsigned now)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Abandon all exchanges, output, and events; and keep the buffers.
+     *
+     * @param self Object instance.
+     * @param now  The current time in milliseconds.
+     */
+    self->now = now;
+
+    self->rxstate    = RX_IDLE;
+    self->rxpktsz    = 0;
+    self->rxoverflow = false;
+    self->rxstart    = 0;
+
+    self->txstate   = TX_IDLE;
+    self->txoutsz   = 0;
+    self->txpos     = 0;
+    self->txlen     = 0;
+    self->txholding = false;
+
+    self->ctrloutsz = 0;
+    self->evhead    = 0;
+    self->evcount   = 0;
+}
+//------------------------------------------------------------------------------
+static
+int tx_prepare(textalk_engine_t *self)
+{
+    // Encode the packet of stop-and-wait mode once for all tries.
+    if( self->vectored && self->conf.comm.parity == TEXTALK_PARITY_NONE )
+    {
+        /*
+         * The packet be taken out as header, the data of the user, and trailer,
+         * so the data do not need to be copied into a packet buffer.
+         * It works only when parity is not used.
+         */
+        self->txheadsz = textalk_packet_encode_head(self->txhead, sizeof(self->txhead), &self->conf);
+        self->txtailsz = textalk_packet_encode_tail(self->txtail,
+                                                    sizeof(self->txtail),
+                                                    self->txdata,
+                                                    self->txlen,
+                                                    &self->conf,
+                                                    self->txhavemore);
+        self->txbody   = self->txdata;
+        self->txbodysz = self->txlen;
+
+        size_t pktsz = self->txheadsz + self->txbodysz + self->txtailsz;
+        return ( pktsz <= self->conf.comm.frame_max )?( TEXTALK_ERR_SUCCESS ):( TEXTALK_ERR_BUF_NOT_ENOUGH );
+    }
+
+    self->txheadsz = 0;
+    self->txtailsz = 0;
+    self->txbody   = self->txpkt;
+    self->txbodysz = self->codec->encode(self->txpkt,
+                                         self->conf.comm.frame_max,
+                                         self->txdata,
+                                         self->txlen,
+                                         &self->conf,
+                                         self->txhavemore);
+
+    return ( self->txbodysz )?( TEXTALK_ERR_SUCCESS ):( TEXTALK_ERR_BUF_NOT_ENOUGH );
+}
+//------------------------------------------------------------------------------
+int textalk_engine_send(textalk_engine_t *self, const char *text, size_t len, bool havemore)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Start to send a text.
+     *
+     * @param self     Object instance.
+     * @param text     The text to be sent, and it will be copied.
+     * @param len      Length of the text.
+     * @param havemore Send with ETB (TRUE) or ETX (FALSE).
+     * @return One of error codes defined in ::textalk_errcode_t.
+     */
+    if( !text ) return TEXTALK_ERR_INVALID_ARG;
+    if( self->txstate != TX_IDLE ) return TEXTALK_ERR_BUSY;
+    if( !self->mem ) return TEXTALK_ERR_BUF_NOT_ENOUGH;
+    if( len >= self->conf.comm.frame_max ) return TEXTALK_ERR_BUF_NOT_ENOUGH;
+
+    memcpy(self->txtext, text, len);
+    self->txtext[len] = 0;
+
+    return textalk_engine_send_ref(self, self->txtext, len, havemore);
+}
+//------------------------------------------------------------------------------
+int textalk_engine_send_ref(textalk_engine_t *self, const void *data, size_t len, bool havemore)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Start to send data without copying them.
+     *
+     * @param self     Object instance.
+     * @param data     The data to be sent,
+     *                 and they must be kept until the text be sent or failed.
+     * @param len      Length of the data.
+     * @param havemore Send with ETB (TRUE) or ETX (FALSE).
+     * @return One of error codes defined in ::textalk_errcode_t.
+     *
+     * @remarks In window mode, data of any length will be split into blocks,
+     *          and the last block be sent with ETB if @a havemore is TRUE.
+     *          In stop-and-wait mode, the data must fit in one packet.
+     */
+    if( !data && len ) return TEXTALK_ERR_INVALID_ARG;
+    if( self->txstate != TX_IDLE ) return TEXTALK_ERR_BUSY;
+    if( !self->mem ) return TEXTALK_ERR_BUF_NOT_ENOUGH;
+
+    self->txdata     = data ? data : "";
+    self->txlen      = len;
+    self->txhavemore = havemore;
+
+    if( self->rxslots )
+    {
+        if( !textalk_engine_get_block_size(self) ) return TEXTALK_ERR_BUF_NOT_ENOUGH;
+    }
+    else
+    {
+        int errcode;
+        if(( errcode = tx_prepare(self) )) return errcode;
+    }
+
+    if( self->conf.comm.role != TEXTALK_ROLE_NONE && !self->txholding )
+    {
+        self->txtries = 0;
+        tx_bid(self);
+    }
+    else
+    {
+        tx_start(self);
+    }
+
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+int textalk_engine_send_ctrl(textalk_engine_t *self, char code)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Queue a control code to send.
+     *
+     * @param self Object instance.
+     * @param code The character to be sent.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     */
+    if( self->ctrloutsz >= sizeof(self->ctrlout) ) return TEXTALK_ERR_BUSY;
+    if( self->evcount >= TEXTALK_ENGINE_EVENT_MAX ) return TEXTALK_ERR_BUSY;
+
+    push_ctrl_output(self, code, 0);
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+size_t textalk_engine_feed(textalk_engine_t *self, const void *data, size_t size)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Push received data into the engine.
+     *
+     * @param self Object instance.
+     * @param data The data received.
+     * @param size Size of the data.
+     * @return Size of data be consumed.
+     *
+     * @remarks Data will be consumed until a text be received
+     *          or the event queue is full,
+     *          and the rest should be fed again after the events be taken.
+     * @remarks Nothing will be consumed while a text is held
+     *          (see textalk_engine_set_manual_ack),
+     *          or when a block kept in window mode be delivered instead.
+     * @remarks Characters are stamped with the time given to textalk_engine_on_time,
+     *          so it should be called before feeding if the gap time-out
+     *          (see textalk_conf_timeout_t::gap) is used.
+     */
+    if( rx_deliver_slots(self) ) return 0;
+
+    const char *bytes = data;
+
+    // One byte can raise four events at most.
+    size_t pos = 0;
+    while( pos < size &&
+           self->rxstate != RX_HELD &&
+           self->evcount + 4 <= TEXTALK_ENGINE_EVENT_MAX )
+    {
+        if( rx_process_byte(self, bytes[pos++]) )
+            break;
+    }
+
+    if( self->stats ) self->stats->rx_bytes += pos;
+    return pos;
+}
+//------------------------------------------------------------------------------
+void textalk_engine_on_time(textalk_engine_t *self, unsigned now)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Update the current time and process time-outs.
+     *
+     * @param self Object instance.
+     * @param now  The current time in milliseconds.
+     */
+    self->now = now;
+
+    // Time-outs can raise six events at most.
+    if( self->evcount + 6 > TEXTALK_ENGINE_EVENT_MAX ) return;
+
+    if( ( self->rxstate == RX_BODY || self->rxstate == RX_LRC ) &&
+        time_is_reached(now, rx_get_deadline(self)) )
+    {
+        if( self->stats ) ++self->stats->timeout_frame;
+        rx_reject(self, TEXTALK_ERR_TIMEOUT);
+    }
+    else if( self->rxstate == RX_ECHO_SEQ && time_is_reached(now, self->rxdeadline) )
+    {
+        self->rxstate = RX_IDLE;
+    }
+
+    bool expired = time_is_reached(now, self->txdeadline);
+    switch( self->txstate )
+    {
+    case TX_SENDING:
+        if( !expired ) break;
+
+        if( self->stats ) ++self->stats->timeout_send;
+        trace_put(self, TEXTALK_TRACE_TIMEOUT_SEND, 0, 0, TEXTALK_ERR_TIMEOUT);
+        tx_finish(self, TEXTALK_ENGINE_EV_FAILED, TEXTALK_ERR_TIMEOUT);
+        break;
+
+    case TX_WAIT_ECHO:
+        if( !expired ) break;
+
+        if( self->stats ) ++self->stats->timeout_echo;
+        trace_put(self, TEXTALK_TRACE_TIMEOUT_ECHO, 0, 0, TEXTALK_ERR_TIMEOUT);
+        push_tx_event(self, TEXTALK_ENGINE_EV_TIMEOUT, TEXTALK_ERR_TIMEOUT);
+        tx_retry_or_fail(self, TEXTALK_ERR_TIMEOUT);
+        break;
+
+    case TX_BIDDING:
+        if( expired ) tx_bid_again_or_fail(self, TEXTALK_ERR_TIMEOUT);
+        break;
+
+    case TX_BID_DELAY:
+        if( expired ) tx_bid(self);
+        break;
+
+    case TX_WINDOW:
+        tx_window_on_time(self);
+        break;
+    }
+
+    rx_deliver_slots(self);
+}
+//------------------------------------------------------------------------------
+int textalk_engine_accept(textalk_engine_t *self)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Accept the text held, and acknowledge it to the remote.
+     *
+     * @param self Object instance.
+     * @return One of error codes defined in ::textalk_errcode_t:
+     *         ::TEXTALK_ERR_INVALID_ARG if no text is held,
+     *         or ::TEXTALK_ERR_BUSY if the events should be taken first.
+     */
+    if( self->rxstate != RX_HELD ) return TEXTALK_ERR_INVALID_ARG;
+    if( self->evcount >= TEXTALK_ENGINE_EVENT_MAX ) return TEXTALK_ERR_BUSY;
+
+    self->rxstate = RX_IDLE;
+    rx_acknowledge(self, self->rxinslot);
+
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+int textalk_engine_reject(textalk_engine_t *self)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Reject the text held, and ask the remote to send it again.
+     *
+     * @param self Object instance.
+     * @return One of error codes defined in ::textalk_errcode_t,
+     *         see textalk_engine_accept.
+     *
+     * @remarks A block kept in window mode has been acknowledged already,
+     *          and it will be delivered again instead.
+     */
+    if( self->rxstate != RX_HELD ) return TEXTALK_ERR_INVALID_ARG;
+    if( self->evcount >= TEXTALK_ENGINE_EVENT_MAX ) return TEXTALK_ERR_BUSY;
+
+    self->rxstate = RX_IDLE;
+    if( !self->rxslots )
+        push_ctrl_output(self, self->conf.ctrl.nak, 0);
+    else if( !self->rxinslot )
+        push_ctrl_output(self, self->conf.ctrl.nak, window_seq_char(self->rxstart, self->rxseq));
+
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+int textalk_engine_terminate(textalk_engine_t *self)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Drop the text held, and send EOT to terminate the exchange.
+     *
+     * @param self Object instance.
+     * @return One of error codes defined in ::textalk_errcode_t,
+     *         see textalk_engine_accept.
+     */
+    if( self->rxstate != RX_HELD ) return TEXTALK_ERR_INVALID_ARG;
+    if( self->evcount >= TEXTALK_ENGINE_EVENT_MAX ) return TEXTALK_ERR_BUSY;
+
+    self->rxstate = RX_IDLE;
+    self->rxstart = 0;
+    push_ctrl_output(self, self->conf.ctrl.eot, 0);
+
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+void textalk_engine_on_resp_timeout(textalk_engine_t *self)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Report that the user waited for a text longer than the response time-out,
+     *        and the remote will be asked to send again.
+     *
+     * @param self Object instance.
+     *
+     * @remarks In window mode, NAK will be sent only if the block expected is known.
+     */
+    if( self->evcount >= TEXTALK_ENGINE_EVENT_MAX ) return;
+
+    if( self->stats ) ++self->stats->timeout_resp;
+    trace_put(self, TEXTALK_TRACE_TIMEOUT_RESP, 0, 0, TEXTALK_ERR_TIMEOUT);
+
+    if( self->rxslots )
+        rx_send_window_nak(self, 0);
+    else
+        push_ctrl_output(self, self->conf.ctrl.nak, 0);
+}
+//------------------------------------------------------------------------------
+static
+bool tx_is_between_packets(const textalk_engine_t *self)
+{
+    // Control codes can only be put between packets.
+    return !self->txoutsz || !self->txpos;
+}
+//------------------------------------------------------------------------------
+size_t textalk_engine_peek_output(const textalk_engine_t *self, const void **data)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Get data to be sent out.
+     *
+     * @param self Object instance.
+     * @param data Return the data to be sent.
+     * @return Size of the data; or ZERO if there have nothing to send.
+     *
+     * @remarks The data will be kept until be dropped by textalk_engine_drop_output.
+     */
+    if( self->ctrloutsz && tx_is_between_packets(self) )
+    {
+        *data = self->ctrlout;
+        return self->ctrloutsz;
+    }
+
+    if( !self->txoutsz ) return 0;
+
+    size_t pos = self->txpos;
+    if( pos < self->txheadsz )
+    {
+        *data = self->txhead + pos;
+        return self->txheadsz - pos;
+    }
+
+    pos -= self->txheadsz;
+    if( pos < self->txbodysz )
+    {
+        *data = self->txbody + pos;
+        return self->txbodysz - pos;
+    }
+
+    pos -= self->txbodysz;
+    *data = self->txtail + pos;
+    return self->txtailsz - pos;
+}
+//------------------------------------------------------------------------------
+int textalk_engine_peek_vector(const textalk_engine_t *self, textalk_iovec_t *iov, int iovmax)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Get data to be sent out as segments, to be sent by one vectored write.
+     *
+     * @param self   Object instance.
+     * @param iov    Return the segments.
+     * @param iovmax The maximum count of segments, and three is enough for a packet.
+     * @return Count of segments; or ZERO if there have nothing to send.
+     *
+     * @remarks The data will be kept until be dropped by textalk_engine_drop_output,
+     *          which can drop data across segments.
+     */
+    if( iovmax < 1 ) return 0;
+
+    if( self->ctrloutsz && tx_is_between_packets(self) )
+    {
+        iov[0].data = self->ctrlout;
+        iov[0].size = self->ctrloutsz;
+        return 1;
+    }
+
+    const char *parts[3] = { self->txhead,   self->txbody,   self->txtail   };
+    size_t      sizes[3] = { self->txheadsz, self->txbodysz, self->txtailsz };
+
+    int    count = 0;
+    size_t pos   = ( self->txoutsz )?( self->txpos ):( self->txheadsz + self->txbodysz + self->txtailsz );
+    for(int i = 0; i < 3 && count < iovmax; ++i)
+    {
+        if( pos >= sizes[i] )
+        {
+            pos -= sizes[i];
+            continue;
+        }
+
+        iov[count].data = parts[i] + pos;
+        iov[count].size = sizes[i] - pos;
+        ++count;
+        pos = 0;
+    }
+
+    return count;
+}
+//------------------------------------------------------------------------------
+void textalk_engine_drop_output(textalk_engine_t *self, size_t size)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Remove data that have been sent out.
+     *
+     * @param self Object instance.
+     * @param size Size of data to remove,
+     *             and should not be larger than the size returned by
+     *             textalk_engine_peek_output (or the total size of segments
+     *             returned by textalk_engine_peek_vector).
+     */
+    if( !size ) return;
+    if( self->stats ) self->stats->tx_bytes += size;
+
+    if( self->ctrloutsz && tx_is_between_packets(self) )
+    {
+        assert( size <= self->ctrloutsz );
+        memmove(self->ctrlout, self->ctrlout + size, self->ctrloutsz - size);
+        self->ctrloutsz -= size;
+        return;
+    }
+
+    if( !self->txoutsz ) return;
+
+    assert( size <= self->txoutsz - self->txpos );
+    self->txpos += size;
+    if( self->txpos < self->txoutsz ) return;
+
+    trace_put(self, TEXTALK_TRACE_SEND_FRAME, 0, self->txoutsz, TEXTALK_ERR_SUCCESS);
+    if( self->stats ) ++self->stats->tx_frames;
+
+    if( self->txstate == TX_WINDOW )
+    {
+        tx_window_on_output(self);
+        return;
+    }
+
+    unsigned tries = self->conf.comm.retry_max + 1 - self->txtries;
+
+    self->txstate    = TX_WAIT_ECHO;
+    self->txoutsz    = 0;
+    self->txsent     = self->now;
+    self->txdeadline = self->now + textalk_rtt_get_timeout(&self->rtt, tries);
+}
+//------------------------------------------------------------------------------
+size_t textalk_engine_take_output(textalk_engine_t *self, void *buf, size_t size)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Take data to be sent out.
+     *
+     * @param self Object instance.
+     * @param buf  A buffer to receive the data.
+     * @param size Size of the buffer.
+     * @return Size of data be taken; or ZERO if there have nothing to send.
+     *
+     * @remarks Data taken are regarded as sent out,
+     *          use textalk_engine_peek_output and textalk_engine_drop_output instead
+     *          if the data may be sent out partially.
+     */
+    char   *dest  = buf;
+    size_t  total = 0;
+
+    const void *data;
+    size_t      datasz;
+    while( total < size && ( datasz = textalk_engine_peek_output(self, &data) ) )
+    {
+        size_t copysz = ( datasz < size - total )?( datasz ):( size - total );
+        memcpy(dest + total, data, copysz);
+        textalk_engine_drop_output(self, copysz);
+        total += copysz;
+    }
+
+    return total;
+}
+//------------------------------------------------------------------------------
+bool textalk_engine_next_event(textalk_engine_t *self, textalk_engine_event_t *event)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Take the next event.
+     *
+     * @param self  Object instance.
+     * @param event Return the event.
+     * @return TRUE if an event be taken; and FALSE if there have no events.
+     *
+     * @remarks The text carried by an event is owned by the engine,
+     *          and is valid until the next data be fed or the next text be sent.
+     */
+    if( !self->evcount ) return false;
+
+    *event = self->evqueue[self->evhead];
+    self->evhead = ( self->evhead + 1 ) % TEXTALK_ENGINE_EVENT_MAX;
+    --self->evcount;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool textalk_engine_peek_event(const textalk_engine_t *self, textalk_engine_event_t *event)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Get the next event without taking it.
+     *
+     * @param self  Object instance.
+     * @param event Return the event.
+     * @return TRUE if there have an event; and FALSE if not.
+     */
+    if( !self->evcount ) return false;
+
+    *event = self->evqueue[self->evhead];
+    return true;
+}
+//------------------------------------------------------------------------------
+bool textalk_engine_get_deadline(const textalk_engine_t *self, unsigned *deadline)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Get the time that textalk_engine_on_time should be called at.
+     *
+     * @param self     Object instance.
+     * @param deadline Return the nearest deadline in milliseconds.
+     * @return TRUE if there have any timer running; and FALSE if not.
+     */
+    bool     armed   = false;
+    unsigned nearest = 0;
+
+    if( self->rxstate == RX_BODY || self->rxstate == RX_LRC || self->rxstate == RX_ECHO_SEQ )
+    {
+        armed   = true;
+        nearest = rx_get_deadline(self);
+    }
+
+    // A block kept in window mode is ready to be delivered.
+    if( rx_slot_is_ready(self) )
+    {
+        armed   = true;
+        nearest = self->now;
+    }
+
+    unsigned txdeadline = self->txdeadline;
+    bool     txarmed    = ( self->txstate == TX_WINDOW )?
+                          ( tx_window_get_deadline(self, &txdeadline) ):
+                          ( self->txstate != TX_IDLE );
+    if( txarmed && ( !armed || time_is_reached(nearest, txdeadline) ) )
+    {
+        armed   = true;
+        nearest = txdeadline;
+    }
+
+    if( armed ) *deadline = nearest;
+    return armed;
+}
+//------------------------------------------------------------------------------
+void textalk_engine_set_stats(textalk_engine_t *self, textalk_stats_t *stats)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Set the counters to be updated by the engine,
+     *        see textalk_get_stats.
+     *
+     * @param self  Object instance.
+     * @param stats The counters, and can be NULL to stop counting.
+     */
+    self->stats = stats;
+}
+//------------------------------------------------------------------------------
+void textalk_engine_set_trace(textalk_engine_t *self, textalk_trace_t *trace)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Set the trace ring to record protocol events,
+     *        see textalk_set_trace.
+     *
+     * @param self  Object instance.
+     * @param trace The trace ring, and can be NULL to stop tracing.
+     *              Records are stamped with the time of the engine.
+     */
+    self->trace = trace;
+}
+//------------------------------------------------------------------------------
+int textalk_engine_set_codec(textalk_engine_t *self, const textalk_codec_t *codec)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Set the codec to encode and decode packets.
+     *
+     * @param self  Object instance.
+     * @param codec The codec, and can be NULL to use the default codec
+     *              that follows the configuration at runtime.
+     *              The codec must be kept during the engine be used.
+     * @return One of error codes defined in ::textalk_errcode_t:
+     *         ::TEXTALK_ERR_INVALID_ARG if the codec does not match the configuration,
+     *         or ::TEXTALK_ERR_BUSY if a text is being sent or received.
+     *
+     * @remarks A codec of a fixed packet format (see TTextalkProfile::codec)
+     *          saves the branches on the configuration in each packet.
+     * @remarks Blocks of window mode are always encoded by the default codec,
+     *          because they carry a sequence character.
+     */
+    if( !codec ) codec = &runtime_codec;
+    if( codec->match && !codec->match(&self->conf) ) return TEXTALK_ERR_INVALID_ARG;
+    if( self->txstate != TX_IDLE || self->rxstate != RX_IDLE ) return TEXTALK_ERR_BUSY;
+
+    self->codec = codec;
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+void textalk_engine_set_manual_ack(textalk_engine_t *self, bool manual)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Set if texts received wait for the user to acknowledge them.
+     *
+     * @param self   Object instance.
+     * @param manual FALSE (default) to acknowledge texts at once when they be received;
+     *               or TRUE to hold each text until textalk_engine_accept,
+     *               textalk_engine_reject, or textalk_engine_terminate be called,
+     *               and no data will be consumed before that.
+     */
+    self->manualack = manual;
+}
+//------------------------------------------------------------------------------
+void textalk_engine_set_vectored(textalk_engine_t *self, bool vectored)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Set if packets refer to the data to be sent instead of being encoded.
+     *
+     * @param self     Object instance.
+     * @param vectored TRUE to take packets out as header, data, and trailer
+     *                 (see textalk_engine_peek_vector) when parity is not used;
+     *                 or FALSE (default) to encode them into the packet buffer.
+     */
+    self->vectored = vectored;
+}
+//------------------------------------------------------------------------------
+bool textalk_engine_is_busy(const textalk_engine_t *self)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Check if a text is being sent.
+     */
+    return self->txstate != TX_IDLE;
+}
+//------------------------------------------------------------------------------
+bool textalk_engine_is_receiving(const textalk_engine_t *self)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Check if a packet is being received.
+     */
+    return self->rxstate == RX_BODY || self->rxstate == RX_LRC;
+}
+//------------------------------------------------------------------------------
+size_t textalk_engine_get_block_size(const textalk_engine_t *self)
+{
+    /**
+     * @memberof textalk_engine_t
+     * @brief Get the maximum text size of a packet
+     *        (STX, the sequence of window mode, ETX, and LRC excluded).
+     */
+    size_t overhead = ( self->conf.comm.have_lrc )?( 3 ):( 2 );
+    if( self->rxslots ) ++overhead;
+
+    return ( self->conf.comm.frame_max > overhead )?( self->conf.comm.frame_max - overhead ):( 0 );
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,549 @@
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "textalk_executor.h"
+
+#define IDLE_TIMEOUT 1000
+
+//------------------------------------------------------------------------------
+//---- Lock-free queues --------------------------------------------------------
+//------------------------------------------------------------------------------
+/*
+ * Producers push nodes to the head of a stack by atomic exchange,
+ * and the consumer takes the whole stack at once, and then reverses it to the order of pushing.
+ * The consumer never touches a node still linked by producers,
+ * so there have no ABA problem.
+ */
+//------------------------------------------------------------------------------
+static
+bool req_queue_push(textalk_exec_req_t **queue, textalk_exec_req_t *req)
+{
+    // Returns TRUE if the queue was empty.
+    textalk_exec_req_t *head = __atomic_load_n(queue, __ATOMIC_RELAXED);
+    do
+    {
+        req->next = head;
+    } while( !__atomic_compare_exchange_n(queue, &head, req, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED) );
+
+    return !head;
+}
+//------------------------------------------------------------------------------
+static
+textalk_exec_req_t* req_queue_take_all(textalk_exec_req_t **queue)
+{
+    textalk_exec_req_t *head = __atomic_exchange_n(queue, NULL, __ATOMIC_ACQUIRE);
+
+    textalk_exec_req_t *list = NULL;
+    while( head )
+    {
+        textalk_exec_req_t *next = head->next;
+        head->next = list;
+        list       = head;
+        head       = next;
+    }
+
+    return list;
+}
+//------------------------------------------------------------------------------
+static
+bool text_queue_push(textalk_exec_text_t **queue, textalk_exec_text_t *text)
+{
+    // Returns TRUE if the queue was empty.
+    textalk_exec_text_t *head = __atomic_load_n(queue, __ATOMIC_RELAXED);
+    do
+    {
+        text->next = head;
+    } while( !__atomic_compare_exchange_n(queue, &head, text, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED) );
+
+    return !head;
+}
+//------------------------------------------------------------------------------
+static
+textalk_exec_text_t* text_queue_take_all(textalk_exec_text_t **queue)
+{
+    textalk_exec_text_t *head = __atomic_exchange_n(queue, NULL, __ATOMIC_ACQUIRE);
+
+    textalk_exec_text_t *list = NULL;
+    while( head )
+    {
+        textalk_exec_text_t *next = head->next;
+        head->next = list;
+        list       = head;
+        head       = next;
+    }
+
+    return list;
+}
+//------------------------------------------------------------------------------
+//---- I/O thread --------------------------------------------------------------
+//------------------------------------------------------------------------------
+static
+void notify_consumer(textalk_executor_t *self)
+{
+    uint64_t count = 1;
+    ssize_t  res   = write(self->notifyfd, &count, sizeof(count));
+    (void) res;
+}
+//------------------------------------------------------------------------------
+static
+void port_complete(textalk_executor_port_t *port, textalk_exec_req_t *req, int errcode)
+{
+    req->errcode = errcode;
+    if( req_queue_push(&port->owner->donequeue, req) )
+        notify_consumer(port->owner);
+}
+//------------------------------------------------------------------------------
+static
+void port_start_next(textalk_executor_port_t *port)
+{
+    while( !port->current && port->pendhead )
+    {
+        textalk_exec_req_t *req = port->pendhead;
+        port->pendhead = req->next;
+        if( !port->pendhead ) port->pendtail = NULL;
+
+        int errcode = textalk_reactor_send_text(&port->owner->reactor,
+                                                port->line,
+                                                req->text,
+                                                req->havemore);
+        if( errcode )
+            port_complete(port, req, errcode);
+        else
+            port->current = req;
+    }
+}
+//------------------------------------------------------------------------------
+static
+void port_on_done(void *userarg, textalk_t *session, int errcode)
+{
+    textalk_executor_port_t *port = userarg;
+
+    textalk_exec_req_t *req = port->current;
+    port->current = NULL;
+
+    if( req ) port_complete(port, req, errcode);
+
+    // Start the next one right away, with no round trip through the queue.
+    port_start_next(port);
+}
+//------------------------------------------------------------------------------
+static
+void collect_requests(textalk_executor_t *self)
+{
+    textalk_exec_req_t *req = req_queue_take_all(&self->subqueue);
+    while( req )
+    {
+        textalk_exec_req_t      *next = req->next;
+        textalk_executor_port_t *port = &self->ports[req->port];
+
+        req->next = NULL;
+        if( port->pendtail )
+            port->pendtail->next = req;
+        else
+            port->pendhead = req;
+        port->pendtail = req;
+
+        req = next;
+    }
+}
+//------------------------------------------------------------------------------
+static
+void dispatch_requests(textalk_executor_t *self)
+{
+    collect_requests(self);
+
+    for(unsigned i = 0; i < self->portcount; ++i)
+        port_start_next(&self->ports[i]);
+}
+//------------------------------------------------------------------------------
+static
+void* executor_thread(textalk_executor_t *self)
+{
+    while( !__atomic_load_n(&self->stopping, __ATOMIC_ACQUIRE) )
+    {
+        dispatch_requests(self);
+        if( textalk_reactor_run_once(&self->reactor, IDLE_TIMEOUT) ) break;
+    }
+
+    return NULL;
+}
+//------------------------------------------------------------------------------
+//---- Session events ----------------------------------------------------------
+//------------------------------------------------------------------------------
+static
+int port_sender(void *userarg, const void *data, size_t size)
+{
+    textalk_executor_port_t *port = userarg;
+    return port->events.sender(port->events.userarg, data, size);
+}
+//------------------------------------------------------------------------------
+static
+int port_recver(void *userarg, void *buf, size_t size)
+{
+    textalk_executor_port_t *port = userarg;
+    return port->events.recver(port->events.userarg, buf, size);
+}
+//------------------------------------------------------------------------------
+static
+void port_on_send_ctrl(void *userarg, char code)
+{
+    textalk_executor_port_t *port = userarg;
+    if( port->events.on_send_ctrl )
+        port->events.on_send_ctrl(port->events.userarg, code);
+}
+//------------------------------------------------------------------------------
+static
+void port_on_recv_ctrl(void *userarg, char code)
+{
+    textalk_executor_port_t *port = userarg;
+    if( port->events.on_recv_ctrl )
+        port->events.on_recv_ctrl(port->events.userarg, code);
+}
+//------------------------------------------------------------------------------
+static
+void port_on_send_text(void *userarg, const char *text)
+{
+    textalk_executor_port_t *port = userarg;
+    if( port->events.on_send_text )
+        port->events.on_send_text(port->events.userarg, text);
+}
+//------------------------------------------------------------------------------
+static
+void port_on_recv_text(void *userarg, const char *text)
+{
+    textalk_executor_port_t *port = userarg;
+    if( port->events.on_recv_text )
+        port->events.on_recv_text(port->events.userarg, text);
+}
+//------------------------------------------------------------------------------
+static
+void port_on_text(void *userarg, textalk_t *session, const char *text, size_t len, bool havemore)
+{
+    textalk_executor_port_t *port = userarg;
+    textalk_executor_t      *self = port->owner;
+
+    textalk_exec_text_t *item = self->alloc.alloc(self->alloc.userarg, sizeof(*item) + len + 1);
+    if( !item )
+    {
+        // The text has been acknowledged already, and can only be counted as lost.
+        __atomic_fetch_add(&self->textdropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    item->port     = port->index;
+    item->len      = len;
+    item->havemore = havemore;
+    memcpy(item->text, text, len);
+    item->text[len] = 0;
+
+    if( text_queue_push(&self->textqueue, item) )
+        notify_consumer(self);
+}
+//------------------------------------------------------------------------------
+//---- Executor ----------------------------------------------------------------
+//------------------------------------------------------------------------------
+int textalk_executor_init(textalk_executor_t *self, const textalk_allocator_t *alloc)
+{
+    /**
+     * @memberof textalk_executor_t
+     * @brief Constructor.
+     *
+     * @param self  Object instance.
+     * @param alloc The allocator of texts received,
+     *              and can be NULL to use the default one.
+     *              It will be called from the I/O thread to allocate,
+     *              and from the consumer thread to release.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     */
+    self->running   = false;
+    self->stopping  = 0;
+    self->alloc     = alloc ? *alloc : *textalk_allocator_get_defaults();
+    self->subqueue  = NULL;
+    self->donequeue = NULL;
+    self->textqueue = NULL;
+    self->donelist  = NULL;
+    self->textlist  = NULL;
+    self->portcount = 0;
+
+    self->textdropped = 0;
+
+    self->notifyfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    int errcode = textalk_reactor_init(&self->reactor);
+
+    return ( self->notifyfd < 0 )?( TEXTALK_ERR_STREAM_FAIL ):( errcode );
+}
+//------------------------------------------------------------------------------
+void textalk_executor_deinit(textalk_executor_t *self)
+{
+    /**
+     * @memberof textalk_executor_t
+     * @brief Destructor.
+     *
+     * @remarks The executor will be stopped,
+     *          and events of the sessions will be restored.
+     *          Texts received and not taken will be released,
+     *          but the sessions and file descriptors will not be closed.
+     */
+    textalk_executor_stop(self);
+
+    for(unsigned i = 0; i < self->portcount; ++i)
+    {
+        textalk_executor_port_t *port = &self->ports[i];
+
+        textalk_reactor_remove(&self->reactor, port->line);
+        port->session->events = port->events;
+    }
+    self->portcount = 0;
+
+    textalk_reactor_deinit(&self->reactor);
+
+    textalk_exec_text_t *text;
+    while(( text = textalk_executor_take_text(self) ))
+        textalk_executor_free_text(self, text);
+
+    if( self->notifyfd >= 0 )
+    {
+        close(self->notifyfd);
+        self->notifyfd = -1;
+    }
+}
+//------------------------------------------------------------------------------
+int textalk_executor_add(textalk_executor_t *self, textalk_t *session, int fd, unsigned *port)
+{
+    /**
+     * @memberof textalk_executor_t
+     * @brief Give a session to the executor.
+     *
+     * @param self    Object instance.
+     * @param session The session to be driven by the executor.
+     *                Its event callbacks will still be called, but on the I/O thread.
+     * @param fd      The file descriptor used by the sender and receiver of the session.
+     * @param port    Returns the port number of the session.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     *
+     * @remarks Sessions can only be added before the executor started,
+     *          and functions of the session should not be used
+     *          until the executor be de-initialised.
+     */
+    if( !session || fd < 0 ) return TEXTALK_ERR_INVALID_ARG;
+    if( self->running ) return TEXTALK_ERR_BUSY;
+    if( self->portcount >= TEXTALK_EXECUTOR_PORT_MAX ) return TEXTALK_ERR_BUF_NOT_ENOUGH;
+
+    textalk_executor_port_t *item = &self->ports[self->portcount];
+    item->owner    = self;
+    item->index    = self->portcount;
+    item->session  = session;
+    item->fd       = fd;
+    item->events   = session->events;
+    item->pendhead = NULL;
+    item->pendtail = NULL;
+    item->current  = NULL;
+
+    // Route events of the session through the port.
+    textalk_events_t *events = &session->events;
+    memset(events, 0, sizeof(*events));
+    events->userarg      = item;
+    events->sender       = port_sender;
+    events->recver       = port_recver;
+    events->on_send_ctrl = port_on_send_ctrl;
+    events->on_recv_ctrl = port_on_recv_ctrl;
+    events->on_send_text = port_on_send_text;
+    events->on_recv_text = port_on_recv_text;
+
+    item->line = textalk_reactor_add(&self->reactor, session, fd, port_on_done);
+    if( !item->line )
+    {
+        session->events = item->events;
+        return TEXTALK_ERR_STREAM_FAIL;
+    }
+    textalk_reactor_set_on_text(&self->reactor, item->line, port_on_text);
+
+    if( port ) *port = self->portcount;
+    ++self->portcount;
+
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+int textalk_executor_start(textalk_executor_t *self)
+{
+    /**
+     * @memberof textalk_executor_t
+     * @brief Start the I/O thread.
+     *
+     * @param self Object instance.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     */
+    if( self->running ) return TEXTALK_ERR_BUSY;
+
+    __atomic_store_n(&self->stopping, 0, __ATOMIC_RELEASE);
+    if( pthread_create(&self->thread, NULL, (void*(*)(void*)) executor_thread, self) )
+        return TEXTALK_ERR_GENERAL;
+
+    self->running = true;
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+void textalk_executor_stop(textalk_executor_t *self)
+{
+    /**
+     * @memberof textalk_executor_t
+     * @brief Stop the I/O thread.
+     *
+     * @remarks Requests not finished will be completed with ::TEXTALK_ERR_TERMINATED,
+     *          and the text being sent will be abandoned.
+     */
+    if( !self->running ) return;
+
+    __atomic_store_n(&self->stopping, 1, __ATOMIC_RELEASE);
+    textalk_reactor_wakeup(&self->reactor);
+    pthread_join(self->thread, NULL);
+    self->running = false;
+
+    collect_requests(self);
+    for(unsigned i = 0; i < self->portcount; ++i)
+    {
+        textalk_executor_port_t *port = &self->ports[i];
+
+        if( port->current )
+        {
+            port_complete(port, port->current, TEXTALK_ERR_TERMINATED);
+            port->current = NULL;
+        }
+
+        while( port->pendhead )
+        {
+            textalk_exec_req_t *req = port->pendhead;
+            port->pendhead = req->next;
+            port_complete(port, req, TEXTALK_ERR_TERMINATED);
+        }
+        port->pendtail = NULL;
+    }
+}
+//------------------------------------------------------------------------------
+int textalk_executor_submit(textalk_executor_t *self, unsigned port, textalk_exec_req_t *req)
+{
+    /**
+     * @memberof textalk_executor_t
+     * @brief Submit a text to send.
+     *
+     * @param self Object instance.
+     * @param port The port to send to.
+     * @param req  The request, and the result will be reported
+     *             by textalk_executor_take_done.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     *
+     * @remarks This function is lock-free and can be called from any thread.
+     *          Texts submitted to the same port are sent in order of submission.
+     */
+    if( !req || !req->text || port >= self->portcount ) return TEXTALK_ERR_INVALID_ARG;
+
+    req->port    = port;
+    req->errcode = TEXTALK_ERR_BUSY;
+
+    // Only the first request of a batch needs to wake the I/O thread.
+    if( req_queue_push(&self->subqueue, req) )
+        textalk_reactor_wakeup(&self->reactor);
+
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+textalk_exec_req_t* textalk_executor_take_done(textalk_executor_t *self)
+{
+    /**
+     * @memberof textalk_executor_t
+     * @brief Take a completed request.
+     *
+     * @param self Object instance.
+     * @return The request completed, with its result in ::textalk_exec_req_t::errcode;
+     *         or NULL if there have no more.
+     */
+    if( !self->donelist )
+        self->donelist = req_queue_take_all(&self->donequeue);
+
+    textalk_exec_req_t *req = self->donelist;
+    if( req ) self->donelist = req->next;
+
+    return req;
+}
+//------------------------------------------------------------------------------
+textalk_exec_text_t* textalk_executor_take_text(textalk_executor_t *self)
+{
+    /**
+     * @memberof textalk_executor_t
+     * @brief Take a text received.
+     *
+     * @param self Object instance.
+     * @return The text received, and it should be released by textalk_executor_free_text;
+     *         or NULL if there have no more.
+     */
+    if( !self->textlist )
+        self->textlist = text_queue_take_all(&self->textqueue);
+
+    textalk_exec_text_t *text = self->textlist;
+    if( text ) self->textlist = text->next;
+
+    return text;
+}
+//------------------------------------------------------------------------------
+void textalk_executor_free_text(textalk_executor_t *self, textalk_exec_text_t *text)
+{
+    /**
+     * @memberof textalk_executor_t
+     * @brief Release a text taken by textalk_executor_take_text.
+     */
+    if( text && self->alloc.free )
+        self->alloc.free(self->alloc.userarg, text);
+}
+//------------------------------------------------------------------------------
+uint64_t textalk_executor_get_dropped(const textalk_executor_t *self)
+{
+    /**
+     * @memberof textalk_executor_t
+     * @brief Get count of texts received but dropped,
+     *        because the allocator failed to keep them.
+     *
+     * @remarks Texts are acknowledged to the remote before they be kept,
+     *          so a text dropped will not be sent again,
+     *          and can only be recovered by the application protocol.
+     */
+    return __atomic_load_n(&self->textdropped, __ATOMIC_RELAXED);
+}
+//------------------------------------------------------------------------------
+int textalk_executor_get_notify_fd(const textalk_executor_t *self)
+{
+    /**
+     * @memberof textalk_executor_t
+     * @brief Get the file descriptor that becomes readable
+     *        when requests completed or texts received,
+     *        to be waited with other events by the consumer.
+     */
+    return self->notifyfd;
+}
+//------------------------------------------------------------------------------
+int textalk_executor_wait(textalk_executor_t *self, unsigned timeout)
+{
+    /**
+     * @memberof textalk_executor_t
+     * @brief Wait for requests completed or texts received.
+     *
+     * @param self    Object instance.
+     * @param timeout The maximum time to wait in milliseconds.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     */
+    if( self->donelist || self->textlist ) return TEXTALK_ERR_SUCCESS;
+    if( __atomic_load_n(&self->donequeue, __ATOMIC_ACQUIRE) ) return TEXTALK_ERR_SUCCESS;
+    if( __atomic_load_n(&self->textqueue, __ATOMIC_ACQUIRE) ) return TEXTALK_ERR_SUCCESS;
+
+    struct pollfd pfd = { .fd = self->notifyfd, .events = POLLIN };
+    int res = poll(&pfd, 1, (int) timeout);
+    if( res < 0 ) return ( errno == EINTR )?( TEXTALK_ERR_SUCCESS ):( TEXTALK_ERR_STREAM_FAIL );
+    if( res == 0 ) return TEXTALK_ERR_TIMEOUT;
+
+    uint64_t count;
+    while( read(self->notifyfd, &count, sizeof(count)) > 0 ) {}
+
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
@@ -3,6 +3,23 @@
 #include "parity.h"
 #include "textalk_packet.h"
 
+//------------------------------------------------------------------------------
+void textalk_packet_get_wire_ctrl(textalk_conf_ctrl_t *wire, const textalk_conf_t *conf)
+{
+    /*
+     * Get control characters in the form on the line (with parity added),
+     * to be computed once and compared with raw characters received.
+     */
+    int parity = conf->comm.parity;
+
+    wire->stx = parity_ch_add(conf->ctrl.stx, parity);
+    wire->etx = parity_ch_add(conf->ctrl.etx, parity);
+    wire->etb = parity_ch_add(conf->ctrl.etb, parity);
+    wire->enq = parity_ch_add(conf->ctrl.enq, parity);
+    wire->ack = parity_ch_add(conf->ctrl.ack, parity);
+    wire->nak = parity_ch_add(conf->ctrl.nak, parity);
+    wire->eot = parity_ch_add(conf->ctrl.eot, parity);
+}
 //------------------------------------------------------------------------------
 bool textalk_packet_have_stx(const char *pkt, size_t size, const textalk_conf_t *conf)
 {
@@ -62,23 +79,116 @@ size_t textalk_packet_build(char                 *buf,
                             bool                  havemore)
 {
     assert( buf && text );
+    return textalk_packet_encode(buf, bufsz, text, strlen(text), conf, havemore);
+}
+//------------------------------------------------------------------------------
+size_t textalk_packet_encode(char                 *buf,
+                             size_t                bufsz,
+                             const char           *text,
+                             size_t                textlen,
+                             const textalk_conf_t *conf,
+                             bool                  havemore)
+{
+    assert( buf && ( text || !textlen ) );
+
+    int    parity = conf->comm.parity;
+    size_t pktsz  = (1/*STX*/) + textlen + (1/*ETX*/) + ( conf->comm.have_lrc ? 1 : 0 );
+    if( bufsz < pktsz ) return 0;
+
+    // Parity, copy, and LRC be done in one pass.
+    char end = parity_ch_add(havemore ? conf->ctrl.etb : conf->ctrl.etx, parity);
+    char lrc = parity_arr_copy_add(&buf[1], text, textlen, parity) ^ end;
+
+    buf[0]         = parity_ch_add(conf->ctrl.stx, parity);
+    buf[textlen+1] = end;
+    if( conf->comm.have_lrc )
+        pkt_set_lrc(buf, pktsz, lrc);
 
-    char   *pkt     = buf;
-    size_t  textlen = strlen(text);
-    size_t  pktsz   = (1/*STX*/) + textlen + (1/*ETX*/) + ( conf->comm.have_lrc ? 1 : 0 );
+    return pktsz;
+}
+//------------------------------------------------------------------------------
+size_t textalk_packet_encode_seq(char                 *buf,
+                                 size_t                bufsz,
+                                 char                  seq,
+                                 const char           *text,
+                                 size_t                textlen,
+                                 const textalk_conf_t *conf,
+                                 bool                  havemore)
+{
+    /*
+     * Encode a packet with a sequence character put before the text,
+     * which is used by the window mode.
+     */
+    assert( buf && ( text || !textlen ) );
+
+    int    parity = conf->comm.parity;
+    size_t pktsz  = (1/*STX*/) + (1/*SEQ*/) + textlen + (1/*ETX*/) + ( conf->comm.have_lrc ? 1 : 0 );
     if( bufsz < pktsz ) return 0;
 
-    pkt[0] = conf->ctrl.stx;
-    memcpy(&pkt[1], text, textlen);
-    pkt[textlen+1] = havemore ? conf->ctrl.etb : conf->ctrl.etx;
+    char head = parity_ch_add(seq, parity);
+    char end  = parity_ch_add(havemore ? conf->ctrl.etb : conf->ctrl.etx, parity);
+    char lrc  = parity_arr_copy_add(&buf[2], text, textlen, parity) ^ head ^ end;
 
-    parity_arr_add(pkt, pktsz, conf->comm.parity);
+    buf[0]         = parity_ch_add(conf->ctrl.stx, parity);
+    buf[1]         = head;
+    buf[textlen+2] = end;
     if( conf->comm.have_lrc )
-        pkt_set_lrc(pkt, pktsz, pkt_calc_lrc(pkt, pktsz));
+        pkt_set_lrc(buf, pktsz, lrc);
 
     return pktsz;
 }
 //------------------------------------------------------------------------------
+size_t textalk_packet_encode_head(char *buf, size_t bufsz, const textalk_conf_t *conf)
+{
+    /*
+     * Write the part before the text (STX),
+     * and returns size written or ZERO if the buffer is not long enough.
+     */
+    if( bufsz < 1 ) return 0;
+
+    buf[0] = parity_ch_add(conf->ctrl.stx, conf->comm.parity);
+    return 1;
+}
+//------------------------------------------------------------------------------
+size_t textalk_packet_encode_tail(char                 *buf,
+                                  size_t                bufsz,
+                                  const char           *text,
+                                  size_t                textlen,
+                                  const textalk_conf_t *conf,
+                                  bool                  havemore)
+{
+    /*
+     * Write the part after the text (ETX or ETB, and LRC),
+     * and returns size written or ZERO if the buffer is not long enough.
+     */
+    assert( text || !textlen );
+
+    int    parity = conf->comm.parity;
+    size_t tailsz = (1/*ETX*/) + ( conf->comm.have_lrc ? 1 : 0 );
+    if( bufsz < tailsz ) return 0;
+
+    buf[0] = parity_ch_add(havemore ? conf->ctrl.etb : conf->ctrl.etx, parity);
+
+    if( conf->comm.have_lrc )
+    {
+        char lrc = buf[0];
+        if( !parity )
+        {
+            for(; textlen; --textlen)
+                lrc ^= *text++;
+        }
+        else
+        {
+            for(; textlen; --textlen)
+                lrc ^= parity_ch_add(*text++, parity);
+        }
+
+        buf[1] = lrc;
+    }
+
+    return tailsz;
+}
+//------------------------------------------------------------------------------
 bool textalk_packet_get_text(char                 *buf,
                              size_t                bufsz,
                              const char           *pkt,
@@ -99,6 +209,95 @@ bool textalk_packet_get_text(char                 *buf,
     return true;
 }
 //------------------------------------------------------------------------------
+int textalk_packet_decode(char                 *buf,
+                          size_t                bufsz,
+                          const char           *pkt,
+                          size_t                pktsz,
+                          const textalk_conf_t *conf,
+                          size_t               *textlen,
+                          bool                 *havemore)
+{
+    /*
+     * Check integrity, parity, and LRC of a packet, and extract its text
+     * (with a null-terminator appended) in one pass.
+     * Returns one of textalk_packet_status_t.
+     *
+     * The parity be checked on STX, the text, and ETX/ETB;
+     * LRC is a plain XOR of them and does not have a parity bit of its own.
+     */
+    if( !textalk_packet_check_integrity(pkt, pktsz, conf) )
+        return TEXTALK_PACKET_BAD_INTEGRITY;
+
+    int    parity = conf->comm.parity;
+    size_t len    = pktsz - ( conf->comm.have_lrc ? 3 : 2 );
+    char   end    = pkt[len+1];
+
+    if( bufsz < len + 1 )
+    {
+        // Still report a bad packet in priority to the buffer size.
+        if( !parity_arr_check(pkt, len + 2, parity) )
+            return TEXTALK_PACKET_BAD_PARITY;
+        if( !textalk_packet_check_lrc(pkt, pktsz, conf) )
+            return TEXTALK_PACKET_BAD_LRC;
+
+        return TEXTALK_PACKET_BUF_NOT_ENOUGH;
+    }
+
+    bool parity_ok;
+    char lrc = parity_arr_copy_remove(buf, pkt + 1, len, parity, &parity_ok) ^ end;
+    buf[len] = 0;
+
+    if( !parity_ok || !parity_arr_check(pkt, 1, parity) || !parity_arr_check(&end, 1, parity) )
+        return TEXTALK_PACKET_BAD_PARITY;
+    if( conf->comm.have_lrc && lrc != pkt_get_lrc(pkt, pktsz) )
+        return TEXTALK_PACKET_BAD_LRC;
+
+    if( textlen  ) *textlen  = len;
+    if( havemore ) *havemore = ( parity_ch_remove(end) == conf->ctrl.etb );
+
+    return TEXTALK_PACKET_OK;
+}
+//------------------------------------------------------------------------------
+int textalk_packet_decode_inplace(char                 *pkt,
+                                  size_t                pktsz,
+                                  const textalk_conf_t *conf,
+                                  char                **text,
+                                  size_t               *textlen,
+                                  bool                 *havemore)
+{
+    /*
+     * Check a packet and extract its text inside the packet buffer,
+     * the text will start at the second character
+     * and be null-terminated at the place of ETX/ETB.
+     * Returns one of textalk_packet_status_t.
+     *
+     * This is the same single pass as textalk_packet_decode with the text written over itself,
+     * so parity bits of the text will have been removed even if the packet is bad.
+     */
+    if( !textalk_packet_check_integrity(pkt, pktsz, conf) )
+        return TEXTALK_PACKET_BAD_INTEGRITY;
+
+    int    parity = conf->comm.parity;
+    size_t len    = pktsz - ( conf->comm.have_lrc ? 3 : 2 );
+    char   end    = pkt[len+1];
+
+    bool parity_ok;
+    char lrc = parity_arr_copy_remove(pkt + 1, pkt + 1, len, parity, &parity_ok) ^ end;
+
+    if( !parity_ok || !parity_arr_check(pkt, 1, parity) || !parity_arr_check(&end, 1, parity) )
+        return TEXTALK_PACKET_BAD_PARITY;
+    if( conf->comm.have_lrc && lrc != pkt_get_lrc(pkt, pktsz) )
+        return TEXTALK_PACKET_BAD_LRC;
+
+    pkt[len+1] = 0;
+
+    if( text     ) *text     = pkt + 1;
+    if( textlen  ) *textlen  = len;
+    if( havemore ) *havemore = ( parity_ch_remove(end) == conf->ctrl.etb );
+
+    return TEXTALK_PACKET_OK;
+}
+//------------------------------------------------------------------------------
 bool textalk_packet_check_integrity(const char *pkt, size_t size, const textalk_conf_t *conf)
 {
     return textalk_packet_have_stx(pkt, size, conf) &&
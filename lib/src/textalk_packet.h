@@ -7,11 +7,26 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include "textalk_conf.h"
+#include "textalk_codec.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/*
+ * Results of packet decoding.
+ */
+enum textalk_packet_status_t
+{
+    TEXTALK_PACKET_OK             = TEXTALK_CODEC_OK,
+    TEXTALK_PACKET_BAD_INTEGRITY  = TEXTALK_CODEC_BAD_INTEGRITY,    // STX, ETX, or ETB not found at their place.
+    TEXTALK_PACKET_BAD_PARITY     = TEXTALK_CODEC_BAD_PARITY,       // Parity check failed.
+    TEXTALK_PACKET_BAD_LRC        = TEXTALK_CODEC_BAD_LRC,          // LRC check failed.
+    TEXTALK_PACKET_BUF_NOT_ENOUGH = TEXTALK_CODEC_BUF_NOT_ENOUGH,   // The output buffer is not long enough.
+};
+
+void textalk_packet_get_wire_ctrl(textalk_conf_ctrl_t *wire, const textalk_conf_t *conf);
+
 bool textalk_packet_have_stx(const char *pkt, size_t size, const textalk_conf_t *conf);
 bool textalk_packet_have_etx(const char *pkt, size_t size, const textalk_conf_t *conf);
 bool textalk_packet_have_etb(const char *pkt, size_t size, const textalk_conf_t *conf);
@@ -21,12 +36,46 @@ size_t textalk_packet_build(char                 *buf,
                             const char           *text,
                             const textalk_conf_t *conf,
                             bool                  havemore);
+size_t textalk_packet_encode(char                 *buf,
+                             size_t                bufsz,
+                             const char           *text,
+                             size_t                textlen,
+                             const textalk_conf_t *conf,
+                             bool                  havemore);
+size_t textalk_packet_encode_seq(char                 *buf,
+                                 size_t                bufsz,
+                                 char                  seq,
+                                 const char           *text,
+                                 size_t                textlen,
+                                 const textalk_conf_t *conf,
+                                 bool                  havemore);
+size_t textalk_packet_encode_head(char *buf, size_t bufsz, const textalk_conf_t *conf);
+size_t textalk_packet_encode_tail(char                 *buf,
+                                  size_t                bufsz,
+                                  const char           *text,
+                                  size_t                textlen,
+                                  const textalk_conf_t *conf,
+                                  bool                  havemore);
 bool textalk_packet_get_text(char                 *buf,
                              size_t                bufsz,
                              const char           *pkt,
                              size_t                pktsz,
                              const textalk_conf_t *conf);
 
+int textalk_packet_decode(char                 *buf,
+                          size_t                bufsz,
+                          const char           *pkt,
+                          size_t                pktsz,
+                          const textalk_conf_t *conf,
+                          size_t               *textlen,
+                          bool                 *havemore);
+int textalk_packet_decode_inplace(char                 *pkt,
+                                  size_t                pktsz,
+                                  const textalk_conf_t *conf,
+                                  char                **text,
+                                  size_t               *textlen,
+                                  bool                 *havemore);
+
 bool textalk_packet_check_integrity(const char *pkt, size_t size, const textalk_conf_t *conf);
 bool textalk_packet_check_parity(const char *pkt, size_t size, const textalk_conf_t *conf);
 bool textalk_packet_check_lrc(const char *pkt, size_t size, const textalk_conf_t *conf);
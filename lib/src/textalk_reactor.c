@@ -0,0 +1,663 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <gen/systime.h>
+#include "textalk_engine.h"
+#include "textalk_reactor.h"
+
+#define EVENT_BATCH_SIZE 64
+#define RECV_BUF_SIZE    512
+#define TIMER_NONE       ((size_t)-1)   // The line is not in the timer heap.
+
+struct textalk_reactor_line_t
+{
+    textalk_reactor_line_t *prev;
+    textalk_reactor_line_t *next;
+
+    textalk_t                 *session;
+    int                        fd;
+    textalk_reactor_on_done_t  on_done;
+    textalk_reactor_on_text_t  on_text;
+
+    bool broken;
+    bool removed;   // Removed by the user, and will be freed when the reactor be idle.
+    bool want_send;
+
+    size_t   timerpos;  // Position in the timer heap, or TIMER_NONE.
+    unsigned deadline;  // The deadline of the engine when it is in the timer heap.
+
+    textalk_engine_t engine;
+};
+
+//------------------------------------------------------------------------------
+static
+bool time_is_reached(unsigned now, unsigned deadline)
+{
+    return (int)( now - deadline ) >= 0;
+}
+//------------------------------------------------------------------------------
+//---- Timer heap --------------------------------------------------------------
+//------------------------------------------------------------------------------
+/*
+ * Lines with a deadline are kept in a binary min-heap,
+ * so the nearest deadline and the lines due are found without visiting all lines.
+ */
+//------------------------------------------------------------------------------
+static
+bool timer_is_before(const textalk_reactor_line_t *a, const textalk_reactor_line_t *b)
+{
+    return (int)( a->deadline - b->deadline ) < 0;
+}
+//------------------------------------------------------------------------------
+static
+void timer_place(textalk_reactor_t *self, textalk_reactor_line_t *line, size_t pos)
+{
+    self->timers[pos] = line;
+    line->timerpos    = pos;
+}
+//------------------------------------------------------------------------------
+static
+void timer_sift_up(textalk_reactor_t *self, size_t pos)
+{
+    textalk_reactor_line_t *line = self->timers[pos];
+    while( pos )
+    {
+        size_t parent = ( pos - 1 ) / 2;
+        if( !timer_is_before(line, self->timers[parent]) ) break;
+
+        timer_place(self, self->timers[parent], pos);
+        pos = parent;
+    }
+
+    timer_place(self, line, pos);
+}
+//------------------------------------------------------------------------------
+static
+void timer_sift_down(textalk_reactor_t *self, size_t pos)
+{
+    textalk_reactor_line_t *line = self->timers[pos];
+    while( true )
+    {
+        size_t child = 2 * pos + 1;
+        if( child >= self->timercount ) break;
+        if( child + 1 < self->timercount && timer_is_before(self->timers[child+1], self->timers[child]) )
+            ++child;
+        if( !timer_is_before(self->timers[child], line) ) break;
+
+        timer_place(self, self->timers[child], pos);
+        pos = child;
+    }
+
+    timer_place(self, line, pos);
+}
+//------------------------------------------------------------------------------
+static
+void timer_remove(textalk_reactor_t *self, textalk_reactor_line_t *line)
+{
+    size_t pos = line->timerpos;
+    if( pos == TIMER_NONE ) return;
+
+    line->timerpos = TIMER_NONE;
+
+    textalk_reactor_line_t *last = self->timers[--self->timercount];
+    if( last == line ) return;
+
+    timer_place(self, last, pos);
+    timer_sift_up(self, pos);
+    timer_sift_down(self, last->timerpos);
+}
+//------------------------------------------------------------------------------
+static
+void timer_set(textalk_reactor_t *self, textalk_reactor_line_t *line, unsigned deadline)
+{
+    // The heap have a place for each line, reserved when the line be added.
+    if( line->timerpos == TIMER_NONE )
+    {
+        line->deadline = deadline;
+        timer_place(self, line, self->timercount++);
+        timer_sift_up(self, line->timerpos);
+    }
+    else if( line->deadline != deadline )
+    {
+        line->deadline = deadline;
+        timer_sift_up(self, line->timerpos);
+        timer_sift_down(self, line->timerpos);
+    }
+}
+//------------------------------------------------------------------------------
+//---- Lines -------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static
+void reactor_enter(textalk_reactor_t *self)
+{
+    // User callbacks may be called from here, and lines removed by them will be kept until leaving.
+    ++self->busy;
+}
+//------------------------------------------------------------------------------
+static
+void reactor_leave(textalk_reactor_t *self)
+{
+    if( --self->busy ) return;
+
+    while( self->removed )
+    {
+        textalk_reactor_line_t *line = self->removed;
+        self->removed = line->next;
+
+        textalk_engine_deinit(&line->engine);
+        free(line);
+    }
+}
+//------------------------------------------------------------------------------
+static
+void line_watch(textalk_reactor_t *self, textalk_reactor_line_t *line, bool want_send)
+{
+    if( line->broken || line->removed || line->want_send == want_send ) return;
+
+    struct epoll_event event =
+    {
+        .events   = EPOLLIN | EPOLLRDHUP | ( want_send ? EPOLLOUT : 0 ),
+        .data.ptr = line,
+    };
+
+    epoll_ctl(self->epfd, EPOLL_CTL_MOD, line->fd, &event);
+    line->want_send = want_send;
+}
+//------------------------------------------------------------------------------
+static
+void line_set_broken(textalk_reactor_t *self, textalk_reactor_line_t *line)
+{
+    if( line->broken || line->removed ) return;
+
+    epoll_ctl(self->epfd, EPOLL_CTL_DEL, line->fd, NULL);
+    line->broken = true;
+    timer_remove(self, line);
+
+    textalk_engine_reset(&line->engine, line->engine.now);
+    line->on_done(line->session->events.userarg, line->session, TEXTALK_ERR_STREAM_FAIL);
+}
+//------------------------------------------------------------------------------
+static
+void line_dispatch_events(textalk_reactor_line_t *line)
+{
+    textalk_t        *session = line->session;
+    textalk_events_t *events  = &session->events;
+
+    textalk_engine_event_t event;
+    while( !line->removed && textalk_engine_next_event(&line->engine, &event) )
+    {
+        switch( event.type )
+        {
+        case TEXTALK_ENGINE_EV_TEXT:
+            events->on_recv_text(events->userarg, event.text);
+            if( line->on_text && !line->removed )
+                line->on_text(events->userarg, session, event.text, event.textlen, event.havemore);
+            break;
+
+        case TEXTALK_ENGINE_EV_SENT:
+            events->on_send_text(events->userarg, event.text);
+            line->on_done(events->userarg, session, TEXTALK_ERR_SUCCESS);
+            break;
+
+        case TEXTALK_ENGINE_EV_FAILED:
+            line->on_done(events->userarg, session, event.errcode);
+            break;
+
+        case TEXTALK_ENGINE_EV_CTRL_SENT:
+            events->on_send_ctrl(events->userarg, event.ctrl);
+            break;
+
+        case TEXTALK_ENGINE_EV_CTRL:
+        case TEXTALK_ENGINE_EV_CTRL_TAKEN:
+            events->on_recv_ctrl(events->userarg, event.ctrl);
+            break;
+        }
+    }
+}
+//------------------------------------------------------------------------------
+static
+void line_flush(textalk_reactor_t *self, textalk_reactor_line_t *line)
+{
+    textalk_events_t *events = &line->session->events;
+
+    const void *data;
+    size_t      size = 0;
+    while( !line->broken && !line->removed && ( size = textalk_engine_peek_output(&line->engine, &data) ) )
+    {
+        int sendsz = events->sender(events->userarg, data, size);
+        if( sendsz < 0 || size < sendsz )
+        {
+            line_set_broken(self, line);
+            return;
+        }
+
+        if( !sendsz ) break;
+        textalk_engine_drop_output(&line->engine, sendsz);
+    }
+
+    line_watch(self, line, size);
+}
+//------------------------------------------------------------------------------
+static
+void line_feed(textalk_reactor_line_t *line, const char *data, size_t size)
+{
+    while( size && !line->removed )
+    {
+        size_t feedsz = textalk_engine_feed(&line->engine, data, size);
+        data += feedsz;
+        size -= feedsz;
+
+        line_dispatch_events(line);
+    }
+}
+//------------------------------------------------------------------------------
+static
+void line_receive(textalk_reactor_t *self, textalk_reactor_line_t *line)
+{
+    /*
+     * The line is ready to read, or hung up,
+     * so nothing read means the remote be closed
+     * (and it would be reported ready again and again).
+     */
+    textalk_events_t *events = &line->session->events;
+
+    char buf[RECV_BUF_SIZE];
+    int  recvsz = events->recver(events->userarg, buf, sizeof(buf));
+    if( recvsz <= 0 || sizeof(buf) < recvsz )
+        line_set_broken(self, line);
+    else
+        line_feed(line, buf, recvsz);
+}
+//------------------------------------------------------------------------------
+static
+void line_update_timer(textalk_reactor_t *self, textalk_reactor_line_t *line)
+{
+    if( line->broken || line->removed ) return;
+
+    unsigned deadline;
+    if( textalk_engine_get_deadline(&line->engine, &deadline) )
+        timer_set(self, line, deadline);
+    else
+        timer_remove(self, line);
+}
+//------------------------------------------------------------------------------
+static
+void line_on_time(textalk_reactor_t *self, textalk_reactor_line_t *line, unsigned now)
+{
+    textalk_engine_on_time(&line->engine, now);
+    line_dispatch_events(line);
+}
+//------------------------------------------------------------------------------
+static
+void process_timers(textalk_reactor_t *self, unsigned now)
+{
+    // Lines be due again by processing will be processed next time.
+    for(size_t count = self->timercount;
+        count && self->timercount && time_is_reached(now, self->timers[0]->deadline);
+        --count)
+    {
+        textalk_reactor_line_t *line = self->timers[0];
+        timer_remove(self, line);
+
+        line_on_time(self, line, now);
+        line_flush(self, line);
+        line_update_timer(self, line);
+    }
+}
+//------------------------------------------------------------------------------
+int textalk_reactor_init(textalk_reactor_t *self)
+{
+    /**
+     * @memberof textalk_reactor_t
+     * @brief Constructor.
+     *
+     * @param self Object instance.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     */
+    self->lines      = NULL;
+    self->linecount  = 0;
+    self->removed    = NULL;
+    self->busy       = 0;
+    self->timers     = NULL;
+    self->timercount = 0;
+    self->timercap   = 0;
+
+    self->epfd   = epoll_create1(EPOLL_CLOEXEC);
+    self->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if( self->epfd < 0 || self->wakefd < 0 ) return TEXTALK_ERR_STREAM_FAIL;
+
+    // The wake-up event is the only one registered without a line.
+    struct epoll_event event =
+    {
+        .events   = EPOLLIN,
+        .data.ptr = NULL,
+    };
+    if( epoll_ctl(self->epfd, EPOLL_CTL_ADD, self->wakefd, &event) )
+        return TEXTALK_ERR_STREAM_FAIL;
+
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+void textalk_reactor_deinit(textalk_reactor_t *self)
+{
+    /**
+     * @memberof textalk_reactor_t
+     * @brief Destructor.
+     *
+     * @remarks All lines will be removed,
+     *          but the sessions and file descriptors will not be closed.
+     */
+    while( self->lines )
+        textalk_reactor_remove(self, self->lines);
+
+    free(self->timers);
+    self->timers     = NULL;
+    self->timercount = 0;
+    self->timercap   = 0;
+
+    if( self->epfd >= 0 )
+    {
+        close(self->epfd);
+        self->epfd = -1;
+    }
+
+    if( self->wakefd >= 0 )
+    {
+        close(self->wakefd);
+        self->wakefd = -1;
+    }
+}
+//------------------------------------------------------------------------------
+textalk_reactor_line_t* textalk_reactor_add(textalk_reactor_t         *self,
+                                            textalk_t                 *session,
+                                            int                        fd,
+                                            textalk_reactor_on_done_t  on_done)
+{
+    /**
+     * @memberof textalk_reactor_t
+     * @brief Register a session.
+     *
+     * @param self    Object instance.
+     * @param session The session to be driven by the reactor.
+     *                Its sender and receiver will be called in non-blocking mode
+     *                when the file descriptor is ready,
+     *                and texts received and control codes exchanged will be reported
+     *                through its event callbacks.
+     * @param fd      The file descriptor used by the sender and receiver of the session.
+     * @param on_done The callback to report results of texts sent.
+     * @return The line registered; or NULL if failed.
+     *
+     * @remarks The blocking functions of the session should not be used
+     *          until the line be removed.
+     * @remarks The window mode and line bids of the session configuration
+     *          are run by the engine of the line as the blocking functions do.
+     */
+    if( !session || fd < 0 || !on_done ) return NULL;
+
+    // Reserve a place in the timer heap for each line.
+    if( self->linecount == self->timercap )
+    {
+        size_t                   newcap    = self->timercap ? 2 * self->timercap : 16;
+        textalk_reactor_line_t **newtimers = realloc(self->timers, newcap * sizeof(*newtimers));
+        if( !newtimers ) return NULL;
+
+        self->timers   = newtimers;
+        self->timercap = newcap;
+    }
+
+    textalk_reactor_line_t *line = malloc(sizeof(*line));
+    if( !line ) return NULL;
+
+    line->session   = session;
+    line->fd        = fd;
+    line->on_done   = on_done;
+    line->on_text   = NULL;
+    line->broken    = false;
+    line->removed   = false;
+    line->want_send = false;
+    line->timerpos  = TIMER_NONE;
+    line->deadline  = 0;
+    if( textalk_engine_init_ex(&line->engine,
+                               &session->conf,
+                               systime_get_clock_count(),
+                               &session->alloc) )
+    {
+        textalk_engine_deinit(&line->engine);
+        free(line);
+        return NULL;
+    }
+    textalk_engine_set_stats(&line->engine, &session->stats);
+    textalk_engine_set_trace(&line->engine, session->trace);
+
+    struct epoll_event event =
+    {
+        .events   = EPOLLIN | EPOLLRDHUP,
+        .data.ptr = line,
+    };
+    if( epoll_ctl(self->epfd, EPOLL_CTL_ADD, fd, &event) )
+    {
+        textalk_engine_deinit(&line->engine);
+        free(line);
+        return NULL;
+    }
+
+    line->prev = NULL;
+    line->next = self->lines;
+    if( self->lines ) self->lines->prev = line;
+    self->lines = line;
+    ++self->linecount;
+
+    reactor_enter(self);
+
+    // Hand over data that have been buffered by the session.
+    while( session->rxsize && !line->removed )
+    {
+        size_t tailsz = session->rxbufsz - session->rxhead;
+        size_t size   = ( session->rxsize < tailsz )?( session->rxsize ):( tailsz );
+
+        line_feed(line, session->rxbuf + session->rxhead, size);
+
+        session->rxhead  = ( session->rxhead + size ) % session->rxbufsz;
+        session->rxsize -= size;
+    }
+    session->rxhead = 0;
+
+    line_flush(self, line);
+    line_update_timer(self, line);
+
+    bool removed = line->removed;
+    reactor_leave(self);
+
+    return removed ? NULL : line;
+}
+//------------------------------------------------------------------------------
+void textalk_reactor_remove(textalk_reactor_t *self, textalk_reactor_line_t *line)
+{
+    /**
+     * @memberof textalk_reactor_t
+     * @brief Unregister a line.
+     *
+     * @param self Object instance.
+     * @param line The line to be removed.
+     *
+     * @remarks The text being sent on the line will be abandoned without notification.
+     * @remarks This function can be called from callbacks of the session or the reactor,
+     *          including for the line being processed;
+     *          and the line will be freed after the reactor returned to the caller.
+     */
+    if( !line || line->removed ) return;
+
+    if( !line->broken )
+        epoll_ctl(self->epfd, EPOLL_CTL_DEL, line->fd, NULL);
+
+    if( line->prev ) line->prev->next = line->next;
+    if( line->next ) line->next->prev = line->prev;
+    if( self->lines == line ) self->lines = line->next;
+    --self->linecount;
+
+    timer_remove(self, line);
+    line->removed = true;
+
+    if( self->busy )
+    {
+        line->next    = self->removed;
+        self->removed = line;
+    }
+    else
+    {
+        textalk_engine_deinit(&line->engine);
+        free(line);
+    }
+}
+//------------------------------------------------------------------------------
+int textalk_reactor_set_codec(textalk_reactor_t      *self,
+                              textalk_reactor_line_t *line,
+                              const textalk_codec_t  *codec)
+{
+    /**
+     * @memberof textalk_reactor_t
+     * @brief Set the codec of a line, see textalk_engine_set_codec.
+     *
+     * @param self  Object instance.
+     * @param line  The line.
+     * @param codec The codec, and can be NULL to use the default codec.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     */
+    if( !line ) return TEXTALK_ERR_INVALID_ARG;
+
+    reactor_enter(self);
+    int errcode = textalk_engine_set_codec(&line->engine, codec);
+    reactor_leave(self);
+
+    return errcode;
+}
+//------------------------------------------------------------------------------
+void textalk_reactor_set_on_text(textalk_reactor_t         *self,
+                                 textalk_reactor_line_t    *line,
+                                 textalk_reactor_on_text_t  on_text)
+{
+    /**
+     * @memberof textalk_reactor_t
+     * @brief Set the callback of texts received with their length and continuation.
+     *
+     * @param self    Object instance.
+     * @param line    The line.
+     * @param on_text The callback, and can be NULL to remove it.
+     */
+    if( line ) line->on_text = on_text;
+}
+//------------------------------------------------------------------------------
+int textalk_reactor_send_text(textalk_reactor_t      *self,
+                              textalk_reactor_line_t *line,
+                              const char             *text,
+                              bool                    havemore)
+{
+    /**
+     * @memberof textalk_reactor_t
+     * @brief Start to send a text.
+     *
+     * @param self     Object instance.
+     * @param line     The line to send the text.
+     * @param text     The text to be sent.
+     * @param havemore Set TRUE to notify the remote that
+     *                 there have more text to send;
+     *                 and set FALSE to notify that
+     *                 this is the last text for this exchange round.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     *
+     * @remarks The result will be reported by the ::textalk_reactor_on_done_t callback,
+     *          and only one text can be sent on a line at the same time.
+     */
+    if( !line || !text ) return TEXTALK_ERR_INVALID_ARG;
+    if( line->broken || line->removed ) return TEXTALK_ERR_STREAM_FAIL;
+
+    reactor_enter(self);
+
+    textalk_engine_on_time(&line->engine, systime_get_clock_count());
+    line_dispatch_events(line);
+
+    int errcode = line->removed ?
+                  TEXTALK_ERR_STREAM_FAIL :
+                  textalk_engine_send(&line->engine, text, strlen(text), havemore);
+    if( !errcode )
+    {
+        line_flush(self, line);
+        line_update_timer(self, line);
+    }
+
+    reactor_leave(self);
+
+    return errcode;
+}
+//------------------------------------------------------------------------------
+int textalk_reactor_run_once(textalk_reactor_t *self, unsigned timeout)
+{
+    /**
+     * @memberof textalk_reactor_t
+     * @brief Wait for and process I/O events and time-outs once.
+     *
+     * @param self    Object instance.
+     * @param timeout The maximum time to wait in milliseconds.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     */
+    unsigned now = systime_get_clock_count();
+    if( self->timercount )
+    {
+        unsigned due    = self->timers[0]->deadline;
+        unsigned remain = time_is_reached(now, due) ? 0 : due - now;
+        if( remain < timeout ) timeout = remain;
+    }
+
+    struct epoll_event events[EVENT_BATCH_SIZE];
+    int count = epoll_wait(self->epfd, events, EVENT_BATCH_SIZE, (int) timeout);
+    if( count < 0 )
+        return ( errno == EINTR )?( TEXTALK_ERR_SUCCESS ):( TEXTALK_ERR_STREAM_FAIL );
+
+    reactor_enter(self);
+
+    now = systime_get_clock_count();
+    for(int i = 0; i < count; ++i)
+    {
+        textalk_reactor_line_t *line = events[i].data.ptr;
+        if( !line )
+        {
+            uint64_t wakes;
+            while( read(self->wakefd, &wakes, sizeof(wakes)) > 0 ) {}
+            continue;
+        }
+
+        // The line may be removed or broken by callbacks of lines processed before.
+        if( line->removed || line->broken ) continue;
+
+        line_on_time(self, line, now);
+        if( !line->removed && ( events[i].events & ( EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR ) ) )
+            line_receive(self, line);
+        line_flush(self, line);
+        line_update_timer(self, line);
+    }
+
+    process_timers(self, now);
+
+    reactor_leave(self);
+
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+void textalk_reactor_wakeup(textalk_reactor_t *self)
+{
+    /**
+     * @memberof textalk_reactor_t
+     * @brief Wake up the thread waiting in textalk_reactor_run_once.
+     *
+     * @param self Object instance.
+     *
+     * @remarks This function can be called from any thread.
+     */
+    uint64_t count = 1;
+    ssize_t  res   = write(self->wakefd, &count, sizeof(count));
+    (void) res;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,122 @@
+#include "textalk_rtt.h"
+
+#ifdef _WIN32
+#define CLOCK_TICK  16  // Granularity of the system tick count in milliseconds.
+#else
+#define CLOCK_TICK  1
+#endif
+#define FLOOR_TICKS 4   // Clock ticks always be allowed for an echo.
+
+//------------------------------------------------------------------------------
+static
+unsigned derive_floor(const textalk_conf_comm_t *conf)
+{
+    /*
+     * An echo can not come back before the largest packet goes through the line
+     * and the echo (up to three characters) comes back,
+     * and the clock may be late for a few ticks in measuring.
+     */
+    size_t   chars = ( conf->frame_max ? conf->frame_max : TEXTALK_PKT_MAX_SIZE ) + 3;
+    uint64_t line  = (uint64_t) chars * conf->timeout.char_time;
+
+    return FLOOR_TICKS * CLOCK_TICK + ( line + 999 ) / 1000;
+}
+//------------------------------------------------------------------------------
+void textalk_rtt_init(textalk_rtt_t *self, const textalk_conf_comm_t *conf)
+{
+    /**
+     * @memberof textalk_rtt_t
+     * @brief Constructor.
+     *
+     * @param self Object instance.
+     * @param conf Communication configuration.
+     *             The echo time-out will be fixed to textalk_conf_timeout_t::echo
+     *             if textalk_conf_timeout_t::adaptive is not set.
+     *
+     * @remarks If textalk_conf_timeout_t::echo_min is ZERO,
+     *          the lower limit will be the time for the largest packet
+     *          to be transmitted at textalk_conf_timeout_t::char_time,
+     *          plus a few ticks of the clock.
+     */
+    const textalk_conf_timeout_t *timeout = &conf->timeout;
+
+    unsigned floor = timeout->echo_min ? timeout->echo_min : derive_floor(conf);
+
+    self->adaptive = timeout->adaptive;
+    self->max      = timeout->echo;
+    self->min      = ( floor < timeout->echo )?( floor ):( timeout->echo );
+
+    textalk_rtt_reset(self);
+}
+//------------------------------------------------------------------------------
+void textalk_rtt_reset(textalk_rtt_t *self)
+{
+    /**
+     * @memberof textalk_rtt_t
+     * @brief Forget all measurements,
+     *        and the echo time-out will start from the maximum again.
+     */
+    self->measured = false;
+    self->srtt     = 0;
+    self->rttvar   = 0;
+    self->rto      = self->max;
+}
+//------------------------------------------------------------------------------
+void textalk_rtt_update(textalk_rtt_t *self, unsigned rtt)
+{
+    /**
+     * @memberof textalk_rtt_t
+     * @brief Put a round-trip time measured.
+     *
+     * @param self Object instance.
+     * @param rtt  Time from a packet be sent to its echo be received in milliseconds.
+     *
+     * @remarks Only echoes of packets sent once should be measured,
+     *          because an echo of a packet sent again
+     *          may be the answer of an earlier try (Karn's algorithm).
+     */
+    if( !self->adaptive ) return;
+
+    if( !self->measured )
+    {
+        self->srtt     = rtt << 3;
+        self->rttvar   = rtt << 1;
+        self->measured = true;
+    }
+    else
+    {
+        // srtt += ( rtt - srtt ) / 8, and rttvar += ( |rtt - srtt| - rttvar ) / 4.
+        int delta = (int) rtt - (int)( self->srtt >> 3 );
+        self->srtt += delta;
+
+        if( delta < 0 ) delta = -delta;
+        self->rttvar -= self->rttvar >> 2;
+        self->rttvar += delta;
+    }
+
+    // One more millisecond for the clock granularity.
+    unsigned rto = ( self->srtt >> 3 ) + self->rttvar + 1;
+
+    if( rto < self->min ) rto = self->min;
+    if( rto > self->max ) rto = self->max;
+    self->rto = rto;
+}
+//------------------------------------------------------------------------------
+unsigned textalk_rtt_get_timeout(const textalk_rtt_t *self, unsigned tries)
+{
+    /**
+     * @memberof textalk_rtt_t
+     * @brief Get the echo time-out.
+     *
+     * @param self  Object instance.
+     * @param tries Count of the packet have been sent before this try,
+     *              the time-out will be doubled for each of them.
+     * @return The echo time-out in milliseconds.
+     */
+    unsigned timeout = self->rto;
+    while( tries-- && timeout < self->max )
+        timeout <<= 1;
+
+    return ( timeout < self->max )?( timeout ):( self->max );
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,283 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "textalk_serial.h"
+
+//------------------------------------------------------------------------------
+static
+speed_t baudrate_to_speed(unsigned baudrate)
+{
+    switch( baudrate )
+    {
+    case 1200   :  return B1200;
+    case 2400   :  return B2400;
+    case 4800   :  return B4800;
+    case 9600   :  return B9600;
+    case 19200  :  return B19200;
+    case 38400  :  return B38400;
+    case 57600  :  return B57600;
+    case 115200 :  return B115200;
+    case 230400 :  return B230400;
+#ifdef B460800
+    case 460800 :  return B460800;
+#endif
+#ifdef B921600
+    case 921600 :  return B921600;
+#endif
+    default     :  return B0;
+    }
+}
+//------------------------------------------------------------------------------
+static
+bool setup_raw_mode(int fd, speed_t speed)
+{
+    struct termios attr;
+    if( tcgetattr(fd, &attr) ) return false;
+
+    cfmakeraw(&attr);
+    attr.c_cflag &= ~( CSIZE | PARENB | CSTOPB | CRTSCTS );
+    attr.c_cflag |= CS8 | CLOCAL | CREAD;
+    attr.c_iflag &= ~( IXON | IXOFF | IXANY | INPCK );
+
+    // Reads return immediately with whatever is available.
+    attr.c_cc[VMIN]  = 0;
+    attr.c_cc[VTIME] = 0;
+
+    if( speed != B0 )
+    {
+        if( cfsetispeed(&attr, speed) || cfsetospeed(&attr, speed) )
+            return false;
+    }
+
+    if( tcsetattr(fd, TCSANOW, &attr) ) return false;
+    tcflush(fd, TCIOFLUSH);
+
+    return true;
+}
+//------------------------------------------------------------------------------
+void textalk_serial_init(textalk_serial_t *self)
+{
+    /**
+     * @memberof textalk_serial_t
+     * @brief Constructor.
+     */
+    self->fd = -1;
+}
+//------------------------------------------------------------------------------
+void textalk_serial_deinit(textalk_serial_t *self)
+{
+    /**
+     * @memberof textalk_serial_t
+     * @brief Destructor.
+     */
+    textalk_serial_close(self);
+}
+//------------------------------------------------------------------------------
+int textalk_serial_open(textalk_serial_t *self, const char *path, unsigned baudrate)
+{
+    /**
+     * @memberof textalk_serial_t
+     * @brief Open a serial port.
+     *
+     * @param self     Object instance.
+     * @param path     Path of the serial device, i.e. "/dev/ttyS0".
+     * @param baudrate The baud rate, i.e. 9600, 115200, ...
+     * @return One of error codes defined in ::textalk_errcode_t.
+     *
+     * @remarks The port will be opened in non-blocking mode,
+     *          and be configured to raw mode with 8 data bits and no hardware parity.
+     *          The parity bit is added and checked by the text talk session,
+     *          see textalk_conf_comm_t::parity.
+     */
+    if( !path ) return TEXTALK_ERR_INVALID_ARG;
+
+    speed_t speed = baudrate_to_speed(baudrate);
+    if( speed == B0 ) return TEXTALK_ERR_INVALID_ARG;
+
+    textalk_serial_close(self);
+
+    int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if( fd < 0 ) return TEXTALK_ERR_STREAM_FAIL;
+
+    if( !setup_raw_mode(fd, speed) )
+    {
+        close(fd);
+        return TEXTALK_ERR_STREAM_FAIL;
+    }
+
+    self->fd = fd;
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+int textalk_serial_open_loopback(textalk_serial_t *self, textalk_serial_t *peer)
+{
+    /**
+     * @memberof textalk_serial_t
+     * @brief Open a pair of connected pseudo terminals.
+     *
+     * @param self Object instance, to be the master side of the pair.
+     * @param peer Another object instance, to be the slave side of the pair.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     *
+     * @remarks Data sent from one side will be received by another side,
+     *          and that can be used to run two sessions against each other
+     *          without real hardware.
+     */
+    textalk_serial_close(self);
+    textalk_serial_close(peer);
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if( master < 0 ) return TEXTALK_ERR_STREAM_FAIL;
+
+    char slavename[64];
+    if( grantpt(master) ||
+        unlockpt(master) ||
+        ptsname_r(master, slavename, sizeof(slavename)) )
+    {
+        close(master);
+        return TEXTALK_ERR_STREAM_FAIL;
+    }
+
+    int slave = open(slavename, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if( slave < 0 )
+    {
+        close(master);
+        return TEXTALK_ERR_STREAM_FAIL;
+    }
+
+    // The line discipline sits on the slave side, turn off echo and translations there.
+    if( !setup_raw_mode(slave, B0) )
+    {
+        close(slave);
+        close(master);
+        return TEXTALK_ERR_STREAM_FAIL;
+    }
+
+    self->fd = master;
+    peer->fd = slave;
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+void textalk_serial_close(textalk_serial_t *self)
+{
+    /**
+     * @memberof textalk_serial_t
+     * @brief Close the port.
+     */
+    if( self->fd >= 0 )
+    {
+        close(self->fd);
+        self->fd = -1;
+    }
+}
+//------------------------------------------------------------------------------
+int textalk_serial_get_fd(const textalk_serial_t *self)
+{
+    /**
+     * @memberof textalk_serial_t
+     * @brief Get the file descriptor of the port, or -1 if the port is not opened.
+     */
+    return self->fd;
+}
+//------------------------------------------------------------------------------
+void textalk_serial_fill_events(textalk_serial_t *self, textalk_events_t *events)
+{
+    /**
+     * @memberof textalk_serial_t
+     * @brief Fill the transport callbacks of a set of session events.
+     *
+     * @param self   Object instance.
+     * @param events The events to be filled.
+     *               The user argument, sender, receiver, waiter, and vectored sender
+     *               will be set to this object, and other callbacks will be untouched.
+     */
+    events->userarg = self;
+    events->sender  = textalk_serial_sender;
+    events->recver  = textalk_serial_recver;
+    events->waiter  = textalk_serial_waiter;
+    events->sendv   = textalk_serial_sendv;
+}
+//------------------------------------------------------------------------------
+int textalk_serial_sender(void *userarg, const void *data, size_t size)
+{
+    /**
+     * @memberof textalk_serial_t
+     * @brief Data sender, @see textalk_sender_t.
+     */
+    textalk_serial_t *self = userarg;
+
+    ssize_t sendsz = write(self->fd, data, size);
+    if( sendsz >= 0 ) return sendsz;
+
+    return ( errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR )?( 0 ):( -1 );
+}
+//------------------------------------------------------------------------------
+int textalk_serial_sendv(void *userarg, const textalk_iovec_t *iov, int iovcnt)
+{
+    /**
+     * @memberof textalk_serial_t
+     * @brief Vectored data sender, @see textalk_sendv_t.
+     */
+    textalk_serial_t *self = userarg;
+
+    struct iovec vec[8];
+    if( iovcnt > (int)( sizeof(vec)/sizeof(vec[0]) ) ) iovcnt = sizeof(vec)/sizeof(vec[0]);
+
+    for(int i = 0; i < iovcnt; ++i)
+    {
+        vec[i].iov_base = (void*) iov[i].data;
+        vec[i].iov_len  = iov[i].size;
+    }
+
+    ssize_t sendsz = writev(self->fd, vec, iovcnt);
+    if( sendsz >= 0 ) return sendsz;
+
+    return ( errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR )?( 0 ):( -1 );
+}
+//------------------------------------------------------------------------------
+int textalk_serial_recver(void *userarg, void *buf, size_t size)
+{
+    /**
+     * @memberof textalk_serial_t
+     * @brief Data receiver, @see textalk_recver_t.
+     */
+    textalk_serial_t *self = userarg;
+
+    ssize_t recvsz = read(self->fd, buf, size);
+    if( recvsz >= 0 ) return recvsz;
+
+    return ( errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR )?( 0 ):( -1 );
+}
+//------------------------------------------------------------------------------
+int textalk_serial_waiter(void *userarg, int flags, unsigned timeout)
+{
+    /**
+     * @memberof textalk_serial_t
+     * @brief Readiness waiter, @see textalk_waiter_t.
+     */
+    textalk_serial_t *self = userarg;
+
+    struct pollfd pfd =
+    {
+        .fd     = self->fd,
+        .events = ( flags & TEXTALK_WAIT_RECV ? POLLIN  : 0 ) |
+                  ( flags & TEXTALK_WAIT_SEND ? POLLOUT : 0 ),
+    };
+
+    int res = poll(&pfd, 1, timeout);
+    if( res < 0 ) return ( errno == EINTR )?( 0 ):( -1 );
+    if( res && ( pfd.revents & ( POLLERR | POLLNVAL ) ) ) return -1;
+
+    // Data left before the hang-up can still be read,
+    // and reading after that would return nothing at once again and again.
+    if( res && ( pfd.revents & POLLHUP ) && !( pfd.revents & POLLIN ) ) return -1;
+
+    return res;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,364 @@
+#include <string.h>
+#include "textalk_simlink.h"
+
+#define NS_PER_US 1000ull
+#define NS_PER_MS 1000000ull
+#define NS_PER_S  1000000000ull
+
+//------------------------------------------------------------------------------
+static
+uint32_t dir_random(textalk_simlink_dir_t *self)
+{
+    // Xorshift32.
+    uint32_t x = self->random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return self->random = x;
+}
+//------------------------------------------------------------------------------
+static
+bool dir_chance(textalk_simlink_dir_t *self, double probability)
+{
+    if( probability <= 0 ) return false;
+    return ( dir_random(self) >> 8 ) * ( 1.0 / 16777216.0 ) < probability;
+}
+//------------------------------------------------------------------------------
+static
+void dir_init(textalk_simlink_dir_t *self, const textalk_simlink_conf_t *conf, int index)
+{
+    memset(self, 0, sizeof(*self));
+    if( conf ) self->conf = *conf;
+
+    unsigned charbits = self->conf.charbits ? self->conf.charbits : 10;
+    self->chartime = self->conf.baudrate ? charbits * NS_PER_S / self->conf.baudrate : 0;
+
+    // The random generator must not be started with ZERO.
+    self->random = self->conf.seed * 2654435761u + index + 1;
+    if( !self->random ) self->random = 1;
+}
+//------------------------------------------------------------------------------
+static
+char dir_corrupt(textalk_simlink_dir_t *self, char ch)
+{
+    if( self->burstremain )
+    {
+        --self->burstremain;
+        ch ^= ( dir_random(self) & 0xFF ) | 0x01;
+    }
+    else if( self->conf.burst_len && dir_chance(self, self->conf.burst) )
+    {
+        self->burstremain = self->conf.burst_len - 1;
+        ch ^= ( dir_random(self) & 0xFF ) | 0x01;
+    }
+
+    if( self->conf.bit_error > 0 )
+    {
+        for(int bit = 0; bit < 8; ++bit)
+        {
+            if( dir_chance(self, self->conf.bit_error) )
+                ch ^= 1 << bit;
+        }
+    }
+
+    return ch;
+}
+//------------------------------------------------------------------------------
+static
+size_t dir_put(textalk_simlink_dir_t *self, uint64_t now, const char *data, size_t size)
+{
+    size_t count = 0;
+    while( count < size && self->size < TEXTALK_SIMLINK_QUEUE_SIZE )
+    {
+        // Characters are transmitted one after another.
+        uint64_t start  = ( self->linefree > now )?( self->linefree ):( now );
+        self->linefree  = start + self->chartime;
+        self->stats.chars += 1;
+
+        char ch = data[count++];
+        if( dir_chance(self, self->conf.drop) )
+        {
+            self->stats.dropped += 1;
+            continue;
+        }
+
+        char out = dir_corrupt(self, ch);
+        if( out != ch ) self->stats.corrupted += 1;
+
+        size_t tail = ( self->head + self->size++ ) % TEXTALK_SIMLINK_QUEUE_SIZE;
+        self->chars[tail]    = out;
+        self->arrivals[tail] = self->linefree + self->conf.delay * NS_PER_US;
+    }
+
+    return count;
+}
+//------------------------------------------------------------------------------
+static
+size_t dir_get(textalk_simlink_dir_t *self, uint64_t now, char *buf, size_t size)
+{
+    size_t count = 0;
+    while( count < size && self->size && self->arrivals[self->head] <= now )
+    {
+        buf[count++] = self->chars[self->head];
+        self->head   = ( self->head + 1 ) % TEXTALK_SIMLINK_QUEUE_SIZE;
+        self->size  -= 1;
+    }
+
+    return count;
+}
+//------------------------------------------------------------------------------
+static
+bool dir_get_next_arrival(const textalk_simlink_dir_t *self, uint64_t *time)
+{
+    if( !self->size ) return false;
+
+    *time = self->arrivals[self->head];
+    return true;
+}
+//------------------------------------------------------------------------------
+void textalk_simlink_init(textalk_simlink_t            *self,
+                          const textalk_simlink_conf_t *conf0,
+                          const textalk_simlink_conf_t *conf1)
+{
+    /**
+     * @memberof textalk_simlink_t
+     * @brief Constructor.
+     *
+     * @param self  Object instance.
+     * @param conf0 Configuration of the direction from end point 0 to 1,
+     *              and can be NULL for a perfect line.
+     * @param conf1 Configuration of the direction from end point 1 to 0,
+     *              and can be NULL for a perfect line.
+     */
+    pthread_mutex_init(&self->lock, NULL);
+    pthread_cond_init(&self->cond, NULL);
+    self->now = 0;
+
+    dir_init(&self->dirs[0], conf0, 0);
+    dir_init(&self->dirs[1], conf1, 1);
+
+    for(int i = 0; i < 2; ++i)
+    {
+        textalk_simlink_end_t *end = &self->ends[i];
+        memset(end, 0, sizeof(*end));
+        end->link  = self;
+        end->index = i;
+    }
+}
+//------------------------------------------------------------------------------
+void textalk_simlink_deinit(textalk_simlink_t *self)
+{
+    /**
+     * @memberof textalk_simlink_t
+     * @brief Destructor.
+     */
+    pthread_cond_destroy(&self->cond);
+    pthread_mutex_destroy(&self->lock);
+}
+//------------------------------------------------------------------------------
+void textalk_simlink_attach(textalk_simlink_t *self, int index, textalk_events_t *events)
+{
+    /**
+     * @memberof textalk_simlink_t
+     * @brief Attach a session to an end point.
+     *
+     * @param self   Object instance.
+     * @param index  Index of the end point, 0 or 1.
+     * @param events The events of the session to be filled.
+     *               The user argument, sender, receiver, waiter, and clock
+     *               will be set to the end point, and other callbacks will be untouched.
+     */
+    textalk_simlink_end_t *end = &self->ends[ index & 1 ];
+
+    pthread_mutex_lock(&self->lock);
+    end->attached = true;
+    end->waiting  = false;
+    pthread_mutex_unlock(&self->lock);
+
+    events->userarg = end;
+    events->sender  = textalk_simlink_sender;
+    events->recver  = textalk_simlink_recver;
+    events->waiter  = textalk_simlink_waiter;
+    events->clock   = textalk_simlink_clock;
+    events->sendv   = NULL;
+}
+//------------------------------------------------------------------------------
+void textalk_simlink_detach(textalk_simlink_t *self, int index)
+{
+    /**
+     * @memberof textalk_simlink_t
+     * @brief Detach the session from an end point,
+     *        and the clock will not wait for it any more.
+     */
+    pthread_mutex_lock(&self->lock);
+    self->ends[ index & 1 ].attached = false;
+    pthread_cond_broadcast(&self->cond);
+    pthread_mutex_unlock(&self->lock);
+}
+//------------------------------------------------------------------------------
+unsigned textalk_simlink_get_time(textalk_simlink_t *self)
+{
+    /**
+     * @memberof textalk_simlink_t
+     * @brief Get the virtual time in milliseconds.
+     */
+    pthread_mutex_lock(&self->lock);
+    unsigned now = self->now / NS_PER_MS;
+    pthread_mutex_unlock(&self->lock);
+
+    return now;
+}
+//------------------------------------------------------------------------------
+void textalk_simlink_get_stats(textalk_simlink_t *self, int index, textalk_simlink_stats_t *stats)
+{
+    /**
+     * @memberof textalk_simlink_t
+     * @brief Get counters of the direction from an end point.
+     */
+    pthread_mutex_lock(&self->lock);
+    *stats = self->dirs[ index & 1 ].stats;
+    pthread_mutex_unlock(&self->lock);
+}
+//------------------------------------------------------------------------------
+static
+bool end_is_ready(const textalk_simlink_end_t *end)
+{
+    const textalk_simlink_t     *link = end->link;
+    const textalk_simlink_dir_t *out  = &link->dirs[ end->index ];
+    const textalk_simlink_dir_t *in   = &link->dirs[ !end->index ];
+
+    uint64_t arrival;
+    if( ( end->waitflags & TEXTALK_WAIT_RECV ) &&
+        dir_get_next_arrival(in, &arrival) &&
+        arrival <= link->now )
+    {
+        return true;
+    }
+
+    return ( end->waitflags & TEXTALK_WAIT_SEND ) && out->size < TEXTALK_SIMLINK_QUEUE_SIZE;
+}
+//------------------------------------------------------------------------------
+static
+bool link_is_all_waiting(const textalk_simlink_t *self)
+{
+    for(int i = 0; i < 2; ++i)
+    {
+        if( self->ends[i].attached && !self->ends[i].waiting )
+            return false;
+    }
+
+    return true;
+}
+//------------------------------------------------------------------------------
+static
+bool link_advance(textalk_simlink_t *self)
+{
+    // Jump to the nearest time that a waiting end point can go on.
+    uint64_t next = UINT64_MAX;
+    for(int i = 0; i < 2; ++i)
+    {
+        const textalk_simlink_end_t *end = &self->ends[i];
+        if( !end->waiting ) continue;
+
+        if( end->deadline < next ) next = end->deadline;
+
+        uint64_t arrival;
+        if( ( end->waitflags & TEXTALK_WAIT_RECV ) &&
+            dir_get_next_arrival(&self->dirs[ !i ], &arrival) &&
+            arrival < next )
+        {
+            next = arrival;
+        }
+    }
+
+    if( next == UINT64_MAX || next <= self->now ) return false;
+
+    self->now = next;
+    return true;
+}
+//------------------------------------------------------------------------------
+int textalk_simlink_sender(void *userarg, const void *data, size_t size)
+{
+    /**
+     * @memberof textalk_simlink_t
+     * @brief Data sender of an end point, @see textalk_sender_t.
+     */
+    textalk_simlink_end_t *end  = userarg;
+    textalk_simlink_t     *link = end->link;
+
+    pthread_mutex_lock(&link->lock);
+    size_t count = dir_put(&link->dirs[ end->index ], link->now, data, size);
+    pthread_cond_broadcast(&link->cond);
+    pthread_mutex_unlock(&link->lock);
+
+    return count;
+}
+//------------------------------------------------------------------------------
+int textalk_simlink_recver(void *userarg, void *buf, size_t size)
+{
+    /**
+     * @memberof textalk_simlink_t
+     * @brief Data receiver of an end point, @see textalk_recver_t.
+     */
+    textalk_simlink_end_t *end  = userarg;
+    textalk_simlink_t     *link = end->link;
+
+    pthread_mutex_lock(&link->lock);
+    size_t count = dir_get(&link->dirs[ !end->index ], link->now, buf, size);
+    if( count ) pthread_cond_broadcast(&link->cond);
+    pthread_mutex_unlock(&link->lock);
+
+    return count;
+}
+//------------------------------------------------------------------------------
+int textalk_simlink_waiter(void *userarg, int flags, unsigned timeout)
+{
+    /**
+     * @memberof textalk_simlink_t
+     * @brief Readiness waiter of an end point, @see textalk_waiter_t.
+     *
+     * @remarks The waiting is on the virtual clock,
+     *          and returns as soon as the clock reached the time.
+     */
+    textalk_simlink_end_t *end  = userarg;
+    textalk_simlink_t     *link = end->link;
+
+    pthread_mutex_lock(&link->lock);
+
+    end->waiting   = true;
+    end->waitflags = flags;
+    end->deadline  = link->now + timeout * NS_PER_MS;
+
+    int res = 0;
+    while( true )
+    {
+        if( end_is_ready(end) )
+        {
+            res = 1;
+            break;
+        }
+
+        if( link->now >= end->deadline ) break;
+
+        if( link_is_all_waiting(link) && link_advance(link) )
+            pthread_cond_broadcast(&link->cond);
+        else
+            pthread_cond_wait(&link->cond, &link->lock);
+    }
+
+    end->waiting = false;
+    pthread_mutex_unlock(&link->lock);
+
+    return res;
+}
+//------------------------------------------------------------------------------
+unsigned textalk_simlink_clock(void *userarg)
+{
+    /**
+     * @memberof textalk_simlink_t
+     * @brief Clock of an end point, @see textalk_clock_t.
+     */
+    textalk_simlink_end_t *end = userarg;
+    return textalk_simlink_get_time(end->link);
+}
+//------------------------------------------------------------------------------
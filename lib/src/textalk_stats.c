@@ -0,0 +1,75 @@
+#include <string.h>
+#include "textalk_stats.h"
+
+//------------------------------------------------------------------------------
+void textalk_hist_reset(textalk_hist_t *self)
+{
+    /**
+     * @memberof textalk_hist_t
+     * @brief Remove all samples.
+     */
+    memset(self, 0, sizeof(*self));
+}
+//------------------------------------------------------------------------------
+void textalk_hist_add(textalk_hist_t *self, unsigned ms)
+{
+    /**
+     * @memberof textalk_hist_t
+     * @brief Add a sample.
+     *
+     * @param self Object instance.
+     * @param ms   The time in milliseconds.
+     */
+    unsigned index = 0;
+    for(unsigned value = ms; value && index < TEXTALK_HIST_SIZE - 1; value >>= 1)
+        ++index;
+
+    self->count[index] += 1;
+    self->total        += 1;
+    self->sum          += ms;
+    if( self->max < ms ) self->max = ms;
+}
+//------------------------------------------------------------------------------
+unsigned textalk_hist_get_percentile(const textalk_hist_t *self, unsigned percent)
+{
+    /**
+     * @memberof textalk_hist_t
+     * @brief Estimate a percentile.
+     *
+     * @param self    Object instance.
+     * @param percent The percentile wanted, from 0 to 100.
+     * @return The upper limit of the bucket that the percentile falls in,
+     *         in milliseconds; or ZERO if there have no samples.
+     *
+     * @remarks The result of the last bucket is the maximum sample.
+     */
+    if( !self->total ) return 0;
+    if( percent > 100 ) percent = 100;
+
+    // The rank of the sample wanted, start from 1.
+    uint64_t rank = ( self->total * percent + 99 ) / 100;
+    if( !rank ) rank = 1;
+
+    uint64_t count = 0;
+    for(unsigned i = 0; i < TEXTALK_HIST_SIZE - 1; ++i)
+    {
+        count += self->count[i];
+        if( count >= rank )
+        {
+            unsigned limit = ( 1u << i ) - 1;
+            return ( limit < self->max )?( limit ):( self->max );
+        }
+    }
+
+    return self->max;
+}
+//------------------------------------------------------------------------------
+void textalk_stats_reset(textalk_stats_t *self)
+{
+    /**
+     * @memberof textalk_stats_t
+     * @brief Clear all counters and histograms.
+     */
+    memset(self, 0, sizeof(*self));
+}
+//------------------------------------------------------------------------------
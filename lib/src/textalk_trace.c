@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include "textalk_errcode.h"
+#include "textalk_trace.h"
+
+//------------------------------------------------------------------------------
+int textalk_trace_init(textalk_trace_t *self, textalk_trace_rec_t *recs, size_t count)
+{
+    /**
+     * @memberof textalk_trace_t
+     * @brief Constructor.
+     *
+     * @param self  Object instance.
+     * @param recs  The buffer of records supplied by the user,
+     *              and it should be kept until the ring be no longer used.
+     * @param count Count of records of the buffer,
+     *              and it must be a power of 2.
+     * @return One of error codes defined in ::textalk_errcode_t.
+     */
+    self->recs = NULL;
+    self->mask = 0;
+    self->head = 0;
+
+    if( !recs || !count || ( count & ( count - 1 ) ) || count > UINT32_MAX / 2 + 1 )
+        return TEXTALK_ERR_INVALID_ARG;
+
+    self->recs = recs;
+    self->mask = count - 1;
+
+    return TEXTALK_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+void textalk_trace_put(textalk_trace_t *self,
+                       unsigned         time,
+                       int              type,
+                       char             ctrl,
+                       size_t           len,
+                       int              errcode)
+{
+    /**
+     * @memberof textalk_trace_t
+     * @brief Write a record.
+     *
+     * @param self    Object instance.
+     * @param time    Time of the event in milliseconds.
+     * @param type    Record type, see ::textalk_trace_type_t.
+     * @param ctrl    The control code, or ZERO if not used.
+     * @param len     Length of the packet, or ZERO if not used.
+     * @param errcode The error code, or ZERO if not used.
+     */
+    uint32_t seq = self->head;
+
+    // The head must be seen by readers before the oldest record be overwritten.
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    textalk_trace_rec_t *rec = &self->recs[ seq & self->mask ];
+    rec->seq     = seq;
+    rec->time    = time;
+    rec->len     = len;
+    rec->errcode = errcode;
+    rec->type    = type;
+    rec->ctrl    = ctrl;
+
+    // Publish the record after it be written completely.
+    __atomic_store_n(&self->head, seq + 1, __ATOMIC_RELEASE);
+}
+//------------------------------------------------------------------------------
+uint32_t textalk_trace_get_head(const textalk_trace_t *self)
+{
+    /**
+     * @memberof textalk_trace_t
+     * @brief Get count of records have been written,
+     *        and it can be used as the cursor to read new records only.
+     */
+    return __atomic_load_n(&self->head, __ATOMIC_ACQUIRE);
+}
+//------------------------------------------------------------------------------
+size_t textalk_trace_read(const textalk_trace_t *self,
+                          uint32_t              *cursor,
+                          textalk_trace_rec_t   *recs,
+                          size_t                 count)
+{
+    /**
+     * @memberof textalk_trace_t
+     * @brief Read records.
+     *
+     * @param self   Object instance.
+     * @param cursor The sequence of the next record to read,
+     *               start from ZERO to read the oldest records in the ring;
+     *               and it will be moved after the records read.
+     * @param recs   A buffer to receive records.
+     * @param count  Count of records of the buffer.
+     * @return Count of records read.
+     *
+     * @remarks Records overwritten before being read will be skipped.
+     */
+    uint32_t head   = __atomic_load_n(&self->head, __ATOMIC_ACQUIRE);
+    uint32_t ringsz = self->mask + 1;
+
+    uint32_t from = *cursor;
+    if( head - from > ringsz ) from = head - ringsz;    // Records lost.
+
+    uint32_t avail = head - from;
+    if( avail > count ) avail = count;
+
+    for(uint32_t i = 0; i < avail; ++i)
+        recs[i] = self->recs[ ( from + i ) & self->mask ];
+
+    /*
+     * Drop records that may be overwritten while being copied,
+     * the writer may be writing the record of the head sequence.
+     */
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    uint32_t newhead = __atomic_load_n(&self->head, __ATOMIC_RELAXED);
+
+    size_t skip = 0;
+    if( newhead - from >= ringsz )
+    {
+        skip = newhead - from - ringsz + 1;
+        if( skip > avail ) skip = avail;
+    }
+
+    for(size_t i = 0; i < avail - skip; ++i)
+        recs[i] = recs[ i + skip ];
+
+    *cursor = from + avail;
+    return avail - skip;
+}
+//------------------------------------------------------------------------------
+const char* textalk_trace_type_to_str(int type)
+{
+    /**
+     * Get name of a record type.
+     */
+    switch( type )
+    {
+    case TEXTALK_TRACE_SEND_CTRL:       return "send-ctrl";
+    case TEXTALK_TRACE_RECV_CTRL:       return "recv-ctrl";
+    case TEXTALK_TRACE_SEND_FRAME:      return "send-frame";
+    case TEXTALK_TRACE_RECV_FRAME:      return "recv-frame";
+    case TEXTALK_TRACE_BAD_FRAME:       return "bad-frame";
+    case TEXTALK_TRACE_TIMEOUT_SEND:    return "timeout-send";
+    case TEXTALK_TRACE_TIMEOUT_ECHO:    return "timeout-echo";
+    case TEXTALK_TRACE_TIMEOUT_RESP:    return "timeout-resp";
+    default:                            return "unknown";
+    }
+}
+//------------------------------------------------------------------------------
+size_t textalk_trace_format(const textalk_trace_rec_t *rec, char *buf, size_t bufsz)
+{
+    /**
+     * @brief Format a record as a line of text (without the new line character).
+     *
+     * @param rec   The record.
+     * @param buf   A buffer to receive the text.
+     * @param bufsz Size of the buffer.
+     * @return Length of the text;
+     *         and the text is truncated if it is not less than the buffer size.
+     */
+    int len = snprintf(buf,
+                       bufsz,
+                       "%10u %10u %-12s ctrl=0x%02X len=%u err=%d",
+                       (unsigned) rec->seq,
+                       (unsigned) rec->time,
+                       textalk_trace_type_to_str(rec->type),
+                       (unsigned) rec->ctrl,
+                       (unsigned) rec->len,
+                       (int) rec->errcode);
+
+    return ( len > 0 )?( len ):( 0 );
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,134 @@
+/*
+ * Decode captures with frames longer than the maximum size.
+ */
+#include <string.h>
+#include "textalk_capture.h"
+#include "textalk_packet.h"
+#include "test_util.h"
+
+#define FRAME_MAX   16
+#define BIG_SIZE    ( 5 << 20 )     // Large enough to be split for several threads.
+
+//------------------------------------------------------------------------------
+static
+size_t put_frame(char *buf, const textalk_conf_t *conf, const char *text, bool echo)
+{
+    size_t size = textalk_packet_encode(buf, TEXTALK_PKT_MAX_SIZE, text, strlen(text), conf, false);
+    TEST_CHECK(size);
+
+    textalk_conf_ctrl_t wire;
+    textalk_packet_get_wire_ctrl(&wire, conf);
+
+    if( echo ) buf[size++] = wire.ack;
+    return size;
+}
+//------------------------------------------------------------------------------
+static
+size_t put_round(char *buf, const textalk_conf_t *conf)
+{
+    // A frame of one character more than the maximum (with its LRC),
+    // a frame never ended, and valid frames.
+    size_t size = 0;
+    size += put_frame(buf + size, conf, "ABCDEFGHIJKLMN", false);
+    size += put_frame(buf + size, conf, "First", true);
+    size += textalk_packet_encode_head(buf + size, TEXTALK_PKT_MAX_SIZE, conf);
+    memset(buf + size, 'X', 2 * FRAME_MAX);
+    size += 2 * FRAME_MAX;
+    size += put_frame(buf + size, conf, "Second", true);
+    size += put_frame(buf + size, conf, "The third", false);
+
+    return size;
+}
+//------------------------------------------------------------------------------
+static
+void test_too_long(const textalk_conf_t *conf)
+{
+    char   buf[256];
+    size_t size = put_round(buf, conf);
+
+    textalk_capture_t capture;
+    textalk_capture_init(&capture, buf, size);
+    TEST_CHECK_EQ(textalk_capture_decode(&capture, conf, 1), TEXTALK_ERR_SUCCESS);
+
+    size_t                         count;
+    const textalk_capture_frame_t *frames = textalk_capture_get_frames(&capture, &count);
+    TEST_CHECK_EQ(count, 5);
+
+    TEST_CHECK_EQ(frames[0].offset, 0);
+    TEST_CHECK_EQ(frames[0].status, TEXTALK_CAPTURE_TOO_LONG);
+    TEST_CHECK_EQ(frames[0].size, FRAME_MAX + 1);
+
+    TEST_CHECK_EQ(frames[1].offset, FRAME_MAX + 1);
+    TEST_CHECK_EQ(frames[1].status, TEXTALK_CAPTURE_OK);
+    TEST_CHECK_EQ(frames[1].echo, conf->ctrl.ack);
+
+    TEST_CHECK_EQ(frames[2].status, TEXTALK_CAPTURE_TOO_LONG);
+    TEST_CHECK_EQ(frames[2].size, FRAME_MAX);
+
+    char text[FRAME_MAX];
+    TEST_CHECK_EQ(frames[3].status, TEXTALK_CAPTURE_OK);
+    TEST_CHECK(textalk_capture_get_text(&capture, &frames[3], conf, text, sizeof(text)));
+    TEST_CHECK(!strcmp(text, "Second"));
+
+    TEST_CHECK_EQ(frames[4].status, TEXTALK_CAPTURE_OK);
+    TEST_CHECK_EQ(frames[4].offset + frames[4].size, size);
+    TEST_CHECK_EQ(frames[4].echo, 0);
+
+    textalk_capture_close(&capture);
+
+    // Only a frame cut by the end of the capture is truncated.
+    textalk_capture_init(&capture, buf, size - 1);
+    TEST_CHECK_EQ(textalk_capture_decode(&capture, conf, 1), TEXTALK_ERR_SUCCESS);
+    frames = textalk_capture_get_frames(&capture, &count);
+    TEST_CHECK_EQ(count, 5);
+    TEST_CHECK_EQ(frames[4].status, TEXTALK_CAPTURE_TRUNCATED);
+    textalk_capture_close(&capture);
+}
+//------------------------------------------------------------------------------
+static
+void test_threads_agree(const textalk_conf_t *conf)
+{
+    char *buf = malloc(BIG_SIZE);
+    TEST_CHECK(buf);
+
+    size_t size   = 0;
+    size_t rounds = 0;
+    while( size + 256 <= BIG_SIZE )
+    {
+        size += put_round(buf + size, conf);
+        ++rounds;
+    }
+
+    textalk_capture_t single, multi;
+    textalk_capture_init(&single, buf, size);
+    textalk_capture_init(&multi, buf, size);
+    TEST_CHECK_EQ(textalk_capture_decode(&single, conf, 1), TEXTALK_ERR_SUCCESS);
+    TEST_CHECK_EQ(textalk_capture_decode(&multi, conf, 4), TEXTALK_ERR_SUCCESS);
+
+    size_t                         count, multicount;
+    const textalk_capture_frame_t *frames      = textalk_capture_get_frames(&single, &count);
+    const textalk_capture_frame_t *multiframes = textalk_capture_get_frames(&multi, &multicount);
+    TEST_CHECK_EQ(count, rounds * 5);
+    TEST_CHECK_EQ(multicount, count);
+    TEST_CHECK(!memcmp(frames, multiframes, count * sizeof(*frames)));
+
+    textalk_capture_close(&single);
+    textalk_capture_close(&multi);
+    free(buf);
+}
+//------------------------------------------------------------------------------
+int main(void)
+{
+    textalk_conf_t conf = *textalk_conf_get_defaults();
+    conf.comm.frame_max = FRAME_MAX;
+
+    test_too_long(&conf);
+    test_threads_agree(&conf);
+
+    conf.comm.parity = TEXTALK_PARITY_EVEN;
+    test_too_long(&conf);
+    test_threads_agree(&conf);
+
+    return 0;
+}
+//------------------------------------------------------------------------------
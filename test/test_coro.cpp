@@ -0,0 +1,151 @@
+/*
+ * Exchange texts by coroutines on two lines of a socket pair.
+ */
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "textalk_coro.h"
+#include "test_util.h"
+
+//------------------------------------------------------------------------------
+class TPeer
+{
+public:
+    int       fd;
+    textalk_t session;
+
+public:
+    TPeer(int fd, const textalk_conf_t &conf) : fd(fd)
+    {
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+
+        textalk_events_t events = {};
+        events.userarg = this;
+        events.sender  = Sender;
+        events.recver  = Recver;
+        TEST_CHECK_EQ(textalk_init_ex(&session, &conf, &events, NULL), TEXTALK_ERR_SUCCESS);
+    }
+
+    ~TPeer()
+    {
+        textalk_deinit(&session);
+        close(fd);
+    }
+
+private:
+    static int Sender(void *userarg, const void *data, size_t size)
+    {
+        ssize_t sendsz = send(((TPeer*) userarg)->fd, data, size, MSG_NOSIGNAL);
+        if( sendsz >= 0 ) return sendsz;
+        return ( errno == EAGAIN )?( 0 ):( -1 );
+    }
+
+    static int Recver(void *userarg, void *buf, size_t size)
+    {
+        ssize_t recvsz = read(((TPeer*) userarg)->fd, buf, size);
+        if( recvsz >= 0 ) return recvsz;
+        return ( errno == EAGAIN )?( 0 ):( -1 );
+    }
+};
+//------------------------------------------------------------------------------
+static
+TTextalkTask send_texts(TTextalkCoLine &line, int *results)
+{
+    results[0] = co_await line.Send("First", true);
+    results[1] = co_await line.Send("Last");
+}
+//------------------------------------------------------------------------------
+static
+TTextalkTask receive_texts(TTextalkCoLine &line, TTextalkCoText *results)
+{
+    // The last one is never sent, and times out.
+    for(int i = 0; i < 3; ++i)
+        results[i] = co_await line.Receive();
+}
+//------------------------------------------------------------------------------
+static
+void test_exchange(const textalk_conf_t &conf)
+{
+    int fds[2];
+    TEST_CHECK(!socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+    TTextalkLoop   loop;
+    TPeer          sender(fds[0], conf), recver(fds[1], conf);
+    TTextalkCoLine sendline(loop, sender.session, sender.fd);
+    TTextalkCoLine recvline(loop, recver.session, recver.fd);
+
+    int            sent[2] = { TEXTALK_ERR_GENERAL, TEXTALK_ERR_GENERAL };
+    TTextalkCoText texts[3];
+    loop.Spawn(receive_texts(recvline, texts));
+    loop.Spawn(send_texts(sendline, sent));
+
+    unsigned start = loop.Now();
+    TEST_CHECK_EQ(loop.Run(), TEXTALK_ERR_SUCCESS);
+    TEST_CHECK_EQ(loop.GetTaskCount(), 0);
+
+    TEST_CHECK_EQ(sent[0], TEXTALK_ERR_SUCCESS);
+    TEST_CHECK_EQ(sent[1], TEXTALK_ERR_SUCCESS);
+
+    TEST_CHECK_EQ(texts[0].errcode, TEXTALK_ERR_SUCCESS);
+    TEST_CHECK(texts[0].text == "First");
+    TEST_CHECK(texts[0].havemore);
+    TEST_CHECK_EQ(texts[1].errcode, TEXTALK_ERR_SUCCESS);
+    TEST_CHECK(texts[1].text == "Last");
+    TEST_CHECK(!texts[1].havemore);
+
+    TEST_CHECK_EQ(texts[2].errcode, TEXTALK_ERR_TIMEOUT);
+    TEST_CHECK(texts[2].text.empty());
+    TEST_CHECK(loop.Now() - start >= conf.comm.timeout.resp);
+
+    TEST_CHECK_EQ(textalk_get_stats(&sender.session)->tx_frames, 2);
+}
+//------------------------------------------------------------------------------
+static
+TTextalkTask send_one(TTextalkCoLine &line, int *result)
+{
+    *result = co_await line.Send("Hello");
+}
+//------------------------------------------------------------------------------
+static
+void test_no_answer(const textalk_conf_t &conf)
+{
+    int fds[2];
+    TEST_CHECK(!socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+    // Nobody answers on the other end.
+    TTextalkLoop   loop;
+    TPeer          sender(fds[0], conf);
+    TTextalkCoLine line(loop, sender.session, sender.fd);
+
+    int result = TEXTALK_ERR_GENERAL;
+    loop.Spawn(send_one(line, &result));
+    TEST_CHECK_EQ(loop.Run(), TEXTALK_ERR_SUCCESS);
+
+    TEST_CHECK_EQ(result, TEXTALK_ERR_TIMEOUT);
+    TEST_CHECK_EQ(textalk_get_stats(&sender.session)->timeout_echo, conf.comm.retry_max + 1);
+
+    // The remote closed, and the line is broken.
+    close(fds[1]);
+    loop.Spawn(send_one(line, &result));
+    TEST_CHECK_EQ(loop.Run(), TEXTALK_ERR_SUCCESS);
+    TEST_CHECK_EQ(result, TEXTALK_ERR_STREAM_FAIL);
+}
+//------------------------------------------------------------------------------
+int main(void)
+{
+    textalk_conf_t conf = *textalk_conf_get_defaults();
+    conf.comm.timeout.resp = 100;
+    conf.comm.timeout.echo = 20;
+    conf.comm.retry_max    = 1;
+
+    test_exchange(conf);
+    test_no_answer(conf);
+
+    conf.comm.parity = TEXTALK_PARITY_EVEN;
+    test_exchange(conf);
+
+    return 0;
+}
+//------------------------------------------------------------------------------
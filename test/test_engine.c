@@ -0,0 +1,202 @@
+/*
+ * Run two engines against each other on a virtual clock,
+ * with packets lost on the way, or both bidding for the line at once.
+ */
+#include <string.h>
+#include "textalk_engine.h"
+#include "test_util.h"
+
+#define MESSAGE_SIZE 100
+#define TIME_LIMIT   60000
+
+typedef struct peer_t
+{
+    textalk_engine_t engine;
+    textalk_stats_t  stats;
+    char             text[MESSAGE_SIZE];    // Texts received, joined.
+    size_t           textlen;
+    bool             havemore;              // The last text received have more parts or not.
+    int              packets;               // Count of packets sent.
+    int              done;                  // Count of results of texts sent.
+    int              errcode;               // The last result.
+} peer_t;
+
+static unsigned now;
+
+//------------------------------------------------------------------------------
+static
+void peer_open(peer_t *peer, const textalk_conf_t *conf)
+{
+    memset(peer, 0, sizeof(*peer));
+    TEST_CHECK_EQ(textalk_engine_init(&peer->engine, conf, now), TEXTALK_ERR_SUCCESS);
+    textalk_engine_set_stats(&peer->engine, &peer->stats);
+}
+//------------------------------------------------------------------------------
+static
+void peer_take_events(peer_t *peer)
+{
+    textalk_engine_event_t event;
+    while( textalk_engine_next_event(&peer->engine, &event) )
+    {
+        switch( event.type )
+        {
+        case TEXTALK_ENGINE_EV_TEXT:
+            TEST_CHECK(peer->textlen + event.textlen <= MESSAGE_SIZE);
+            memcpy(peer->text + peer->textlen, event.text, event.textlen);
+            peer->textlen += event.textlen;
+            peer->havemore = event.havemore;
+            break;
+
+        case TEXTALK_ENGINE_EV_SENT:
+        case TEXTALK_ENGINE_EV_FAILED:
+            ++peer->done;
+            peer->errcode = event.errcode;
+            break;
+        }
+    }
+}
+//------------------------------------------------------------------------------
+static
+bool transfer(peer_t *src, peer_t *dest, int lose)
+{
+    // Move output of one engine to the other, and lose the packet of the given count.
+    bool moved = false;
+
+    const void *data;
+    size_t      size;
+    while( ( size = textalk_engine_peek_output(&src->engine, &data) ) )
+    {
+        const char *bytes = data;
+        bool        lost  = ( bytes[0] == src->engine.wire.stx && src->packets++ == lose );
+        for(size_t pos = 0; !lost && pos < size; )
+        {
+            pos += textalk_engine_feed(&dest->engine, bytes + pos, size - pos);
+            peer_take_events(dest);
+        }
+
+        textalk_engine_drop_output(&src->engine, size);
+        peer_take_events(src);
+        moved = true;
+    }
+
+    return moved;
+}
+//------------------------------------------------------------------------------
+static
+void run(peer_t *sender, peer_t *recver, int lose)
+{
+    // Run until the sender get one more result.
+    int done = sender->done;
+    while( sender->done == done && now < TIME_LIMIT )
+    {
+        bool moved = transfer(sender, recver, lose);
+        moved = transfer(recver, sender, -1) || moved;
+        if( moved ) continue;
+
+        // Nothing on the line, and the time goes to the nearest deadline.
+        unsigned next = now + 1000;
+        unsigned deadline;
+        if( textalk_engine_get_deadline(&sender->engine, &deadline) && (int)( deadline - next ) < 0 )
+            next = deadline;
+        if( textalk_engine_get_deadline(&recver->engine, &deadline) && (int)( deadline - next ) < 0 )
+            next = deadline;
+        if( (int)( next - now ) > 0 ) now = next;
+
+        textalk_engine_on_time(&sender->engine, now);
+        textalk_engine_on_time(&recver->engine, now);
+        peer_take_events(sender);
+        peer_take_events(recver);
+    }
+}
+//------------------------------------------------------------------------------
+static
+void test_window(int parity, int lose)
+{
+    textalk_conf_t conf = *textalk_conf_get_defaults();
+    conf.comm.parity    = parity;
+    conf.comm.window    = 4;
+    conf.comm.frame_max = 16;
+
+    char message[MESSAGE_SIZE];
+    for(int i = 0; i < MESSAGE_SIZE; ++i)
+        message[i] = 'A' + i % 26;
+
+    now = 0;
+    peer_t sender, recver;
+    peer_open(&sender, &conf);
+    peer_open(&recver, &conf);
+
+    // The whole message is one exchange, and split into blocks by the engine.
+    TEST_CHECK_EQ(textalk_engine_send_ref(&sender.engine, message, sizeof(message), false), TEXTALK_ERR_SUCCESS);
+    TEST_CHECK_EQ(textalk_engine_send_ref(&sender.engine, message, sizeof(message), false), TEXTALK_ERR_BUSY);
+    run(&sender, &recver, lose);
+
+    TEST_CHECK_EQ(sender.done, 1);
+    TEST_CHECK_EQ(sender.errcode, TEXTALK_ERR_SUCCESS);
+    TEST_CHECK_EQ(recver.textlen, MESSAGE_SIZE);
+    TEST_CHECK(!memcmp(recver.text, message, MESSAGE_SIZE));
+    TEST_CHECK(!recver.havemore);
+
+    // Only the block lost is sent again.
+    size_t blocks = ( MESSAGE_SIZE + textalk_engine_get_block_size(&sender.engine) - 1 ) /
+                    textalk_engine_get_block_size(&sender.engine);
+    TEST_CHECK_EQ(sender.stats.tx_frames, blocks + ( lose >= 0 ));
+    TEST_CHECK_EQ(sender.stats.retries, ( lose >= 0 ));
+
+    textalk_engine_deinit(&sender.engine);
+    textalk_engine_deinit(&recver.engine);
+}
+//------------------------------------------------------------------------------
+static
+void test_contention(bool secondfirst)
+{
+    textalk_conf_t conf = *textalk_conf_get_defaults();
+
+    now = 0;
+    peer_t primary, secondary;
+    conf.comm.role = TEXTALK_ROLE_PRIMARY;
+    peer_open(&primary, &conf);
+    conf.comm.role = TEXTALK_ROLE_SECONDARY;
+    peer_open(&secondary, &conf);
+
+    // Both sides bid at once, and the secondary yields to the primary.
+    TEST_CHECK_EQ(textalk_engine_send_ref(&primary.engine, "Primary", 7, false), TEXTALK_ERR_SUCCESS);
+    TEST_CHECK_EQ(textalk_engine_send_ref(&secondary.engine, "Secondary", 9, false), TEXTALK_ERR_SUCCESS);
+    if( secondfirst ) transfer(&secondary, &primary, -1);
+    run(&primary, &secondary, -1);
+
+    TEST_CHECK_EQ(primary.done, 1);
+    TEST_CHECK_EQ(primary.errcode, TEXTALK_ERR_SUCCESS);
+    TEST_CHECK_EQ(secondary.done, 1);
+    TEST_CHECK_EQ(secondary.errcode, TEXTALK_ERR_CONTENTION);
+    TEST_CHECK_EQ(secondary.textlen, 7);
+    TEST_CHECK(!memcmp(secondary.text, "Primary", 7));
+    TEST_CHECK_EQ(primary.textlen, 0);
+
+    // The secondary sends again after the text of the primary received.
+    TEST_CHECK_EQ(textalk_engine_send_ref(&secondary.engine, "Secondary", 9, false), TEXTALK_ERR_SUCCESS);
+    run(&secondary, &primary, -1);
+
+    TEST_CHECK_EQ(secondary.done, 2);
+    TEST_CHECK_EQ(secondary.errcode, TEXTALK_ERR_SUCCESS);
+    TEST_CHECK_EQ(primary.textlen, 9);
+    TEST_CHECK(!memcmp(primary.text, "Secondary", 9));
+    TEST_CHECK_EQ(primary.done, 1);
+
+    textalk_engine_deinit(&primary.engine);
+    textalk_engine_deinit(&secondary.engine);
+}
+//------------------------------------------------------------------------------
+int main(void)
+{
+    test_window(TEXTALK_PARITY_NONE, -1);   // No error.
+    test_window(TEXTALK_PARITY_NONE, 0);    // The first block, before the window opens.
+    test_window(TEXTALK_PARITY_NONE, 2);    // A block inside the window.
+    test_window(TEXTALK_PARITY_EVEN, 3);
+
+    test_contention(false);     // The bid of the primary arrives first.
+    test_contention(true);      // The bid of the secondary arrives first.
+
+    return 0;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,157 @@
+/*
+ * Exchange texts through an executor, and take results and texts in order.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "textalk_executor.h"
+#include "textalk_packet.h"
+#include "test_util.h"
+
+typedef struct peer_t
+{
+    int       fds[2];   // The end of the session, and the end of the test.
+    textalk_t session;
+} peer_t;
+
+//------------------------------------------------------------------------------
+static
+int peer_sender(peer_t *peer, const void *data, size_t size)
+{
+    ssize_t sendsz = write(peer->fds[0], data, size);
+    if( sendsz >= 0 ) return sendsz;
+    return ( errno == EAGAIN )?( 0 ):( -1 );
+}
+//------------------------------------------------------------------------------
+static
+int peer_recver(peer_t *peer, void *buf, size_t size)
+{
+    ssize_t recvsz = read(peer->fds[0], buf, size);
+    if( recvsz >= 0 ) return recvsz;
+    return ( errno == EAGAIN )?( 0 ):( -1 );
+}
+//------------------------------------------------------------------------------
+static
+void remote_expect(peer_t *peer, const char *data, size_t size)
+{
+    // Read the given data from the end of the test.
+    char   buf[TEXTALK_PKT_MAX_SIZE];
+    size_t recvsz = 0;
+    while( recvsz < size )
+    {
+        ssize_t res = read(peer->fds[1], buf + recvsz, size - recvsz);
+        TEST_CHECK(res > 0);
+        recvsz += res;
+    }
+
+    TEST_CHECK(!memcmp(buf, data, size));
+}
+//------------------------------------------------------------------------------
+static
+void remote_put_text(peer_t *peer, const textalk_conf_t *conf, const char *text, bool havemore)
+{
+    char   pkt[TEXTALK_PKT_MAX_SIZE];
+    size_t size = textalk_packet_encode(pkt, sizeof(pkt), text, strlen(text), conf, havemore);
+    TEST_CHECK(size);
+    TEST_CHECK_EQ(write(peer->fds[1], pkt, size), size);
+
+    // Each text is acknowledged by the I/O thread.
+    remote_expect(peer, &conf->ctrl.ack, 1);
+}
+//------------------------------------------------------------------------------
+static
+void remote_take_text(peer_t *peer, const textalk_conf_t *conf, const char *text, bool havemore)
+{
+    char   pkt[TEXTALK_PKT_MAX_SIZE];
+    size_t size = textalk_packet_encode(pkt, sizeof(pkt), text, strlen(text), conf, havemore);
+    TEST_CHECK(size);
+
+    remote_expect(peer, pkt, size);
+    TEST_CHECK_EQ(write(peer->fds[1], &conf->ctrl.ack, 1), 1);
+}
+//------------------------------------------------------------------------------
+static
+void test_queues(const textalk_conf_t *conf)
+{
+    peer_t peer;
+    TEST_CHECK(!socketpair(AF_UNIX, SOCK_STREAM, 0, peer.fds));
+    fcntl(peer.fds[0], F_SETFL, O_NONBLOCK);
+
+    textalk_events_t events =
+    {
+        .userarg = &peer,
+        .sender  = (textalk_sender_t) peer_sender,
+        .recver  = (textalk_recver_t) peer_recver,
+    };
+    TEST_CHECK_EQ(textalk_init_ex(&peer.session, conf, &events, NULL), TEXTALK_ERR_SUCCESS);
+
+    textalk_executor_t executor;
+    unsigned           port;
+    TEST_CHECK_EQ(textalk_executor_init(&executor, NULL), TEXTALK_ERR_SUCCESS);
+    TEST_CHECK_EQ(textalk_executor_add(&executor, &peer.session, peer.fds[0], &port), TEXTALK_ERR_SUCCESS);
+    TEST_CHECK_EQ(textalk_executor_start(&executor), TEXTALK_ERR_SUCCESS);
+
+    // Requests are sent one by one, and completed in order of submission.
+    static const char *texts[] = { "First", "Second", "Last" };
+    textalk_exec_req_t reqs[3];
+    for(int i = 0; i < 3; ++i)
+    {
+        memset(&reqs[i], 0, sizeof(reqs[i]));
+        reqs[i].text     = texts[i];
+        reqs[i].havemore = ( i < 2 );
+        TEST_CHECK_EQ(textalk_executor_submit(&executor, port, &reqs[i]), TEXTALK_ERR_SUCCESS);
+    }
+
+    for(int i = 0; i < 3; ++i)
+        remote_take_text(&peer, conf, texts[i], reqs[i].havemore);
+
+    for(int i = 0; i < 3; ++i)
+    {
+        textalk_exec_req_t *req;
+        while( !( req = textalk_executor_take_done(&executor) ) )
+            TEST_CHECK_EQ(textalk_executor_wait(&executor, 1000), TEXTALK_ERR_SUCCESS);
+
+        TEST_CHECK(req == &reqs[i]);
+        TEST_CHECK_EQ(req->port, port);
+        TEST_CHECK_EQ(req->errcode, TEXTALK_ERR_SUCCESS);
+    }
+    TEST_CHECK(!textalk_executor_take_done(&executor));
+
+    // Texts received keep their length and continuation.
+    for(int i = 0; i < 3; ++i)
+        remote_put_text(&peer, conf, texts[i], ( i < 2 ));
+
+    for(int i = 0; i < 3; ++i)
+    {
+        textalk_exec_text_t *text;
+        while( !( text = textalk_executor_take_text(&executor) ) )
+            TEST_CHECK_EQ(textalk_executor_wait(&executor, 1000), TEXTALK_ERR_SUCCESS);
+
+        TEST_CHECK_EQ(text->port, port);
+        TEST_CHECK_EQ(text->len, strlen(texts[i]));
+        TEST_CHECK(!strcmp(text->text, texts[i]));
+        TEST_CHECK_EQ(text->havemore, ( i < 2 ));
+        textalk_executor_free_text(&executor, text);
+    }
+    TEST_CHECK(!textalk_executor_take_text(&executor));
+    TEST_CHECK_EQ(textalk_executor_get_dropped(&executor), 0);
+
+    textalk_executor_deinit(&executor);
+    textalk_deinit(&peer.session);
+    close(peer.fds[0]);
+    close(peer.fds[1]);
+}
+//------------------------------------------------------------------------------
+int main(void)
+{
+    textalk_conf_t conf = *textalk_conf_get_defaults();
+    test_queues(&conf);
+
+    conf.comm.parity = TEXTALK_PARITY_EVEN;
+    test_queues(&conf);
+
+    return 0;
+}
+//------------------------------------------------------------------------------
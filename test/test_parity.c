@@ -0,0 +1,170 @@
+/*
+ * Check every parity kernel against a scalar reference.
+ *
+ * All 256 byte values are run through each kernel, on odd and even parity,
+ * with lengths crossing the vector widths, and at unaligned places.
+ */
+#include <string.h>
+#include "textalk_conf.h"
+#include "parity.h"
+#include "test_util.h"
+
+#define LEN_MAX    100
+#define OFFSET_MAX 4
+
+//------------------------------------------------------------------------------
+static
+bool ref_odd_bits(unsigned char ch)
+{
+    return __builtin_popcount(ch) & 0x01;
+}
+//------------------------------------------------------------------------------
+static
+unsigned char ref_add(unsigned char ch, int odd_even)
+{
+    if( !odd_even ) return ch;
+
+    bool odd = odd_even & 0x01;
+    return ( ref_odd_bits(ch & 0x7F) == odd )?( ch & 0x7F ):( ch | 0x80 );
+}
+//------------------------------------------------------------------------------
+static
+bool ref_check(unsigned char ch, int odd_even)
+{
+    if( !odd_even ) return true;
+    return ref_odd_bits(ch) == ( odd_even & 0x01 );
+}
+//------------------------------------------------------------------------------
+static
+void fill(char *arr, size_t len, unsigned seed)
+{
+    // Each value comes to each place as the seed runs over all bytes.
+    for(size_t i = 0; i < len; ++i)
+        arr[i] = seed + i * 37;
+}
+//------------------------------------------------------------------------------
+static
+void check_arrays(const char *src, size_t len, int odd_even)
+{
+    char          buf[LEN_MAX + OFFSET_MAX];
+    char          ref[LEN_MAX];
+    char          text[LEN_MAX] = {0};
+    unsigned char refsum;
+    bool          refok;
+
+    // Parity be added to texts of 7-bit characters.
+    refsum = 0;
+    for(size_t i = 0; i < len; ++i)
+    {
+        text[i] = src[i] & 0x7F;
+        refsum ^= ref[i] = ref_add(text[i], odd_even);
+    }
+
+    // Add in place.
+    memcpy(buf, text, len);
+    parity_arr_add(buf, len, odd_even);
+    TEST_CHECK(!memcmp(buf, ref, len));
+
+    // Copy with parity added.
+    memset(buf, 0, sizeof(buf));
+    TEST_CHECK_EQ((unsigned char) parity_arr_copy_add(buf, text, len, odd_even), refsum);
+    TEST_CHECK(!memcmp(buf, ref, len));
+
+    // Check.
+    refok = true;
+    for(size_t i = 0; i < len; ++i)
+        refok = refok && ref_check(src[i], odd_even);
+    TEST_CHECK_EQ(parity_arr_check(src, len, odd_even), refok);
+
+    // Copy with parity checked and removed.
+    refsum = 0;
+    for(size_t i = 0; i < len; ++i)
+    {
+        refsum ^= src[i];
+        ref[i]  = ( odd_even )?( src[i] & 0x7F ):( src[i] );
+    }
+    bool ok = !refok;
+    memset(buf, 0, sizeof(buf));
+    TEST_CHECK_EQ((unsigned char) parity_arr_copy_remove(buf, src, len, odd_even, &ok), refsum);
+    TEST_CHECK_EQ(ok, refok);
+    TEST_CHECK(!memcmp(buf, ref, len));
+
+    // The same in place.
+    memcpy(buf, src, len);
+    ok = !refok;
+    TEST_CHECK_EQ((unsigned char) parity_arr_copy_remove(buf, buf, len, odd_even, &ok), refsum);
+    TEST_CHECK_EQ(ok, refok);
+    TEST_CHECK(!memcmp(buf, ref, len));
+
+    // Remove in place.
+    memcpy(buf, src, len);
+    parity_arr_remove(buf, len, odd_even);
+    TEST_CHECK(!memcmp(buf, ref, len));
+}
+//------------------------------------------------------------------------------
+static
+void check_kernel(void)
+{
+    static const int parities[] = { TEXTALK_PARITY_NONE, TEXTALK_PARITY_ODD, TEXTALK_PARITY_EVEN };
+
+    char arr[LEN_MAX + OFFSET_MAX];
+    for(size_t p = 0; p < sizeof(parities) / sizeof(parities[0]); ++p)
+    {
+        int odd_even = parities[p];
+        for(size_t offset = 0; offset < OFFSET_MAX; ++offset)
+        {
+            for(size_t len = 0; len <= LEN_MAX; ++len)
+            {
+                char *src = arr + offset;
+
+                // Random parities.
+                for(unsigned seed = 0; seed < 256; ++seed)
+                {
+                    fill(src, len, seed);
+                    check_arrays(src, len, odd_even);
+                }
+
+                // Good parities, then one bad character at each place.
+                for(unsigned seed = 0; seed < 4; ++seed)
+                {
+                    fill(src, len, seed);
+                    for(size_t i = 0; i < len; ++i)
+                        src[i] = ref_add(src[i] & 0x7F, odd_even);
+                    check_arrays(src, len, odd_even);
+
+                    for(size_t i = 0; odd_even && i < len; ++i)
+                    {
+                        src[i] ^= 0x80;
+                        check_arrays(src, len, odd_even);
+                        src[i] ^= 0x80;
+                    }
+                }
+            }
+        }
+    }
+}
+//------------------------------------------------------------------------------
+int main(void)
+{
+    static const struct { int kernel; const char *name; } kernels[] =
+    {
+        { PARITY_KERNEL_TABLE, "table" },
+        { PARITY_KERNEL_SSE2,  "SSE2"  },
+        { PARITY_KERNEL_AVX2,  "AVX2"  },
+        { PARITY_KERNEL_AUTO,  "auto"  },
+    };
+
+    for(size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); ++i)
+    {
+        if( !parity_select_kernel(kernels[i].kernel) )
+        {
+            printf("Kernel %s is not supported, skipped\n", kernels[i].name);
+            continue;
+        }
+
+        check_kernel();
+    }
+
+    return 0;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,121 @@
+/*
+ * Check compile-time profiles produce and accept the same packets
+ * as the runtime configured codec.
+ */
+#include <cstring>
+#include <string>
+#include "textalk_engine.h"
+#include "textalk_packet.h"
+#include "textalk_profile.h"
+#include "test_util.h"
+
+//------------------------------------------------------------------------------
+static
+std::string make_text(size_t len, bool eightbit, const textalk_conf_ctrl_t &ctrl)
+{
+    // Characters of all values, except control characters of the packet.
+    std::string text;
+    for(size_t i = 0; text.size() < len; ++i)
+    {
+        char ch = ( eightbit )?( (char)( i * 37 ) ):( (char)( 0x20 + i % 0x5F ) );
+        if( ( ch & 0x7F ) >= 0x20 && !std::memchr(&ctrl, ch & 0x7F, sizeof(ctrl)) )
+            text += ch;
+    }
+
+    return text;
+}
+//------------------------------------------------------------------------------
+template < typename Profile >
+static
+void check_decode(const char *pkt, size_t pktsz, size_t bufsz)
+{
+    // Both decoders give the same result for any packet.
+    textalk_conf_t conf = Profile::GetConf();
+
+    char   rtbuf[TEXTALK_PKT_MAX_SIZE], pfbuf[TEXTALK_PKT_MAX_SIZE];
+    size_t rtlen  = 0, pflen  = 0;
+    bool   rtmore = false, pfmore = false;
+    int    rtres  = textalk_packet_decode(rtbuf, bufsz, pkt, pktsz, &conf, &rtlen, &rtmore);
+    int    pfres  = Profile::codec.decode(pfbuf, bufsz, pkt, pktsz, &conf, &pflen, &pfmore);
+
+    TEST_CHECK_EQ(pfres, rtres);
+    if( rtres != TEXTALK_CODEC_OK ) return;
+
+    TEST_CHECK_EQ(pflen, rtlen);
+    TEST_CHECK_EQ(pfmore, rtmore);
+    TEST_CHECK(!std::memcmp(pfbuf, rtbuf, rtlen + 1));
+}
+//------------------------------------------------------------------------------
+template < typename Profile >
+static
+void test_profile(bool eightbit)
+{
+    textalk_conf_t conf = Profile::GetConf();
+    TEST_CHECK(Profile::Match(conf));
+    TEST_CHECK(Profile::codec.match(&conf));
+
+    textalk_conf_ctrl_t wire;
+    textalk_packet_get_wire_ctrl(&wire, &conf);
+    TEST_CHECK(!std::memcmp(&wire, &Profile::wire, sizeof(wire)));
+
+    for(size_t len : { 0, 1, 7, 64, 200 })
+    {
+        std::string text = make_text(len, eightbit, conf.ctrl);
+        for(bool havemore : { false, true })
+        {
+            // The same packet be encoded.
+            char   rtpkt[TEXTALK_PKT_MAX_SIZE], pfpkt[TEXTALK_PKT_MAX_SIZE];
+            size_t rtsz = textalk_packet_encode(rtpkt, sizeof(rtpkt), text.data(), len, &conf, havemore);
+            size_t pfsz = Profile::Encode(pfpkt, sizeof(pfpkt), text.data(), len, havemore);
+            TEST_CHECK(rtsz);
+            TEST_CHECK_EQ(pfsz, rtsz);
+            TEST_CHECK_EQ(pfsz, len + Profile::overhead);
+            TEST_CHECK(!std::memcmp(pfpkt, rtpkt, rtsz));
+
+            TEST_CHECK_EQ(Profile::FindStart(rtpkt, rtsz), 0);
+            TEST_CHECK_EQ(Profile::FindEnd(rtpkt + 1, rtsz - 1), rtsz - 1);
+
+            // The same result be decoded from good, broken, and too long packets.
+            check_decode<Profile>(rtpkt, rtsz, sizeof(rtpkt));
+            check_decode<Profile>(rtpkt, rtsz, len);
+            for(size_t pos = 0; pos < rtsz; ++pos)
+            {
+                for(int bit = 0; bit < 8; ++bit)
+                {
+                    char bad[TEXTALK_PKT_MAX_SIZE];
+                    std::memcpy(bad, rtpkt, rtsz);
+                    bad[pos] ^= 1 << bit;
+                    check_decode<Profile>(bad, rtsz, sizeof(bad));
+                }
+            }
+        }
+    }
+
+    // An engine takes the codec only for the configuration of the profile.
+    textalk_engine_t engine;
+    TEST_CHECK_EQ(textalk_engine_init(&engine, &conf, 0), TEXTALK_ERR_SUCCESS);
+    TEST_CHECK_EQ(textalk_engine_set_codec(&engine, &Profile::codec), TEXTALK_ERR_SUCCESS);
+    textalk_engine_deinit(&engine);
+
+    conf.comm.have_lrc = !conf.comm.have_lrc;
+    TEST_CHECK(!Profile::Match(conf));
+    TEST_CHECK_EQ(textalk_engine_init(&engine, &conf, 0), TEXTALK_ERR_SUCCESS);
+    TEST_CHECK_EQ(textalk_engine_set_codec(&engine, &Profile::codec), TEXTALK_ERR_INVALID_ARG);
+    textalk_engine_deinit(&engine);
+}
+//------------------------------------------------------------------------------
+int main(void)
+{
+    test_profile< TTextalkProfile<TEXTALK_PARITY_NONE, true> >(true);
+    test_profile< TTextalkProfile<TEXTALK_PARITY_NONE, false> >(true);
+    test_profile< TTextalkProfile<TEXTALK_PARITY_ODD,  true> >(false);
+    test_profile< TTextalkProfile<TEXTALK_PARITY_EVEN, true> >(false);
+    test_profile< TTextalkProfile<TEXTALK_PARITY_EVEN, false> >(false);
+
+    // Control characters of another protocol.
+    typedef TTextalkCtrl<'{', '}', ']', '?', '+', '-', '.'> TBraces;
+    test_profile< TTextalkProfile<TEXTALK_PARITY_ODD, true, TBraces> >(false);
+
+    return 0;
+}
+//------------------------------------------------------------------------------
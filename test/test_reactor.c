@@ -0,0 +1,188 @@
+/*
+ * Drive sessions on socket pairs by a reactor.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "textalk_reactor.h"
+#include "test_util.h"
+
+#define LINE_COUNT 200
+
+typedef struct peer_t
+{
+    int                     fds[2];     // The end of the session, and the end of the test.
+    textalk_t               session;
+    textalk_reactor_t      *reactor;
+    textalk_reactor_line_t *line;
+    int                     done;       // Count of results reported.
+    int                     errcode;    // The last result.
+    bool                    remove;     // Remove the line when a result reported.
+} peer_t;
+
+//------------------------------------------------------------------------------
+static
+int peer_sender(peer_t *peer, const void *data, size_t size)
+{
+    ssize_t sendsz = write(peer->fds[0], data, size);
+    if( sendsz >= 0 ) return sendsz;
+    return ( errno == EAGAIN )?( 0 ):( -1 );
+}
+//------------------------------------------------------------------------------
+static
+int peer_recver(peer_t *peer, void *buf, size_t size)
+{
+    ssize_t recvsz = read(peer->fds[0], buf, size);
+    if( recvsz >= 0 ) return recvsz;
+    return ( errno == EAGAIN )?( 0 ):( -1 );
+}
+//------------------------------------------------------------------------------
+static
+void peer_on_done(peer_t *peer, textalk_t *session, int errcode)
+{
+    ++peer->done;
+    peer->errcode = errcode;
+
+    if( peer->remove )
+    {
+        textalk_reactor_remove(peer->reactor, peer->line);
+        peer->line = NULL;
+    }
+}
+//------------------------------------------------------------------------------
+static
+void peer_open(peer_t *peer, textalk_reactor_t *reactor, const textalk_conf_t *conf)
+{
+    TEST_CHECK(!socketpair(AF_UNIX, SOCK_STREAM, 0, peer->fds));
+    fcntl(peer->fds[0], F_SETFL, O_NONBLOCK);
+
+    textalk_events_t events =
+    {
+        .userarg = peer,
+        .sender  = (textalk_sender_t) peer_sender,
+        .recver  = (textalk_recver_t) peer_recver,
+    };
+    TEST_CHECK_EQ(textalk_init_ex(&peer->session, conf, &events, NULL), TEXTALK_ERR_SUCCESS);
+
+    peer->reactor = reactor;
+    peer->done    = 0;
+    peer->errcode = TEXTALK_ERR_GENERAL;
+    peer->remove  = false;
+    peer->line    = textalk_reactor_add(reactor,
+                                        &peer->session,
+                                        peer->fds[0],
+                                        (textalk_reactor_on_done_t) peer_on_done);
+    TEST_CHECK(peer->line);
+}
+//------------------------------------------------------------------------------
+static
+void peer_close(peer_t *peer)
+{
+    if( peer->line ) textalk_reactor_remove(peer->reactor, peer->line);
+    textalk_deinit(&peer->session);
+    close(peer->fds[0]);
+    if( peer->fds[1] >= 0 ) close(peer->fds[1]);
+}
+//------------------------------------------------------------------------------
+static
+void test_exchange_and_hangup(void)
+{
+    textalk_reactor_t reactor;
+    TEST_CHECK_EQ(textalk_reactor_init(&reactor), TEXTALK_ERR_SUCCESS);
+
+    peer_t peer;
+    peer_open(&peer, &reactor, textalk_conf_get_defaults());
+
+    // A text sent and acknowledged.
+    TEST_CHECK_EQ(textalk_reactor_send_text(&reactor, peer.line, "Hello", false), TEXTALK_ERR_SUCCESS);
+
+    char pkt[16];
+    TEST_CHECK_EQ(read(peer.fds[1], pkt, sizeof(pkt)), 8);
+    TEST_CHECK(!memcmp(pkt, "\x02" "Hello" "\x03", 7));
+    TEST_CHECK_EQ(write(peer.fds[1], "\x06", 1), 1);
+
+    for(int i = 0; i < 10 && !peer.done; ++i)
+        textalk_reactor_run_once(&reactor, 100);
+    TEST_CHECK_EQ(peer.done, 1);
+    TEST_CHECK_EQ(peer.errcode, TEXTALK_ERR_SUCCESS);
+
+    // The engine of the line counts into the session.
+    const textalk_stats_t *stats = textalk_get_stats(&peer.session);
+    TEST_CHECK_EQ(stats->tx_frames, 1);
+    TEST_CHECK_EQ(stats->tx_bytes, 8);
+    TEST_CHECK_EQ(stats->rx_bytes, 1);
+    TEST_CHECK_EQ(stats->rtt.total, 1);
+
+    // The remote closed, and the line is removed by its own callback.
+    peer.remove = true;
+    close(peer.fds[1]);
+    peer.fds[1] = -1;
+
+    textalk_reactor_run_once(&reactor, 100);
+    TEST_CHECK_EQ(peer.done, 2);
+    TEST_CHECK_EQ(peer.errcode, TEXTALK_ERR_STREAM_FAIL);
+    TEST_CHECK(!peer.line);
+    TEST_CHECK_EQ(reactor.linecount, 0);
+
+    // Nothing is ready any more, rather than the hang-up reported again and again.
+    TEST_CHECK_EQ(textalk_reactor_run_once(&reactor, 0), TEXTALK_ERR_SUCCESS);
+    TEST_CHECK_EQ(peer.done, 2);
+
+    peer_close(&peer);
+    textalk_reactor_deinit(&reactor);
+}
+//------------------------------------------------------------------------------
+static
+void test_many_timers(void)
+{
+    textalk_reactor_t reactor;
+    TEST_CHECK_EQ(textalk_reactor_init(&reactor), TEXTALK_ERR_SUCCESS);
+
+    textalk_conf_t conf = *textalk_conf_get_defaults();
+    conf.comm.retry_max    = 1;
+    conf.comm.timeout.echo = 20;
+
+    // Texts are never answered, and each line times out twice at its own time.
+    static peer_t peers[LINE_COUNT];
+    for(int i = 0; i < LINE_COUNT; ++i)
+    {
+        peer_open(&peers[i], &reactor, &conf);
+        peers[i].remove = ( i % 2 );
+        TEST_CHECK_EQ(textalk_reactor_send_text(&reactor, peers[i].line, "Hello", false), TEXTALK_ERR_SUCCESS);
+    }
+
+    int done = 0;
+    for(int round = 0; round < 100 && done < LINE_COUNT; ++round)
+    {
+        textalk_reactor_run_once(&reactor, 50);
+
+        done = 0;
+        for(int i = 0; i < LINE_COUNT; ++i)
+            done += peers[i].done;
+    }
+
+    TEST_CHECK_EQ(done, LINE_COUNT);
+    TEST_CHECK_EQ(reactor.linecount, LINE_COUNT / 2);
+    TEST_CHECK_EQ(reactor.timercount, 0);
+    for(int i = 0; i < LINE_COUNT; ++i)
+    {
+        TEST_CHECK_EQ(peers[i].errcode, TEXTALK_ERR_TIMEOUT);
+        TEST_CHECK_EQ(textalk_get_stats(&peers[i].session)->timeout_echo, 2);
+        TEST_CHECK_EQ(textalk_get_stats(&peers[i].session)->retries, 1);
+    }
+
+    for(int i = 0; i < LINE_COUNT; ++i)
+        peer_close(&peers[i]);
+    textalk_reactor_deinit(&reactor);
+}
+//------------------------------------------------------------------------------
+int main(void)
+{
+    test_exchange_and_hangup();
+    test_many_timers();
+
+    return 0;
+}
+//------------------------------------------------------------------------------
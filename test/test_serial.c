@@ -0,0 +1,143 @@
+/*
+ * Run two sessions against each other on a pseudo terminal loopback.
+ */
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "textalk.h"
+#include "textalk_serial.h"
+#include "test_util.h"
+
+static const char *texts[] =
+{
+    "The first text",
+    "A text with more parts",
+    "",
+    "The last text of the round",
+};
+#define TEXT_COUNT ( sizeof(texts) / sizeof(texts[0]) )
+
+typedef struct peer_t
+{
+    textalk_serial_t serial;
+    textalk_t        session;
+    int              results[TEXT_COUNT];
+} peer_t;
+
+//------------------------------------------------------------------------------
+static
+void* sender_thread(peer_t *peer)
+{
+    for(size_t i = 0; i < TEXT_COUNT; ++i)
+        peer->results[i] = textalk_send_text(&peer->session, texts[i], i + 1 < TEXT_COUNT);
+
+    return NULL;
+}
+//------------------------------------------------------------------------------
+static
+void run_exchange(int parity, bool vectored)
+{
+    peer_t master, slave;
+    textalk_serial_init(&master.serial);
+    textalk_serial_init(&slave.serial);
+    TEST_CHECK_EQ(textalk_serial_open_loopback(&master.serial, &slave.serial), TEXTALK_ERR_SUCCESS);
+
+    textalk_conf_t conf = *textalk_conf_get_defaults();
+    conf.comm.parity = parity;
+
+    textalk_events_t events = {0};
+    textalk_serial_fill_events(&master.serial, &events);
+    if( !vectored ) events.sendv = NULL;
+    TEST_CHECK_EQ(textalk_init_ex(&master.session, &conf, &events, NULL), TEXTALK_ERR_SUCCESS);
+
+    textalk_serial_fill_events(&slave.serial, &events);
+    TEST_CHECK_EQ(textalk_init_ex(&slave.session, &conf, &events, NULL), TEXTALK_ERR_SUCCESS);
+
+    // Data would be cut by ETX or ETB inside, and be refused before anything sent.
+    TEST_CHECK_EQ(textalk_send_data(&master.session, "A\x03" "B", 3, false), TEXTALK_ERR_INVALID_ARG);
+    TEST_CHECK_EQ(textalk_send_message(&master.session, "A\x17" "B", 3), TEXTALK_ERR_INVALID_ARG);
+
+    pthread_t thread;
+    TEST_CHECK(!pthread_create(&thread, NULL, (void*(*)(void*)) sender_thread, &master));
+
+    for(size_t i = 0; i < TEXT_COUNT; ++i)
+    {
+        char   buf[TEXTALK_PKT_MAX_SIZE];
+        size_t len = 0;
+        int    res = textalk_wait_data(&slave.session, buf, sizeof(buf), &len);
+
+        TEST_CHECK_EQ(res, i + 1 < TEXT_COUNT ? TEXTALK_ERR_HAVE_MORE : TEXTALK_ERR_SUCCESS);
+        TEST_CHECK_EQ(len, strlen(texts[i]));
+        TEST_CHECK(!strcmp(buf, texts[i]));
+    }
+
+    pthread_join(thread, NULL);
+    for(size_t i = 0; i < TEXT_COUNT; ++i)
+        TEST_CHECK_EQ(master.results[i], TEXTALK_ERR_SUCCESS);
+
+    // Nothing more on the line, and the receiver gives up in time.
+    slave.session.conf.comm.timeout.resp = 50;
+    slave.session.conf.comm.retry_max    = 0;
+    char buf[16];
+    TEST_CHECK_EQ(textalk_wait_text(&slave.session, buf, sizeof(buf)), TEXTALK_ERR_TIMEOUT);
+
+    textalk_deinit(&master.session);
+    textalk_deinit(&slave.session);
+    textalk_serial_deinit(&master.serial);
+    textalk_serial_deinit(&slave.serial);
+}
+//------------------------------------------------------------------------------
+static
+unsigned now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+//------------------------------------------------------------------------------
+static
+void test_hangup(void)
+{
+    // A hung-up line reads nothing forever,
+    // and the receiver should fail at once instead of spinning until its time-out.
+    int fds[2];
+    TEST_CHECK(!pipe(fds));
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    close(fds[1]);
+
+    textalk_serial_t serial;
+    textalk_serial_init(&serial);
+    serial.fd = fds[0];
+
+    textalk_conf_t conf = *textalk_conf_get_defaults();
+    conf.comm.timeout.resp = 2000;
+    conf.comm.retry_max    = 0;
+
+    textalk_events_t events = {0};
+    textalk_serial_fill_events(&serial, &events);
+
+    textalk_t session;
+    TEST_CHECK_EQ(textalk_init_ex(&session, &conf, &events, NULL), TEXTALK_ERR_SUCCESS);
+
+    char     buf[16];
+    unsigned start = now_ms();
+    TEST_CHECK_EQ(textalk_wait_text(&session, buf, sizeof(buf)), TEXTALK_ERR_STREAM_FAIL);
+    TEST_CHECK(now_ms() - start < conf.comm.timeout.resp / 2);
+
+    textalk_deinit(&session);
+    textalk_serial_deinit(&serial);
+}
+//------------------------------------------------------------------------------
+int main(void)
+{
+    run_exchange(TEXTALK_PARITY_NONE, false);
+    run_exchange(TEXTALK_PARITY_NONE, true);
+    run_exchange(TEXTALK_PARITY_ODD,  false);
+    run_exchange(TEXTALK_PARITY_EVEN, true);
+    test_hangup();
+
+    return 0;
+}
+//------------------------------------------------------------------------------
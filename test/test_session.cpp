@@ -0,0 +1,105 @@
+/*
+ * Receive a message of several blocks through the C++ session class.
+ */
+#include <cstring>
+#include <string>
+#include "textalk.h"
+#include "textalk_packet.h"
+#include "test_util.h"
+
+//------------------------------------------------------------------------------
+class TScriptedSession : public TTextalkSession<TScriptedSession>
+{
+public:
+    std::string input;      // Data to be received.
+    std::string echoes;     // Control codes sent back.
+
+public:
+    TScriptedSession(const textalk_conf_t &conf) : TTextalkSession(conf) {}
+
+    void PutPacket(const textalk_conf_t &conf, const char *text, bool havemore)
+    {
+        char   pkt[TEXTALK_PKT_MAX_SIZE];
+        size_t size = textalk_packet_encode(pkt, sizeof(pkt), text, std::strlen(text), &conf, havemore);
+        TEST_CHECK(size);
+
+        input.append(pkt, size);
+    }
+
+    int Sender(const void *data, size_t size)
+    {
+        echoes.append((const char*) data, size);
+        return size;
+    }
+
+    int Receiver(void *buf, size_t size)
+    {
+        size_t recvsz = ( input.size() < size )?( input.size() ):( size );
+        input.copy((char*) buf, recvsz);
+        input.erase(0, recvsz);
+
+        return recvsz;
+    }
+};
+//------------------------------------------------------------------------------
+static
+void test_wait_text(const textalk_conf_t &conf)
+{
+    TScriptedSession session(conf);
+    TEST_CHECK(session.IsValid());
+    session.PutPacket(conf, "First", true);
+    session.PutPacket(conf, "Second", true);
+    session.PutPacket(conf, "Last", false);
+
+    char             buf[64];
+    std::string_view text;
+    TEST_CHECK_EQ(session.WaitText(buf, text), TEXTALK_ERR_HAVE_MORE);
+    TEST_CHECK(text == "First");
+    TEST_CHECK_EQ(session.WaitText(buf, text), TEXTALK_ERR_HAVE_MORE);
+    TEST_CHECK(text == "Second");
+    TEST_CHECK_EQ(session.WaitText(buf, text), TEXTALK_ERR_SUCCESS);
+    TEST_CHECK(text == "Last");
+
+    TEST_CHECK_EQ(session.echoes.size(), 3);
+    TEST_CHECK(session.echoes.find_first_not_of(conf.ctrl.ack) == std::string::npos);
+
+    // A failed receive gives an empty text.
+    TEST_CHECK_EQ(session.WaitText(buf, text), TEXTALK_ERR_TIMEOUT);
+    TEST_CHECK(text.empty());
+}
+//------------------------------------------------------------------------------
+static
+void test_wait_span(const textalk_conf_t &conf)
+{
+#ifdef __cpp_lib_span
+    TScriptedSession session(conf);
+    session.PutPacket(conf, "Head", true);
+    session.PutPacket(conf, "Tail", false);
+
+    std::byte            buf[64];
+    std::span<std::byte> data;
+    TEST_CHECK_EQ(session.WaitData(buf, data), TEXTALK_ERR_HAVE_MORE);
+    TEST_CHECK_EQ(data.size(), 4);
+    TEST_CHECK(!std::memcmp(data.data(), "Head", 4));
+    TEST_CHECK_EQ(session.WaitData(buf, data), TEXTALK_ERR_SUCCESS);
+    TEST_CHECK_EQ(data.size(), 4);
+    TEST_CHECK(!std::memcmp(data.data(), "Tail", 4));
+#endif
+}
+//------------------------------------------------------------------------------
+int main(void)
+{
+    textalk_conf_t conf = *textalk_conf_get_defaults();
+    conf.comm.timeout.resp = 10;
+    conf.comm.retry_max    = 0;
+
+    test_wait_text(conf);
+    test_wait_span(conf);
+
+    conf.comm.parity = TEXTALK_PARITY_EVEN;
+    test_wait_text(conf);
+    test_wait_span(conf);
+
+    return 0;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,108 @@
+/*
+ * Overwrite records of a trace ring, and read them while being written.
+ */
+#include <pthread.h>
+#include "textalk_errcode.h"
+#include "textalk_trace.h"
+#include "test_util.h"
+
+#define RING_SIZE   16
+#define WRITE_COUNT 2000000
+
+//------------------------------------------------------------------------------
+static
+void put_records(textalk_trace_t *trace, unsigned count)
+{
+    // Fields of each record are derived from its sequence, to find records torn.
+    for(unsigned i = 0; i < count; ++i)
+    {
+        uint32_t seq = textalk_trace_get_head(trace);
+        textalk_trace_put(trace, seq, TEXTALK_TRACE_SEND_FRAME, 0, seq * 7u, 0);
+    }
+}
+//------------------------------------------------------------------------------
+static
+void check_records(const textalk_trace_rec_t *recs, size_t count, uint32_t first)
+{
+    for(size_t i = 0; i < count; ++i)
+    {
+        TEST_CHECK_EQ(recs[i].seq, (uint32_t)( first + i ));
+        TEST_CHECK_EQ(recs[i].time, recs[i].seq);
+        TEST_CHECK_EQ(recs[i].len, recs[i].seq * 7u);
+        TEST_CHECK_EQ(recs[i].type, TEXTALK_TRACE_SEND_FRAME);
+    }
+}
+//------------------------------------------------------------------------------
+static
+void test_overwrite(uint32_t start)
+{
+    textalk_trace_rec_t ring[RING_SIZE];
+    textalk_trace_t     trace;
+    TEST_CHECK_EQ(textalk_trace_init(&trace, ring, RING_SIZE - 1), TEXTALK_ERR_INVALID_ARG);
+    TEST_CHECK_EQ(textalk_trace_init(&trace, ring, RING_SIZE), TEXTALK_ERR_SUCCESS);
+    trace.head = start;     // Start near the wrap of sequences if required.
+
+    textalk_trace_rec_t recs[RING_SIZE];
+    uint32_t            cursor = start;
+
+    // Records not overwritten are all read.
+    put_records(&trace, 5);
+    TEST_CHECK_EQ(textalk_trace_read(&trace, &cursor, recs, RING_SIZE), 5);
+    check_records(recs, 5, start);
+    TEST_CHECK_EQ(cursor, (uint32_t)( start + 5 ));
+    TEST_CHECK_EQ(textalk_trace_read(&trace, &cursor, recs, RING_SIZE), 0);
+
+    // Records overwritten are skipped, and the oldest ones left are read,
+    // except the oldest one that shares its place with the next record to be written.
+    put_records(&trace, 20);
+    TEST_CHECK_EQ(textalk_trace_read(&trace, &cursor, recs, 4), 3);
+    check_records(recs, 3, start + 25 - RING_SIZE + 1);
+    TEST_CHECK_EQ(textalk_trace_read(&trace, &cursor, recs, RING_SIZE), RING_SIZE - 4);
+    check_records(recs, RING_SIZE - 4, start + 25 - RING_SIZE + 4);
+    TEST_CHECK_EQ(cursor, textalk_trace_get_head(&trace));
+}
+//------------------------------------------------------------------------------
+static
+void* writer_thread(textalk_trace_t *trace)
+{
+    put_records(trace, WRITE_COUNT);
+    return NULL;
+}
+//------------------------------------------------------------------------------
+static
+void test_read_while_writing(void)
+{
+    textalk_trace_rec_t ring[RING_SIZE];
+    textalk_trace_t     trace;
+    TEST_CHECK_EQ(textalk_trace_init(&trace, ring, RING_SIZE), TEXTALK_ERR_SUCCESS);
+
+    pthread_t thread;
+    TEST_CHECK(!pthread_create(&thread, NULL, (void*(*)(void*)) writer_thread, &trace));
+
+    // Records read are never torn, and always in order.
+    textalk_trace_rec_t recs[RING_SIZE];
+    uint32_t            cursor = 0;
+    size_t              total  = 0;
+    while( cursor != WRITE_COUNT )
+    {
+        size_t count = textalk_trace_read(&trace, &cursor, recs, RING_SIZE);
+        if( !count ) continue;
+
+        check_records(recs, count, cursor - count);
+        total += count;
+    }
+
+    pthread_join(thread, NULL);
+    TEST_CHECK(total > 0);
+    TEST_CHECK(total <= WRITE_COUNT);
+}
+//------------------------------------------------------------------------------
+int main(void)
+{
+    test_overwrite(0);
+    test_overwrite(UINT32_MAX - 10);
+    test_read_while_writing();
+
+    return 0;
+}
+//------------------------------------------------------------------------------
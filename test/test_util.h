@@ -0,0 +1,38 @@
+/*
+ * Common utility of tests.
+ */
+#ifndef _TEST_UTIL_H_
+#define _TEST_UTIL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Check a condition, and terminate the test with the place failed if it is FALSE.
+ */
+#define TEST_CHECK(cond)                                                        \
+    do                                                                          \
+    {                                                                           \
+        if( !(cond) )                                                           \
+        {                                                                       \
+            fprintf(stderr, "%s:%d: Check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                            \
+        }                                                                       \
+    } while(0)
+
+/*
+ * Check two integers be equal, and print both values if not.
+ */
+#define TEST_CHECK_EQ(a, b)                                                     \
+    do                                                                          \
+    {                                                                           \
+        long long _a = (long long)(a), _b = (long long)(b);                     \
+        if( _a != _b )                                                          \
+        {                                                                       \
+            fprintf(stderr, "%s:%d: Check failed: %s == %s (%lld != %lld)\n",   \
+                    __FILE__, __LINE__, #a, #b, _a, _b);                        \
+            exit(1);                                                            \
+        }                                                                       \
+    } while(0)
+
+#endif
@@ -0,0 +1,182 @@
+/*
+ * Send messages in window mode on a simulated link,
+ * with the first block of an exchange corrupted on the way;
+ * and receive data arrived after the time-out expired.
+ */
+#include <pthread.h>
+#include <string.h>
+#include "textalk.h"
+#include "textalk_packet.h"
+#include "textalk_simlink.h"
+#include "test_util.h"
+
+#define MESSAGE_SIZE  200
+#define MESSAGE_COUNT 3
+
+typedef struct sender_t
+{
+    textalk_t session;
+    int       corrupt_at;   // Place of the character to be corrupted in the first packet, or -1.
+    int       packets;      // Count of packets sent.
+    int       results[MESSAGE_COUNT];
+} sender_t;
+
+static sender_t sender;
+static char     messages[MESSAGE_COUNT][MESSAGE_SIZE];
+
+//------------------------------------------------------------------------------
+static
+int corrupting_sender(void *userarg, const void *data, size_t size)
+{
+    // Packets are sent by one call each, and only the first one be corrupted.
+    char pkt[TEXTALK_PKT_MAX_SIZE];
+    if( sender.packets++ == 0 && sender.corrupt_at >= 0 && (size_t) sender.corrupt_at < size )
+    {
+        memcpy(pkt, data, size);
+        pkt[ sender.corrupt_at ] ^= 0x01;
+        data = pkt;
+    }
+
+    return textalk_simlink_sender(userarg, data, size);
+}
+//------------------------------------------------------------------------------
+static
+void* sender_thread(textalk_simlink_t *link)
+{
+    for(int i = 0; i < MESSAGE_COUNT; ++i)
+        sender.results[i] = textalk_send_message(&sender.session, messages[i], MESSAGE_SIZE);
+
+    textalk_simlink_detach(link, 0);
+    return NULL;
+}
+//------------------------------------------------------------------------------
+static
+void run_exchange(int corrupt_at)
+{
+    textalk_conf_t conf = *textalk_conf_get_defaults();
+    conf.comm.window    = 4;
+    conf.comm.frame_max = 64;
+
+    textalk_simlink_conf_t linkconf = { .baudrate = 9600 };
+    textalk_simlink_t      link;
+    textalk_simlink_init(&link, &linkconf, &linkconf);
+
+    textalk_events_t events = {0};
+    textalk_simlink_attach(&link, 0, &events);
+    events.sender = corrupting_sender;
+    TEST_CHECK_EQ(textalk_init_ex(&sender.session, &conf, &events, NULL), TEXTALK_ERR_SUCCESS);
+    sender.corrupt_at = corrupt_at;
+    sender.packets    = 0;
+
+    textalk_t recver;
+    memset(&events, 0, sizeof(events));
+    textalk_simlink_attach(&link, 1, &events);
+    TEST_CHECK_EQ(textalk_init_ex(&recver, &conf, &events, NULL), TEXTALK_ERR_SUCCESS);
+
+    for(int i = 0; i < MESSAGE_COUNT; ++i)
+    {
+        for(int j = 0; j < MESSAGE_SIZE; ++j)
+            messages[i][j] = 'A' + ( i * 7 + j ) % 26;
+    }
+
+    pthread_t thread;
+    TEST_CHECK(!pthread_create(&thread, NULL, (void*(*)(void*)) sender_thread, &link));
+
+    char  *buf     = NULL;
+    size_t bufsize = 0;
+    for(int i = 0; i < MESSAGE_COUNT; ++i)
+    {
+        size_t len = 0;
+        TEST_CHECK_EQ(textalk_recv_message(&recver, &buf, &bufsize, &len), TEXTALK_ERR_SUCCESS);
+        TEST_CHECK_EQ(len, MESSAGE_SIZE);
+        TEST_CHECK(!memcmp(buf, messages[i], MESSAGE_SIZE));
+    }
+    free(buf);
+
+    // Let the last echo go, and the sender finishes by itself.
+    textalk_simlink_detach(&link, 1);
+    pthread_join(thread, NULL);
+    for(int i = 0; i < MESSAGE_COUNT; ++i)
+        TEST_CHECK_EQ(sender.results[i], TEXTALK_ERR_SUCCESS);
+
+    textalk_deinit(&sender.session);
+    textalk_deinit(&recver);
+    textalk_simlink_deinit(&link);
+}
+//------------------------------------------------------------------------------
+typedef struct late_link_t
+{
+    char     pkt[TEXTALK_PKT_MAX_SIZE];
+    size_t   pktsz;
+    unsigned now;
+    char     echo;
+} late_link_t;
+//------------------------------------------------------------------------------
+static
+unsigned late_clock(late_link_t *link)
+{
+    // Every reading of the clock be later than any time-out.
+    return link->now += 100000;
+}
+//------------------------------------------------------------------------------
+static
+int late_sender(late_link_t *link, const void *data, size_t size)
+{
+    link->echo = ((const char*) data)[ size - 1 ];
+    return size;
+}
+//------------------------------------------------------------------------------
+static
+int late_recver(late_link_t *link, void *buf, size_t size)
+{
+    // The whole packet comes at once, but only after the wait begins.
+    size_t recvsz = ( link->pktsz < size )?( link->pktsz ):( size );
+    memcpy(buf, link->pkt, recvsz);
+    link->pktsz -= recvsz;
+    memmove(link->pkt, link->pkt + recvsz, link->pktsz);
+
+    return recvsz;
+}
+//------------------------------------------------------------------------------
+static
+void test_late_data(void)
+{
+    textalk_conf_t conf = *textalk_conf_get_defaults();
+
+    late_link_t link = {0};
+    link.pktsz = textalk_packet_encode(link.pkt, sizeof(link.pkt), "Late", 4, &conf, false);
+    TEST_CHECK(link.pktsz);
+
+    textalk_events_t events =
+    {
+        .userarg = &link,
+        .sender  = (textalk_sender_t) late_sender,
+        .recver  = (textalk_recver_t) late_recver,
+        .clock   = (textalk_clock_t) late_clock,
+    };
+    textalk_t session;
+    TEST_CHECK_EQ(textalk_init_ex(&session, &conf, &events, NULL), TEXTALK_ERR_SUCCESS);
+
+    char text[16];
+    TEST_CHECK_EQ(textalk_wait_text(&session, text, sizeof(text)), TEXTALK_ERR_SUCCESS);
+    TEST_CHECK(!strcmp(text, "Late"));
+    TEST_CHECK_EQ(link.echo, conf.ctrl.ack);
+
+    // Nothing more to read, and the time-out be reported.
+    TEST_CHECK_EQ(textalk_wait_text(&session, text, sizeof(text)), TEXTALK_ERR_TIMEOUT);
+
+    textalk_deinit(&session);
+}
+//------------------------------------------------------------------------------
+int main(void)
+{
+    run_exchange(-1);   // No error.
+    run_exchange(5);    // The text of the first block, with its sequence kept.
+    run_exchange(1);    // The sequence of the first block.
+    run_exchange(0);    // STX of the first block.
+
+    test_late_data();
+
+    return 0;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,187 @@
+/*
+ * Decode frames in a raw serial capture.
+ *
+ * The capture is the bytes of a line as they were received,
+ * and frames found are summarised, listed, or written to an index file
+ * (see textalk_capture_index_head_t).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "textalk_capture.h"
+
+//------------------------------------------------------------------------------
+static
+void print_usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [OPTION]... FILE\n", name);
+    fprintf(stderr, "Decode frames in the raw serial capture FILE.\n");
+    fprintf(stderr, "  -j NUM     Count of worker threads (default: one per processor).\n");
+    fprintf(stderr, "  -p PARITY  Parity of the line: none, odd, or even (default: none).\n");
+    fprintf(stderr, "  -n         Packets have no LRC.\n");
+    fprintf(stderr, "  -m SIZE    The maximum size of a packet.\n");
+    fprintf(stderr, "  -o INDEX   Write frames to the index file INDEX.\n");
+    fprintf(stderr, "  -l         List frames with their texts.\n");
+}
+//------------------------------------------------------------------------------
+static
+const char* status_name(int status)
+{
+    switch( status )
+    {
+    case TEXTALK_CAPTURE_OK:         return "ok";
+    case TEXTALK_CAPTURE_BAD_PARITY: return "bad-parity";
+    case TEXTALK_CAPTURE_BAD_LRC:    return "bad-lrc";
+    case TEXTALK_CAPTURE_TOO_LONG:   return "too-long";
+    case TEXTALK_CAPTURE_TRUNCATED:  return "truncated";
+    default:                         return "unknown";
+    }
+}
+//------------------------------------------------------------------------------
+static
+const char* echo_name(const textalk_conf_t *conf, char echo)
+{
+    if( !echo )                  return "-";
+    if( echo == conf->ctrl.ack ) return "ACK";
+    if( echo == conf->ctrl.nak ) return "NAK";
+    if( echo == conf->ctrl.eot ) return "EOT";
+    return "?";
+}
+//------------------------------------------------------------------------------
+static
+void list_frames(const textalk_capture_t *capture, const textalk_conf_t *conf)
+{
+    size_t                         count;
+    const textalk_capture_frame_t *frames = textalk_capture_get_frames(capture, &count);
+
+    printf("%12s %6s %-10s %-4s %s\n", "offset", "size", "status", "echo", "text");
+
+    size_t textsz = conf->comm.frame_max ? conf->comm.frame_max : TEXTALK_PKT_MAX_SIZE;
+    char  *text   = malloc(textsz);
+    for(size_t i = 0; i < count; ++i)
+    {
+        const textalk_capture_frame_t *frame = &frames[i];
+
+        bool havetext = text && textalk_capture_get_text(capture, frame, conf, text, textsz);
+        printf("%12llu %6u %-10s %-4s %s%s\n",
+               (unsigned long long) frame->offset,
+               (unsigned) frame->size,
+               status_name(frame->status),
+               echo_name(conf, frame->echo),
+               havetext ? text : "",
+               frame->havemore ? " (ETB)" : "");
+    }
+    free(text);
+}
+//------------------------------------------------------------------------------
+static
+void print_summary(const textalk_capture_t *capture)
+{
+    size_t                         count;
+    const textalk_capture_frame_t *frames = textalk_capture_get_frames(capture, &count);
+
+    size_t stats[TEXTALK_CAPTURE_TRUNCATED+1] = {0};
+    for(size_t i = 0; i < count; ++i)
+    {
+        if( frames[i].status <= TEXTALK_CAPTURE_TRUNCATED )
+            ++stats[ frames[i].status ];
+    }
+
+    printf("frames:     %zu\n", count);
+    for(int status = TEXTALK_CAPTURE_OK; status <= TEXTALK_CAPTURE_TRUNCATED; ++status)
+        printf("%-11s %zu\n", status_name(status), stats[status]);
+}
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    textalk_conf_t conf    = *textalk_conf_get_defaults();
+    unsigned       threads = 0;
+    const char    *index   = NULL;
+    bool           list    = false;
+
+    int opt;
+    while( ( opt = getopt(argc, argv, "j:p:nm:o:lh") ) != -1 )
+    {
+        switch( opt )
+        {
+        case 'j':
+            threads = atoi(optarg);
+            break;
+
+        case 'p':
+            if( !strcmp(optarg, "none") )
+                conf.comm.parity = TEXTALK_PARITY_NONE;
+            else if( !strcmp(optarg, "odd") )
+                conf.comm.parity = TEXTALK_PARITY_ODD;
+            else if( !strcmp(optarg, "even") )
+                conf.comm.parity = TEXTALK_PARITY_EVEN;
+            else
+            {
+                print_usage(argv[0]);
+                return 1;
+            }
+            break;
+
+        case 'n':
+            conf.comm.have_lrc = false;
+            break;
+
+        case 'm':
+            conf.comm.frame_max = atoi(optarg);
+            break;
+
+        case 'o':
+            index = optarg;
+            break;
+
+        case 'l':
+            list = true;
+            break;
+
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if( optind + 1 != argc )
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    textalk_capture_t capture;
+    if( textalk_capture_open(&capture, argv[optind]) )
+    {
+        perror(argv[optind]);
+        textalk_capture_close(&capture);
+        return 1;
+    }
+
+    int res = 0;
+    if( textalk_capture_decode(&capture, &conf, threads) )
+    {
+        fprintf(stderr, "%s: Decode failed!\n", argv[optind]);
+        res = 1;
+    }
+    else
+    {
+        if( list )
+            list_frames(&capture, &conf);
+        else
+            print_summary(&capture);
+
+        FILE *file = index ? fopen(index, "wb") : NULL;
+        if( index && ( !file || textalk_capture_write_index(&capture, file) ) )
+        {
+            perror(index);
+            res = 1;
+        }
+        if( file ) fclose(file);
+    }
+
+    textalk_capture_close(&capture);
+    return res;
+}
+//------------------------------------------------------------------------------
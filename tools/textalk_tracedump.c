@@ -0,0 +1,59 @@
+/*
+ * Print records of a protocol trace as text.
+ *
+ * The input is an array of textalk_trace_rec_t in the byte order of the host,
+ * as they are read by textalk_trace_read and written to a file directly.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "textalk_trace.h"
+
+//------------------------------------------------------------------------------
+static
+void print_usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [FILE]\n", name);
+    fprintf(stderr, "Print protocol trace records in FILE, or in the standard input if no FILE.\n");
+}
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    if( argc > 2 || ( argc == 2 && !strcmp(argv[1], "--help") ) )
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    FILE *file = ( argc == 2 )?( fopen(argv[1], "rb") ):( stdin );
+    if( !file )
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    printf("%10s %10s %-12s\n", "seq", "time(ms)", "type");
+
+    textalk_trace_rec_t rec;
+    unsigned            prevseq  = 0;
+    unsigned            prevtime = 0;
+    unsigned long       count    = 0;
+    while( fread(&rec, sizeof(rec), 1, file) == 1 )
+    {
+        if( count && rec.seq != prevseq + 1 )
+            printf("... %u records lost ...\n", (unsigned)( rec.seq - prevseq - 1 ));
+
+        char line[128];
+        textalk_trace_format(&rec, line, sizeof(line));
+        printf("%s (+%u ms)\n", line, count ? (unsigned)( rec.time - prevtime ) : 0);
+
+        prevseq  = rec.seq;
+        prevtime = rec.time;
+        ++count;
+    }
+
+    int res = ferror(file) ? 1 : 0;
+    if( file != stdin ) fclose(file);
+
+    return res;
+}
+//------------------------------------------------------------------------------